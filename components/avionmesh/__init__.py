@@ -1,7 +1,7 @@
 """ESPHome external component for Avi-on BLE mesh lights (C++20).
 
-Auto-scans for Avi-on bridges and connects to the one with the best RSSI.
-Reconnects automatically on disconnect.
+Auto-scans for Avi-on bridges and connects to the strongest ones (up to
+max_bridges at once). Reconnects automatically on disconnect.
 """
 
 import base64
@@ -19,6 +19,18 @@ DEPENDENCIES = ["esp32", "mqtt"]
 AUTO_LOAD = ["json", "esp32_ble", "web_server_base"]
 
 CONF_PASSPHRASE = "passphrase"
+CONF_ACK_RETRIES = "ack_retries"
+CONF_MAX_BRIDGES = "max_bridges"
+CONF_STATE_REFRESH_INTERVAL = "state_refresh_interval"
+CONF_STATE_REFRESH_BUDGET = "state_refresh_budget"
+CONF_AIRTIME_BUDGET = "airtime_budget"
+CONF_TARGET_RATE_LIMIT = "target_rate_limit"
+CONF_TARGET_RATE_BURST = "target_rate_burst"
+CONF_INGRESS_RATE_LIMIT = "ingress_rate_limit"
+CONF_INGRESS_RATE_BURST = "ingress_rate_burst"
+CONF_MQTT_JSON_SCHEMA = "mqtt_json_schema"
+CONF_MQTT_DEVICE_DISCOVERY = "mqtt_device_discovery"
+CONF_MQTT_DISCOVERY_CHUNK_SIZE = "mqtt_discovery_chunk_size"
 
 
 def validate_passphrase(value):
@@ -62,6 +74,20 @@ CONFIG_SCHEMA = cv.Schema(
         cv.GenerateID(): cv.declare_id(AvionMeshHub),
         cv.GenerateID(esp32_ble.CONF_BLE_ID): cv.use_id(esp32_ble.ESP32BLE),
         cv.Optional(CONF_PASSPHRASE): validate_passphrase,
+        cv.Optional(CONF_ACK_RETRIES, default=2): cv.int_range(min=0, max=5),
+        cv.Optional(CONF_MAX_BRIDGES, default=2): cv.int_range(min=1, max=3),
+        cv.Optional(
+            CONF_STATE_REFRESH_INTERVAL, default="60s"
+        ): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_STATE_REFRESH_BUDGET, default=2.0): cv.float_range(min=0.2, max=10.0),
+        cv.Optional(CONF_AIRTIME_BUDGET, default=15.0): cv.float_range(min=0.0, max=100.0),
+        cv.Optional(CONF_TARGET_RATE_LIMIT, default=5.0): cv.float_range(min=0.0, max=50.0),
+        cv.Optional(CONF_TARGET_RATE_BURST, default=10): cv.int_range(min=1, max=100),
+        cv.Optional(CONF_INGRESS_RATE_LIMIT, default=20.0): cv.float_range(min=0.0, max=200.0),
+        cv.Optional(CONF_INGRESS_RATE_BURST, default=40): cv.int_range(min=1, max=400),
+        cv.Optional(CONF_MQTT_JSON_SCHEMA, default=False): cv.boolean,
+        cv.Optional(CONF_MQTT_DEVICE_DISCOVERY, default=False): cv.boolean,
+        cv.Optional(CONF_MQTT_DISCOVERY_CHUNK_SIZE, default=4096): cv.int_range(min=1024, max=65536),
     }
 ).extend(cv.COMPONENT_SCHEMA)
 
@@ -78,6 +104,16 @@ async def to_code(config):
     # Passphrase is now optional - stored in NVS instead of config
     if CONF_PASSPHRASE in config:
         cg.add(var.set_passphrase(config[CONF_PASSPHRASE]))
+    cg.add(var.set_ack_retries(config[CONF_ACK_RETRIES]))
+    cg.add(var.set_max_bridges(config[CONF_MAX_BRIDGES]))
+    cg.add(var.set_state_refresh_interval(config[CONF_STATE_REFRESH_INTERVAL]))
+    cg.add(var.set_state_refresh_budget(config[CONF_STATE_REFRESH_BUDGET]))
+    cg.add(var.set_airtime_budget(config[CONF_AIRTIME_BUDGET]))
+    cg.add(var.set_target_rate_limit(config[CONF_TARGET_RATE_LIMIT], config[CONF_TARGET_RATE_BURST]))
+    cg.add(var.set_ingress_rate_limit(config[CONF_INGRESS_RATE_LIMIT], config[CONF_INGRESS_RATE_BURST]))
+    cg.add(var.set_mqtt_json_schema(config[CONF_MQTT_JSON_SCHEMA]))
+    cg.add(var.set_mqtt_device_discovery(config[CONF_MQTT_DEVICE_DISCOVERY]))
+    cg.add(var.set_mqtt_discovery_chunk_size(config[CONF_MQTT_DISCOVERY_CHUNK_SIZE]))
 
     # Download libraries via lib_deps (compiled via fix_cmake.py for ESP-IDF)
     cg.add_platformio_option("lib_deps", [
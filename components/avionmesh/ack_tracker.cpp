@@ -0,0 +1,129 @@
+#include "ack_tracker.h"
+
+#include "esphome/core/log.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace avionmesh {
+
+static const char *TAG = "avionmesh.ack";
+
+void AckTracker::track(uint16_t target, AckAttr attr, uint16_t value, const Command &cmd,
+                       std::vector<uint16_t> members, uint32_t now) {
+    auto it = entries_.find(key_(target, attr));
+    if (it != entries_.end()) {
+        stats_.superseded++;
+        entries_.erase(it);
+    }
+    stats_.tracked++;
+    uint32_t timeout = base_timeout_(target, members);
+    entries_[key_(target, attr)] = {cmd, value, std::move(members), now, timeout,
+                                    now + backoff_(timeout, 0), 0};
+}
+
+void AckTracker::on_report(uint16_t avid, AckAttr attr, uint16_t value, uint32_t now) {
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        auto cur = it++;
+        if (static_cast<AckAttr>(cur->first & 0xFF) != attr || cur->second.value != value)
+            continue;
+
+        uint16_t target = static_cast<uint16_t>(cur->first >> 8);
+        auto &waiting = cur->second.waiting;
+        if (target == avid && waiting.empty()) {
+            confirm_(cur, now);
+            continue;
+        }
+        auto w = std::find(waiting.begin(), waiting.end(), avid);
+        if (w == waiting.end())
+            continue;
+        waiting.erase(w);
+        if (waiting.empty())
+            confirm_(cur, now);
+    }
+}
+
+void AckTracker::forget(uint16_t avid) {
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        auto cur = it++;
+        auto &waiting = cur->second.waiting;
+        if (static_cast<uint16_t>(cur->first >> 8) == avid && waiting.empty()) {
+            entries_.erase(cur);
+            continue;
+        }
+        auto w = std::find(waiting.begin(), waiting.end(), avid);
+        if (w == waiting.end())
+            continue;
+        waiting.erase(w);
+        // Every remaining member has already confirmed
+        if (waiting.empty())
+            entries_.erase(cur);
+    }
+}
+
+void AckTracker::poll(uint32_t now) {
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        auto &e = it->second;
+        if (static_cast<int32_t>(now - e.deadline_ms) < 0) {
+            ++it;
+            continue;
+        }
+        uint16_t target = static_cast<uint16_t>(it->first >> 8);
+        if (e.attempts >= max_retries_) {
+            ESP_LOGW(TAG, "No confirmation from %u after %u retries", target, e.attempts);
+            stats_.failed++;
+            it = entries_.erase(it);
+            continue;
+        }
+        e.attempts++;
+        stats_.retries++;
+        e.deadline_ms = now + backoff_(e.timeout_ms, e.attempts);
+        ESP_LOGD(TAG, "Retry %u/%u for %u (%zu unconfirmed)", e.attempts, max_retries_, target,
+                 e.waiting.size());
+        if (send_fn_)
+            send_fn_(e.cmd);
+        ++it;
+    }
+}
+
+uint32_t AckTracker::base_timeout_(uint16_t target, const std::vector<uint16_t> &members) const {
+    uint32_t timeout = ACK_TIMEOUT_MS;
+    if (!timeout_fn_)
+        return timeout;
+    if (members.empty())
+        return std::max(timeout, timeout_fn_(target));
+    for (auto m : members)
+        timeout = std::max(timeout, timeout_fn_(m));
+    return timeout;
+}
+
+uint32_t AckTracker::backoff_(uint32_t timeout_ms, uint8_t attempts) {
+    uint32_t base = timeout_ms << std::min<uint8_t>(attempts, 4);
+    // Up to +50% jitter so retries to several targets don't land together
+    uint32_t jitter = random_fn_ ? random_fn_() % (base / 2 + 1) : 0;
+    return base + jitter;
+}
+
+void AckTracker::confirm_(std::map<uint32_t, Entry>::iterator it, uint32_t now) {
+    uint32_t latency = now - it->second.sent_ms;
+    stats_.acked++;
+    stats_.total_latency_ms += latency;
+    if (latency > stats_.max_latency_ms)
+        stats_.max_latency_ms = latency;
+    entries_.erase(it);
+    if (confirm_fn_)
+        confirm_fn_(latency);
+}
+
+std::string AckTracker::stats_json() const {
+    char buf[224];
+    snprintf(buf, sizeof(buf),
+             "{\"pending\":%u,\"tracked\":%u,\"acked\":%u,\"retries\":%u,\"failed\":%u,"
+             "\"superseded\":%u,\"avg_latency_ms\":%u,\"max_latency_ms\":%u}",
+             static_cast<unsigned>(entries_.size()), stats_.tracked, stats_.acked,
+             stats_.retries, stats_.failed, stats_.superseded,
+             stats_.acked ? stats_.total_latency_ms / stats_.acked : 0u, stats_.max_latency_ms);
+    return buf;
+}
+
+}  // namespace avionmesh
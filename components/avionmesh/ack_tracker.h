@@ -0,0 +1,91 @@
+#pragma once
+
+#include <avionmesh/avionmesh.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace avionmesh {
+
+enum class AckAttr : uint8_t {
+    Brightness,
+    ColorTemp,
+};
+
+struct AckStats {
+    uint32_t tracked{0};
+    uint32_t acked{0};
+    uint32_t retries{0};
+    uint32_t failed{0};      // retry budget exhausted without confirmation
+    uint32_t superseded{0};  // replaced by a newer command before confirming
+    uint32_t total_latency_ms{0};
+    uint32_t max_latency_ms{0};
+};
+
+/* In-flight state writes keyed by (target, attribute). A write is confirmed
+ * when the target reports the commanded value back; for group / broadcast
+ * targets every capable member has to report it. Unconfirmed writes are
+ * re-sent with jittered exponential backoff up to the retry limit. */
+class AckTracker {
+ public:
+    void set_send_fn(std::function<void(const Command &)> fn) { send_fn_ = std::move(fn); }
+    void set_random_fn(std::function<uint32_t()> fn) { random_fn_ = std::move(fn); }
+    /* Called with the send-to-confirm latency of every confirmed write */
+    void set_confirm_fn(std::function<void(uint32_t)> fn) { confirm_fn_ = std::move(fn); }
+    /* Measured first-retry timeout for a device, 0 if unknown. A group write
+     * waits for its slowest member; ACK_TIMEOUT_MS is always the floor. */
+    void set_timeout_fn(std::function<uint32_t(uint16_t)> fn) { timeout_fn_ = std::move(fn); }
+    void set_max_retries(uint8_t retries) { max_retries_ = retries; }
+    uint8_t max_retries() const { return max_retries_; }
+
+    /* Start tracking a write that was just sent. members lists the devices
+     * that must confirm a group / broadcast write; empty for a device. */
+    void track(uint16_t target, AckAttr attr, uint16_t value, const Command &cmd,
+               std::vector<uint16_t> members, uint32_t now);
+    /* A device reported its current value for attr */
+    void on_report(uint16_t avid, AckAttr attr, uint16_t value, uint32_t now);
+    void poll(uint32_t now);
+    /* Drop a removed device: its own writes, and its wait in group writes */
+    void forget(uint16_t avid);
+    void clear() { entries_.clear(); }
+
+    size_t pending() const { return entries_.size(); }
+    bool is_pending(uint16_t target, AckAttr attr) const { return entries_.count(key_(target, attr)) > 0; }
+    const AckStats &stats() const { return stats_; }
+    std::string stats_json() const;
+
+    /* First retry fires this long after the send; each retry doubles it */
+    static constexpr uint32_t ACK_TIMEOUT_MS = 800;
+
+ protected:
+    struct Entry {
+        Command cmd;
+        uint16_t value;
+        std::vector<uint16_t> waiting;  // members yet to confirm (groups only)
+        uint32_t sent_ms;
+        uint32_t timeout_ms;  // first retry delay for this target
+        uint32_t deadline_ms;
+        uint8_t attempts;
+    };
+
+    std::function<void(const Command &)> send_fn_;
+    std::function<uint32_t()> random_fn_;
+    std::function<void(uint32_t)> confirm_fn_;
+    std::function<uint32_t(uint16_t)> timeout_fn_;
+    uint8_t max_retries_{2};
+    std::map<uint32_t, Entry> entries_;
+    AckStats stats_;
+
+    static uint32_t key_(uint16_t target, AckAttr attr) {
+        return (static_cast<uint32_t>(target) << 8) | static_cast<uint8_t>(attr);
+    }
+    uint32_t base_timeout_(uint16_t target, const std::vector<uint16_t> &members) const;
+    uint32_t backoff_(uint32_t timeout_ms, uint8_t attempts);
+    void confirm_(std::map<uint32_t, Entry>::iterator it, uint32_t now);
+};
+
+}  // namespace avionmesh
@@ -0,0 +1,138 @@
+#include "airtime.h"
+
+#include <recsrmesh/csrmesh.h>
+
+#include <cstdio>
+
+namespace avionmesh {
+
+AirClass AirtimeMeter::classify(const uint8_t *payload, size_t payload_len) {
+    if (payload_len < 2)
+        return AirClass::Other;
+    switch (static_cast<Verb>(payload[0])) {
+    case Verb::Write:
+        if (payload[1] == static_cast<uint8_t>(Noun::Date) || payload[1] == static_cast<uint8_t>(Noun::Time))
+            return AirClass::Time;
+        return AirClass::Control;
+    case Verb::Read:
+        return AirClass::Read;
+    case Verb::Insert:
+    case Verb::Truncate:
+        return AirClass::GroupEdit;
+    case Verb::Ping:
+        return AirClass::Ping;
+    }
+    return AirClass::Other;
+}
+
+const char *AirtimeMeter::class_name(AirClass cls) {
+    switch (cls) {
+    case AirClass::Control:   return "control";
+    case AirClass::Read:      return "read";
+    case AirClass::Ping:      return "ping";
+    case AirClass::GroupEdit: return "group_edit";
+    case AirClass::Time:      return "time";
+    case AirClass::Other:     return "other";
+    }
+    return "unknown";
+}
+
+size_t AirtimeMeter::packet_bytes(size_t payload_len) {
+    // Model opcode + payload, plus sequence, source, MAC and TTL
+    return 1 + payload_len + csrmesh::MCP_CRYPTO_OVERHEAD;
+}
+
+AirtimeMeter::Bucket &AirtimeMeter::bucket_(uint32_t now) {
+    uint32_t second = now / 1000;
+    auto &b = buckets_[second % WINDOW_S];
+    if (b.second != second)
+        b = Bucket{second};
+    return b;
+}
+
+AirtimeMeter::Bucket AirtimeMeter::window_(uint32_t now) const {
+    uint32_t second = now / 1000;
+    Bucket sum;
+    for (auto &b : buckets_) {
+        if (second - b.second >= WINDOW_S)
+            continue;
+        for (size_t i = 0; i < AIR_CLASS_COUNT; i++) {
+            sum.tx[i].packets += b.tx[i].packets;
+            sum.tx[i].bytes += b.tx[i].bytes;
+            sum.rx[i].packets += b.rx[i].packets;
+            sum.rx[i].bytes += b.rx[i].bytes;
+        }
+        for (size_t i = 0; i < TX_SOURCE_COUNT; i++) {
+            sum.source[i].packets += b.source[i].packets;
+            sum.source[i].bytes += b.source[i].bytes;
+        }
+    }
+    return sum;
+}
+
+void AirtimeMeter::on_tx(const Command &cmd, TxSource source, uint32_t now) {
+    size_t bytes = packet_bytes(cmd.payload_len);
+    auto &b = bucket_(now);
+    b.tx[static_cast<size_t>(classify(cmd.payload, cmd.payload_len))].add(bytes);
+    b.source[static_cast<size_t>(source)].add(bytes);
+    total_tx_++;
+}
+
+void AirtimeMeter::on_rx(const uint8_t *payload, size_t payload_len, uint32_t now) {
+    bucket_(now).rx[static_cast<size_t>(classify(payload, payload_len))].add(packet_bytes(payload_len));
+    total_rx_++;
+}
+
+float AirtimeMeter::packets_per_s(uint32_t now) {
+    Bucket w = window_(now);
+    uint32_t packets = 0;
+    for (size_t i = 0; i < AIR_CLASS_COUNT; i++)
+        packets += w.tx[i].packets + w.rx[i].packets;
+    return static_cast<float>(packets) / WINDOW_S;
+}
+
+bool AirtimeMeter::background_allowed(uint32_t now) {
+    bool allowed = budget_pps_ <= 0.0f || packets_per_s(now) < budget_pps_;
+    if (!allowed && !was_throttled_)
+        throttled_++;
+    was_throttled_ = !allowed;
+    return allowed;
+}
+
+std::string AirtimeMeter::stats_json(uint32_t now) {
+    Bucket w = window_(now);
+    Counter tx, rx;
+    for (size_t i = 0; i < AIR_CLASS_COUNT; i++) {
+        tx.packets += w.tx[i].packets;
+        tx.bytes += w.tx[i].bytes;
+        rx.packets += w.rx[i].packets;
+        rx.bytes += w.rx[i].bytes;
+    }
+
+    const float secs = static_cast<float>(WINDOW_S);
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+             "{\"window_s\":%u,\"budget_pps\":%.1f,\"throttled\":%u,\"tx_total\":%u,\"rx_total\":%u,"
+             "\"tx_pps\":%.1f,\"tx_bps\":%.1f,\"rx_pps\":%.1f,\"rx_bps\":%.1f,\"classes\":{",
+             WINDOW_S, budget_pps_, throttled_, total_tx_, total_rx_, tx.packets / secs,
+             tx.bytes / secs, rx.packets / secs, rx.bytes / secs);
+    std::string json = buf;
+    for (size_t i = 0; i < AIR_CLASS_COUNT; i++) {
+        snprintf(buf, sizeof(buf),
+                 "%s\"%s\":{\"tx_pps\":%.1f,\"tx_bps\":%.1f,\"rx_pps\":%.1f,\"rx_bps\":%.1f}",
+                 i > 0 ? "," : "", class_name(static_cast<AirClass>(i)), w.tx[i].packets / secs,
+                 w.tx[i].bytes / secs, w.rx[i].packets / secs, w.rx[i].bytes / secs);
+        json += buf;
+    }
+    json += "},\"sources\":{";
+    for (size_t i = 0; i < TX_SOURCE_COUNT; i++) {
+        snprintf(buf, sizeof(buf), "%s\"%s\":{\"tx_pps\":%.1f,\"tx_bps\":%.1f}", i > 0 ? "," : "",
+                 MeshTxScheduler::source_name(static_cast<TxSource>(i)),
+                 w.source[i].packets / secs, w.source[i].bytes / secs);
+        json += buf;
+    }
+    json += "}}";
+    return json;
+}
+
+}  // namespace avionmesh
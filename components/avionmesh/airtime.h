@@ -0,0 +1,76 @@
+#pragma once
+
+#include "mesh_tx.h"
+
+#include <avionmesh/avionmesh.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace avionmesh {
+
+/* What a mesh packet does, from its verb / noun */
+enum class AirClass : uint8_t {
+    Control,    // brightness / color writes
+    Read,       // state reads
+    Ping,       // discovery, examine, latency pings
+    GroupEdit,  // group insert / truncate
+    Time,       // date / time sync
+    Other,      // status reports and anything unrecognised
+};
+
+static constexpr size_t AIR_CLASS_COUNT = 6;
+
+/* Mesh traffic meter: TX and RX packets / bytes over a rolling window of
+ * one-second buckets, split by packet class and (TX only) by source. Also
+ * enforces the airtime budget: background traffic may only be sent while
+ * TX + RX over the window stays under it. */
+class AirtimeMeter {
+ public:
+    static constexpr uint32_t WINDOW_S = 10;
+
+    /* Mesh packets per second (TX + RX); 0 disables the budget */
+    void set_budget(float packets_per_s) { budget_pps_ = packets_per_s; }
+    float budget() const { return budget_pps_; }
+
+    void on_tx(const Command &cmd, TxSource source, uint32_t now);
+    void on_rx(const uint8_t *payload, size_t payload_len, uint32_t now);
+    /* False while the window is at or over budget */
+    bool background_allowed(uint32_t now);
+
+    float packets_per_s(uint32_t now);
+    std::string stats_json(uint32_t now);
+
+    static AirClass classify(const uint8_t *payload, size_t payload_len);
+    static const char *class_name(AirClass cls);
+    /* Bytes of one encrypted MCP packet carrying payload_len model bytes */
+    static size_t packet_bytes(size_t payload_len);
+
+ protected:
+    struct Counter {
+        uint32_t packets{0};
+        uint32_t bytes{0};
+        void add(size_t b) { packets++; bytes += static_cast<uint32_t>(b); }
+    };
+    struct Bucket {
+        uint32_t second{0};
+        std::array<Counter, AIR_CLASS_COUNT> tx{};
+        std::array<Counter, AIR_CLASS_COUNT> rx{};
+        std::array<Counter, TX_SOURCE_COUNT> source{};
+    };
+
+    std::array<Bucket, WINDOW_S> buckets_{};
+    float budget_pps_{0.0f};
+    uint32_t throttled_{0};  // polls refused by the budget
+    bool was_throttled_{false};
+    uint32_t total_tx_{0};
+    uint32_t total_rx_{0};
+
+    Bucket &bucket_(uint32_t now);
+    /* Sum of buckets still inside the window */
+    Bucket window_(uint32_t now) const;
+};
+
+}  // namespace avionmesh
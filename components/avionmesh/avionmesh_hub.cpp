@@ -4,14 +4,15 @@
 #endif
 
 #include "esphome/core/application.h"
+#include "esphome/core/helpers.h"
 #include "esphome/core/log.h"
 #include "esphome/components/mqtt/mqtt_client.h"
 #include "esphome/components/json/json_util.h"  // management commands still use JSON
 #include "esphome/components/web_server_base/web_server_base.h"
 
+#include <algorithm>
 #include <cstring>
 #include <ctime>
-#include <set>
 
 #ifdef USE_ESP32
 #include <nvs_flash.h>
@@ -34,14 +35,60 @@ static const uint8_t CHAR_HIGH_UUID128[16] = {
 
 namespace avionmesh {
 
+/* The TX scheduler carries Commands only. No Avi-on command is empty, so a
+ * zero-length payload stands for a CSRMesh disassociate of dest_id. */
+static Command disassociate_cmd(uint16_t avion_id) {
+    Command cmd;
+    cmd.dest_id = avion_id;
+    return cmd;
+}
+
+static bool is_disassociate(const Command &cmd) { return cmd.payload_len == 0; }
+
+AvionMeshHub::AvionMeshHub() {
+    tx_.set_send_fn([this](const Command &cmd) {
+        profiler_.on_dispatch(cmd, esphome::millis());
+        airtime_.on_tx(cmd, tx_.dispatch_source(), esphome::millis());
+        do_mesh_send(cmd);
+    });
+    tx_.set_ready_fn([this]() { return do_mesh_accepting(); });
+    tx_.set_budget_fn([this]() { return airtime_.background_allowed(esphome::millis()); });
+    for (uint8_t i = 0; i < MAX_BRIDGES; i++)
+        bridges_[i].set_index(i);
+    acks_.set_send_fn([this](const Command &cmd) { mesh_send(cmd, TxClass::Interactive); });
+    acks_.set_random_fn([]() { return esphome::random_uint32(); });
+    acks_.set_confirm_fn([this](uint32_t latency_ms) {
+        if (rx_bridge_ >= 0)
+            bridges_[rx_bridge_].on_ack_latency(latency_ms);
+    });
+    acks_.set_timeout_fn([this](uint16_t avid) { return profiler_.ack_timeout_ms(avid); });
+    profiler_.set_send_fn([this](const Command &cmd) { mesh_send(cmd, TxClass::Provisioning); });
+    profiler_.set_done_fn([this]() { on_profile_done(); });
+    refresh_.set_send_fn([this](const Command &cmd) { mesh_send(cmd, TxClass::StateRead); });
+    latch_.set_level_fn([this](uint16_t avid) {
+        auto it = device_states_.find(avid);
+        return it != device_states_.end() && it->second.brightness_known ? it->second.brightness : -1;
+    });
+    limiter_.set_send_fn([this](uint16_t target, AckAttr attr, uint16_t value, TxSource source) {
+        SourceScope scope(*this, source);
+        if (attr == AckAttr::Brightness)
+            write_brightness(target, static_cast<uint8_t>(value));
+        else
+            write_color_temp(target, value);
+    });
+}
+
 float AvionMeshHub::get_setup_priority() const {
     return esphome::setup_priority::AFTER_BLUETOOTH;
 }
 
 void AvionMeshHub::setup() {
     ESP_LOGI(TAG, "Setting up AvionMesh hub...");
+    boot_ms_ = esphome::millis();
 
     db_.load();
+    gatt_cache_.load();
+    discovery_.config_hashes().load();
 
 #ifdef USE_ESP32
     {
@@ -66,8 +113,8 @@ void AvionMeshHub::setup() {
         discovery_.set_node_name(esphome::App.get_name());
         discovery_.set_topic_prefix(mqtt->get_topic_prefix());
     }
-    discovery_.set_publish_fn([this](const std::string &t, const std::string &p, bool r) {
-        do_mqtt_publish(t, p, r);
+    discovery_.set_publish_fn([this](const char *t, const char *p, bool r) {
+        return do_mqtt_publish(t, p, r);
     });
 
     /* Initialize csrmesh crypto if passphrase exists */
@@ -85,12 +132,18 @@ void AvionMeshHub::setup() {
         sync_time();
     });
 
+    this->set_interval("stats", STATS_INTERVAL_MS, [this]() {
+        do_sse_emit("stats", stats_json());
+        do_mqtt_publish(discovery_.airtime_topic().c_str(), airtime_.stats_json(esphome::millis()).c_str(), false);
+    });
+
     /* Re-publish discovery when HA comes online */
     do_mqtt_subscribe("homeassistant/status",
                       [this](const std::string &, const std::string &payload) {
                           if (payload == "online") {
                               ESP_LOGI(TAG, "HA online, re-publishing discovery");
                               publish_all_discovery();
+                              republish_all_states();
                           }
                       });
 
@@ -105,8 +158,14 @@ void AvionMeshHub::dump_config() {
     ESP_LOGCONFIG(TAG, "  Mesh initialized: %s", mesh_initialized_ ? "YES" : "NO");
     ESP_LOGCONFIG(TAG, "  Passphrase configured: %s", db_.passphrase().empty() ? "NO" : "YES");
     ESP_LOGCONFIG(TAG, "  BLE state: %u", static_cast<uint8_t>(ble_state_));
-    ESP_LOGCONFIG(TAG, "  BLE char LOW: 0x%04X  HIGH: 0x%04X", char_low_handle_, char_high_handle_);
+    ESP_LOGCONFIG(TAG, "  Bridges: %zu ready, max %u", ready_bridges(), max_bridges_);
+    for (auto &br : bridges_) {
+        if (br.active())
+            ESP_LOGCONFIG(TAG, "    [%u] %s RSSI=%d LOW=0x%04X HIGH=0x%04X", br.index(),
+                          br.address().c_str(), br.rssi(), br.char_low_handle(), br.char_high_handle());
+    }
     ESP_LOGCONFIG(TAG, "  MQTT subscribed: %s", mqtt_subscribed_ ? "YES" : "NO");
+    ESP_LOGCONFIG(TAG, "  Ack retries: %u", acks_.max_retries());
     ESP_LOGCONFIG(TAG, "  Devices: %zu  Groups: %zu", db_.devices().size(), db_.groups().size());
 }
 
@@ -117,14 +176,38 @@ void AvionMeshHub::gap_event_handler(esp_gap_ble_cb_event_t event,
     switch (event) {
     case ESP_GAP_BLE_SCAN_PARAM_SET_COMPLETE_EVT:
         if (param->scan_param_cmpl.status == ESP_BT_STATUS_SUCCESS) {
-            esp_ble_gap_start_scanning(SCAN_WINDOW_MS / 1000);
+            esp_ble_gap_start_scanning(scan_window_ms_ / 1000);
         } else {
             ESP_LOGE(TAG, "Scan param set failed: %d", param->scan_param_cmpl.status);
-            ble_state_ = BleState::Disconnected;
+            scanning_ = false;
             reconnect_at_ms_ = esphome::millis() + RECONNECT_DELAY_MS;
+            refresh_ble_state();
         }
         break;
 
+    case ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT: {
+        auto *br = bridge_by_bda(param->update_conn_params.bda);
+        if (!br)
+            break;
+        if (param->update_conn_params.status == ESP_BT_STATUS_SUCCESS) {
+            br->set_conn_interval(param->update_conn_params.conn_int);
+            ESP_LOGD(TAG, "Bridge %u interval now %u x 1.25ms", br->index(),
+                     param->update_conn_params.conn_int);
+            do_sse_emit("meta", meta_json());
+        } else {
+            ESP_LOGW(TAG, "Bridge %u connection parameter update failed: %d", br->index(),
+                     param->update_conn_params.status);
+        }
+        break;
+    }
+
+    case ESP_GAP_BLE_READ_RSSI_COMPLETE_EVT:
+        if (param->read_rssi_cmpl.status != ESP_BT_STATUS_SUCCESS)
+            break;
+        if (auto *br = bridge_by_bda(param->read_rssi_cmpl.remote_addr))
+            br->on_rssi(param->read_rssi_cmpl.rssi);
+        break;
+
     default:
         break;
     }
@@ -140,7 +223,7 @@ void AvionMeshHub::gap_scan_event_handler(
 
     if (result.search_evt != ESP_GAP_SEARCH_INQ_RES_EVT)
         return;
-    if (ble_state_ != BleState::Scanning)
+    if (!scanning_)
         return;
 
     /* Parse advertisement data for 0xFEF1 service UUID */
@@ -169,10 +252,23 @@ void AvionMeshHub::gap_scan_event_handler(
                              result.bda[3], result.bda[4], result.bda[5]);
                     ESP_LOGD(TAG, "CSRMesh bridge: %s RSSI=%d", addr_str, result.rssi);
 
-                    if (result.rssi > best_rssi_) {
-                        best_rssi_ = result.rssi;
-                        std::memcpy(bridge_bda_, result.bda, 6);
+                    uint32_t now = esphome::millis();
+                    for (auto &c : scan_candidates_) {
+                        if (std::memcmp(c.bda, result.bda, sizeof(c.bda)) == 0) {
+                            // Best reading of this scan; replaces any reading from an older one
+                            if (static_cast<int32_t>(c.seen_ms - scan_start_ms_) < 0 ||
+                                result.rssi > c.rssi)
+                                c.rssi = result.rssi;
+                            c.seen_ms = now;
+                            c.failed = false;
+                            return;
+                        }
                     }
+                    ScanCandidate c{};
+                    std::memcpy(c.bda, result.bda, sizeof(c.bda));
+                    c.rssi = result.rssi;
+                    c.seen_ms = now;
+                    scan_candidates_.push_back(c);
                     return;
                 }
             }
@@ -183,11 +279,11 @@ void AvionMeshHub::gap_scan_event_handler(
 
 /* ---- GAP scanning ---- */
 
-void AvionMeshHub::start_scan() {
-    ble_state_ = BleState::Scanning;
-    best_rssi_ = -999;
-    std::memset(bridge_bda_, 0, sizeof(bridge_bda_));
+void AvionMeshHub::start_scan(uint32_t window_ms) {
+    scanning_ = true;
+    scan_window_ms_ = window_ms;
     scan_start_ms_ = esphome::millis();
+    refresh_ble_state();
     ESP_LOGI(TAG, "Scanning for CSRMesh bridges...");
 
     esp_ble_scan_params_t scan_params = {};
@@ -202,27 +298,239 @@ void AvionMeshHub::start_scan() {
 }
 
 void AvionMeshHub::stop_scan_and_connect() {
-    if (ble_state_ != BleState::Scanning)
+    if (!scanning_)
         return;
-    connect_to_best();
+    scanning_ = false;
+
+    /* Age out bridges not heard from in a while, then rank by RSSI */
+    uint32_t now = esphome::millis();
+    scan_candidates_.erase(
+        std::remove_if(scan_candidates_.begin(), scan_candidates_.end(),
+                       [now](const ScanCandidate &c) { return now - c.seen_ms > CANDIDATE_MAX_AGE_MS; }),
+        scan_candidates_.end());
+    std::sort(scan_candidates_.begin(), scan_candidates_.end(),
+              [](const ScanCandidate &a, const ScanCandidate &b) { return a.rssi > b.rssi; });
+    if (scan_candidates_.size() > MAX_SCAN_CANDIDATES)
+        scan_candidates_.resize(MAX_SCAN_CANDIDATES);
+    ESP_LOGD(TAG, "Scan done: %zu bridge candidates", scan_candidates_.size());
+    connect_next_bridge();
+    consider_roam();
 }
 
-void AvionMeshHub::connect_to_best() {
-    if (best_rssi_ == -999) {
-        ESP_LOGW(TAG, "No CSRMesh bridges found, retrying in %ums", RECONNECT_DELAY_MS);
-        ble_state_ = BleState::Disconnected;
-        reconnect_at_ms_ = esphome::millis() + RECONNECT_DELAY_MS;
+/* ---- Bridge links ---- */
+
+void AvionMeshHub::connect_next_bridge() {
+    if (scanning_ || connecting_bridge_ >= 0)
+        return;
+
+    size_t active = 0;
+    BridgeConnection *slot = nullptr;
+    for (auto &br : bridges_) {
+        if (br.active())
+            active++;
+        else if (!slot)
+            slot = &br;
+    }
+    if (!slot || active >= max_bridges_)
+        return;  // every link we want is already up
+
+    ScanCandidate *next = next_candidate();
+    if (!next) {
+        uint32_t now = esphome::millis();
+        bool found_any = std::any_of(scan_candidates_.begin(), scan_candidates_.end(),
+                                     [this](const ScanCandidate &c) {
+                                         return static_cast<int32_t>(c.seen_ms - scan_start_ms_) >= 0;
+                                     });
+        if (ready_bridges() > 0) {
+            reconnect_at_ms_ = now + BRIDGE_REFILL_INTERVAL_MS;
+        } else if (!found_any) {
+            ESP_LOGW(TAG, "No CSRMesh bridges found, retrying in %ums", RECONNECT_DELAY_MS);
+            reconnect_at_ms_ = now + RECONNECT_DELAY_MS;
+        } else {
+            /* Table exhausted or stale: rescan straight away */
+            ESP_LOGI(TAG, "No usable bridge candidates left, rescanning");
+            if (failover_pending_)
+                failover_rescans_++;
+            start_scan();
+            return;
+        }
+        refresh_ble_state();
         return;
     }
 
-    char addr_str[18];
-    snprintf(addr_str, sizeof(addr_str), "%02X:%02X:%02X:%02X:%02X:%02X",
-             bridge_bda_[0], bridge_bda_[1], bridge_bda_[2],
-             bridge_bda_[3], bridge_bda_[4], bridge_bda_[5]);
-    ESP_LOGI(TAG, "Connecting to best bridge: %s (RSSI=%d)", addr_str, best_rssi_);
+    open_bridge(*slot, *next);
+}
 
-    ble_state_ = BleState::Connecting;
-    esp_ble_gattc_open(gattc_if_, bridge_bda_, BLE_ADDR_TYPE_PUBLIC, true);
+void AvionMeshHub::open_bridge(BridgeConnection &slot, const ScanCandidate &candidate) {
+    slot.begin_connect(candidate.bda, candidate.rssi, esphome::millis());
+    connecting_bridge_ = static_cast<int8_t>(slot.index());
+    ESP_LOGI(TAG, "Connecting bridge %u: %s (RSSI=%d)", slot.index(),
+             slot.address().c_str(), candidate.rssi);
+    refresh_ble_state();
+    esp_bd_addr_t bda;
+    std::memcpy(bda, candidate.bda, sizeof(bda));
+    esp_ble_gattc_open(gattc_if_, bda, BLE_ADDR_TYPE_PUBLIC, true);
+}
+
+/* ---- Link quality and roaming ---- */
+
+void AvionMeshHub::maintain_links(uint32_t now) {
+    if (now - last_rssi_poll_ms_ >= RSSI_POLL_MS) {
+        last_rssi_poll_ms_ = now;
+        for (auto &br : bridges_) {
+            if (!br.ready())
+                continue;
+            br.update_quality(now);
+            esp_bd_addr_t bda;
+            std::memcpy(bda, br.bda(), sizeof(bda));
+            esp_ble_gap_read_rssi(bda);
+        }
+    }
+
+    /* Short background scan to find out whether a better bridge is around */
+    if (gattc_registered_ && !scanning_ && connecting_bridge_ < 0 && roam_from_ < 0 &&
+        now - last_roam_scan_ms_ >= ROAM_SCAN_INTERVAL_MS && link_idle(now)) {
+        last_roam_scan_ms_ = now;
+        roam_scans_++;
+        ESP_LOGD(TAG, "Background scan for better bridges");
+        start_scan(ROAM_SCAN_WINDOW_MS);
+    }
+}
+
+bool AvionMeshHub::link_idle(uint32_t now) const {
+    if (now - last_interactive_ms_ < ROAM_IDLE_MS)
+        return false;
+    for (size_t i = 0; i < TX_CLASS_COUNT; i++)
+        if (tx_.depth(static_cast<TxClass>(i)) > 0)
+            return false;
+    return acks_.pending() == 0 && !associating_ && !scanning_unassociated_;
+}
+
+void AvionMeshHub::consider_roam() {
+    // Free slots are filled by connect_next_bridge(); roaming replaces a live link
+    if (connecting_bridge_ >= 0 || roam_from_ >= 0 || ready_bridges() < max_bridges_)
+        return;
+    uint32_t now = esphome::millis();
+    if (!link_idle(now))
+        return;
+
+    BridgeConnection *worst = nullptr;
+    for (auto &br : bridges_) {
+        if (!br.ready() || now - br.ready_since_ms() < ROAM_MIN_DWELL_MS)
+            continue;
+        if (!worst || br.score() < worst->score())
+            worst = &br;
+    }
+    ScanCandidate *best = next_candidate();
+    if (!worst || !best || static_cast<int32_t>(best->seen_ms - scan_start_ms_) < 0)
+        return;  // only act on bridges this scan actually heard
+
+    uint8_t predicted = BridgeConnection::rssi_score(static_cast<float>(best->rssi));
+    if (predicted < worst->score() + ROAM_HYSTERESIS)
+        return;
+
+    roam_from_ = static_cast<int8_t>(worst->index());
+    ESP_LOGI(TAG, "Roaming: bridge %u (%s) scores %u, candidate RSSI=%d scores %u",
+             worst->index(), worst->address().c_str(), worst->score(), best->rssi, predicted);
+
+    /* Make before break when a spare slot exists */
+    for (auto &br : bridges_) {
+        if (!br.active()) {
+            open_bridge(br, *best);
+            return;
+        }
+    }
+    esp_ble_gattc_close(gattc_if_, worst->conn_id());
+}
+
+ScanCandidate *AvionMeshHub::next_candidate() {
+    uint32_t now = esphome::millis();
+    for (auto &c : scan_candidates_) {
+        if (c.failed || bridge_by_bda(c.bda) || now - c.seen_ms > CANDIDATE_MAX_AGE_MS)
+            continue;
+        return &c;  // ranked by RSSI, first usable one is the best
+    }
+    return nullptr;
+}
+
+void AvionMeshHub::mark_candidate_failed(const uint8_t *bda) {
+    for (auto &c : scan_candidates_)
+        if (std::memcmp(c.bda, bda, sizeof(c.bda)) == 0)
+            c.failed = true;
+}
+
+BridgeConnection *AvionMeshHub::bridge_by_conn_id(uint16_t conn_id) {
+    for (auto &br : bridges_) {
+        if ((br.state() == BleState::Discovering || br.state() == BleState::Ready) &&
+            br.conn_id() == conn_id)
+            return &br;
+    }
+    return nullptr;
+}
+
+BridgeConnection *AvionMeshHub::bridge_by_bda(const uint8_t *bda) {
+    for (auto &br : bridges_) {
+        if (br.active() && br.has_bda(bda))
+            return &br;
+    }
+    return nullptr;
+}
+
+BridgeConnection *AvionMeshHub::pick_bridge() {
+    BridgeConnection *best = nullptr;
+    for (auto &br : bridges_) {
+        if (!br.ready())
+            continue;
+        if (!best || br.load() < best->load())
+            best = &br;
+    }
+    return best;
+}
+
+BridgeConnection *AvionMeshHub::primary_bridge() {
+    for (auto &br : bridges_) {
+        if (br.ready())
+            return &br;
+    }
+    return nullptr;
+}
+
+size_t AvionMeshHub::ready_bridges() const {
+    size_t n = 0;
+    for (auto &br : bridges_)
+        if (br.ready())
+            n++;
+    return n;
+}
+
+bool AvionMeshHub::bridge_accepting() const {
+    // With no link up the queues hold until a bridge is Ready again
+    for (auto &br : bridges_)
+        if (br.accepting())
+            return true;
+    return false;
+}
+
+void AvionMeshHub::refresh_ble_state() {
+    BleState state = BleState::Disconnected;
+    for (auto &br : bridges_) {
+        if (br.ready()) {
+            state = BleState::Ready;
+            break;
+        }
+        if (br.state() == BleState::Discovering)
+            state = BleState::Discovering;
+        else if (br.state() == BleState::Connecting && state != BleState::Discovering)
+            state = BleState::Connecting;
+    }
+    if (state == BleState::Disconnected) {
+        if (scanning_)
+            state = BleState::Scanning;
+        else if (!gattc_registered_ && ble_state_ == BleState::Idle)
+            state = BleState::Idle;
+    }
+    ble_state_ = state;
+    update_mesh_initialized();
 }
 
 /* ---- GATTC event handler (dispatched by esp32_ble) ---- */
@@ -236,76 +544,147 @@ void AvionMeshHub::gattc_event_handler(esp_gattc_cb_event_t event,
             gattc_if_ = gattc_if;
             gattc_registered_ = true;
             app_id_ = param->reg.app_id;
+            if (seed_candidates_from_cache())
+                break;
             ESP_LOGI(TAG, "GATTC registered, starting scan");
             start_scan();
         }
         break;
 
-    case ESP_GATTC_OPEN_EVT:
+    case ESP_GATTC_OPEN_EVT: {
+        auto *br = bridge_by_bda(param->open.remote_bda);
+        if (!br)
+            break;
+        if (connecting_bridge_ == br->index())
+            connecting_bridge_ = -1;
         if (param->open.status == ESP_GATT_OK) {
-            on_connected(gattc_if, param->open.conn_id);
+            on_connected(*br, gattc_if, param->open.conn_id);
         } else {
-            ESP_LOGW(TAG, "BLE connection failed: %d, will retry", param->open.status);
-            on_disconnected();
+            ESP_LOGW(TAG, "Bridge %u connection failed: %d", br->index(), param->open.status);
+            on_bridge_disconnected(*br);
         }
         break;
+    }
+
+    case ESP_GATTC_CONNECT_EVT:
+        if (auto *br = bridge_by_bda(param->connect.remote_bda))
+            br->set_conn_interval(param->connect.conn_params.interval);
+        break;
 
     case ESP_GATTC_SEARCH_CMPL_EVT:
-        on_service_discovery_complete();
+        if (auto *br = bridge_by_conn_id(param->search_cmpl.conn_id))
+            on_service_discovery_complete(*br);
+        break;
+
+    case ESP_GATTC_WRITE_CHAR_EVT:
+        if (auto *br = bridge_by_conn_id(param->write.conn_id)) {
+            br->on_write_complete(param->write.status, esphome::millis());
+            // A rejected write on cached handles means the layout changed
+            if (param->write.status != ESP_GATT_OK && br->from_cache())
+                fall_back_to_discovery(*br);
+        }
+        break;
+
+    case ESP_GATTC_WRITE_DESCR_EVT: {
+        /* Cached links wait for both CCCD writes before going Ready */
+        auto *br = bridge_by_conn_id(param->write.conn_id);
+        if (!br || !br->from_cache() || br->ready())
+            break;
+        if (param->write.status != ESP_GATT_OK) {
+            fall_back_to_discovery(*br);
+            break;
+        }
+        if (br->take_cccd_write())
+            on_bridge_ready(*br);
+        break;
+    }
+
+    case ESP_GATTC_CONGEST_EVT:
+        if (auto *br = bridge_by_conn_id(param->congest.conn_id))
+            br->on_congest(param->congest.congested, esphome::millis());
         break;
 
     case ESP_GATTC_REG_FOR_NOTIFY_EVT: {
         ESP_LOGI(TAG, "REG_FOR_NOTIFY handle=0x%04X status=%d",
                  param->reg_for_notify.handle, param->reg_for_notify.status);
-        if (param->reg_for_notify.status != ESP_GATT_OK)
+
+        /* The event carries no conn_id; registrations complete in request
+         * order, so hand it to the first link still waiting on this handle */
+        BridgeConnection *br = nullptr;
+        for (auto &b : bridges_) {
+            if (b.active() && b.take_notify_reg(param->reg_for_notify.handle)) {
+                br = &b;
+                break;
+            }
+        }
+        if (!br)
+            break;
+        if (param->reg_for_notify.status != ESP_GATT_OK) {
+            if (br->from_cache())
+                fall_back_to_discovery(*br);
             break;
+        }
 
         /* Write CCCD to actually enable notifications on the remote device */
-        esp_bt_uuid_t cccd_uuid = {.len = ESP_UUID_LEN_16, .uuid = {.uuid16 = ESP_GATT_UUID_CHAR_CLIENT_CONFIG}};
-        esp_gattc_descr_elem_t desc_result;
-        uint16_t count = 1;
-        auto err = esp_ble_gattc_get_descr_by_char_handle(
-            gattc_if, conn_id_, param->reg_for_notify.handle, cccd_uuid, &desc_result, &count);
-        if (err != ESP_GATT_OK || count == 0) {
-            ESP_LOGW(TAG, "CCCD not found for handle 0x%04X (err=%d)",
-                     param->reg_for_notify.handle, err);
-            break;
+        uint16_t cccd = br->cccd_handle(param->reg_for_notify.handle);
+        if (!cccd) {
+            esp_bt_uuid_t cccd_uuid = {.len = ESP_UUID_LEN_16, .uuid = {.uuid16 = ESP_GATT_UUID_CHAR_CLIENT_CONFIG}};
+            esp_gattc_descr_elem_t desc_result;
+            uint16_t count = 1;
+            auto err = esp_ble_gattc_get_descr_by_char_handle(
+                gattc_if, br->conn_id(), param->reg_for_notify.handle, cccd_uuid, &desc_result, &count);
+            if (err != ESP_GATT_OK || count == 0) {
+                ESP_LOGW(TAG, "CCCD not found for handle 0x%04X (err=%d)",
+                         param->reg_for_notify.handle, err);
+                break;
+            }
+            cccd = desc_result.handle;
+            br->set_cccd_handle(param->reg_for_notify.handle, cccd);
+            if (br->cccd_low_handle() && br->cccd_high_handle())
+                store_gatt_cache(*br);
         }
 
         uint16_t notify_en = 1;
-        esp_ble_gattc_write_char_descr(gattc_if, conn_id_, desc_result.handle,
+        esp_ble_gattc_write_char_descr(gattc_if, br->conn_id(), cccd,
                                         sizeof(notify_en), (uint8_t *)&notify_en,
                                         ESP_GATT_WRITE_TYPE_RSP, ESP_GATT_AUTH_REQ_NONE);
-        ESP_LOGI(TAG, "Wrote CCCD for handle 0x%04X (desc=0x%04X)",
-                 param->reg_for_notify.handle, desc_result.handle);
+        ESP_LOGI(TAG, "Bridge %u: wrote CCCD for handle 0x%04X (desc=0x%04X)",
+                 br->index(), param->reg_for_notify.handle, cccd);
         break;
     }
 
     case ESP_GATTC_NOTIFY_EVT: {
-        ESP_LOGD(TAG, "NOTIFY handle=0x%04X len=%u",
+        ESP_LOGD(TAG, "NOTIFY conn=%u handle=0x%04X len=%u", param->notify.conn_id,
                  param->notify.handle, param->notify.value_len);
 
-        if (!mesh_initialized_ || ble_state_ != BleState::Ready)
+        auto *br = bridge_by_conn_id(param->notify.conn_id);
+        if (!br || !br->ready())
+            break;
+        br->on_notify();
+        if (!mesh_initialized_)
             break;
 
         uint16_t handle = param->notify.handle;
         csrmesh::Characteristic ch;
-        if (handle == char_low_handle_)
+        if (handle == br->char_low_handle())
             ch = csrmesh::Characteristic::Low;
-        else if (handle == char_high_handle_)
+        else if (handle == br->char_high_handle())
             ch = csrmesh::Characteristic::High;
         else
             break;
 
-        csrmesh::feed_notify(mesh_ctx_, ch,
+        csrmesh::feed_notify(br->mesh_ctx(), ch,
                               param->notify.value, param->notify.value_len,
                               esphome::millis());
         break;
     }
 
     case ESP_GATTC_DISCONNECT_EVT:
-        ESP_LOGW(TAG, "BLE disconnected (reason=%d)", param->disconnect.reason);
-        on_disconnected();
+        if (auto *br = bridge_by_conn_id(param->disconnect.conn_id)) {
+            ESP_LOGW(TAG, "Bridge %u disconnected (reason=%d)", br->index(),
+                     param->disconnect.reason);
+            on_bridge_disconnected(*br);
+        }
         break;
 
     default:
@@ -313,71 +692,218 @@ void AvionMeshHub::gattc_event_handler(esp_gattc_cb_event_t event,
     }
 }
 
-void AvionMeshHub::on_connected(esp_gatt_if_t gattc_if, uint16_t conn_id) {
-    conn_id_ = conn_id;
+void AvionMeshHub::on_connected(BridgeConnection &br, esp_gatt_if_t gattc_if, uint16_t conn_id) {
     gattc_if_ = gattc_if;
-    ble_state_ = BleState::Discovering;
-    ESP_LOGI(TAG, "BLE connected, discovering services...");
+    br.on_open(gattc_if, conn_id);
+    refresh_ble_state();
+
+    if (const auto *cached = gatt_cache_.find(br.bda())) {
+        ESP_LOGI(TAG, "Bridge %u connected, using cached handles LOW=0x%04X HIGH=0x%04X",
+                 br.index(), cached->char_low, cached->char_high);
+        gatt_cache_hits_++;
+        br.set_from_cache(true);
+        br.set_handles(cached->char_low, cached->char_high);
+        br.set_cccd_handle(cached->char_low, cached->cccd_low);
+        br.set_cccd_handle(cached->char_high, cached->cccd_high);
+        br.expect_cccd_writes(2);
+        register_notify(br);
+        return;
+    }
+
+    gatt_cache_misses_++;
+    ESP_LOGI(TAG, "Bridge %u connected, discovering services...", br.index());
     esp_ble_gattc_search_service(gattc_if, conn_id, nullptr);
 }
 
-void AvionMeshHub::on_service_discovery_complete() {
+void AvionMeshHub::register_notify(BridgeConnection &br) {
+    br.expect_notify_reg(br.char_low_handle());
+    br.expect_notify_reg(br.char_high_handle());
+    esp_bd_addr_t bda;
+    std::memcpy(bda, br.bda(), sizeof(bda));
+    esp_ble_gattc_register_for_notify(gattc_if_, bda, br.char_low_handle());
+    esp_ble_gattc_register_for_notify(gattc_if_, bda, br.char_high_handle());
+}
+
+void AvionMeshHub::fall_back_to_discovery(BridgeConnection &br) {
+    ESP_LOGW(TAG, "Bridge %u: cached GATT handles failed, discovering services", br.index());
+    gatt_cache_fallbacks_++;
+    gatt_cache_.erase(br.bda());
+    br.begin_rediscovery();
+    refresh_ble_state();
+    esp_ble_gattc_search_service(gattc_if_, br.conn_id(), nullptr);
+}
+
+void AvionMeshHub::store_gatt_cache(BridgeConnection &br) {
+    GattCacheEntry e;
+    std::memcpy(e.bda, br.bda(), sizeof(e.bda));
+    e.rssi = static_cast<int8_t>(std::clamp(br.rssi(), -128, 127));
+    e.char_low = br.char_low_handle();
+    e.char_high = br.char_high_handle();
+    e.cccd_low = br.cccd_low_handle();
+    e.cccd_high = br.cccd_high_handle();
+    gatt_cache_.store(e);
+    ESP_LOGD(TAG, "Bridge %u: GATT handles cached", br.index());
+}
+
+bool AvionMeshHub::seed_candidates_from_cache() {
+    if (gatt_cache_.entries().empty())
+        return false;
+
+    uint32_t now = esphome::millis();
+    for (auto &e : gatt_cache_.entries()) {
+        bool known = false;
+        for (auto &c : scan_candidates_)
+            if (std::memcmp(c.bda, e.bda, sizeof(c.bda)) == 0)
+                known = true;
+        if (known)
+            continue;
+        ScanCandidate c{};
+        std::memcpy(c.bda, e.bda, sizeof(c.bda));
+        c.rssi = e.rssi;
+        c.seen_ms = now;
+        scan_candidates_.push_back(c);
+    }
+    std::sort(scan_candidates_.begin(), scan_candidates_.end(),
+              [](const ScanCandidate &a, const ScanCandidate &b) { return a.rssi > b.rssi; });
+    ESP_LOGI(TAG, "GATTC registered, reconnecting to %zu known bridges without scanning",
+             gatt_cache_.entries().size());
+    connect_next_bridge();
+    return true;
+}
+
+void AvionMeshHub::on_service_discovery_complete(BridgeConnection &br) {
     uint16_t count = 0;
     esp_gattc_char_elem_t result;
+    uint16_t low = 0, high = 0;
 
     esp_bt_uuid_t low_uuid;
     low_uuid.len = ESP_UUID_LEN_128;
     std::memcpy(low_uuid.uuid.uuid128, CHAR_LOW_UUID128, 16);
     count = 1;
-    if (esp_ble_gattc_get_char_by_uuid(gattc_if_, conn_id_, 0x0001, 0xFFFF,
+    if (esp_ble_gattc_get_char_by_uuid(gattc_if_, br.conn_id(), 0x0001, 0xFFFF,
                                          low_uuid, &result, &count) == ESP_OK && count > 0) {
-        char_low_handle_ = result.char_handle;
+        low = result.char_handle;
     }
 
     esp_bt_uuid_t high_uuid;
     high_uuid.len = ESP_UUID_LEN_128;
     std::memcpy(high_uuid.uuid.uuid128, CHAR_HIGH_UUID128, 16);
     count = 1;
-    if (esp_ble_gattc_get_char_by_uuid(gattc_if_, conn_id_, 0x0001, 0xFFFF,
+    if (esp_ble_gattc_get_char_by_uuid(gattc_if_, br.conn_id(), 0x0001, 0xFFFF,
                                          high_uuid, &result, &count) == ESP_OK && count > 0) {
-        char_high_handle_ = result.char_handle;
+        high = result.char_handle;
     }
 
-    if (char_low_handle_ && char_high_handle_) {
-        ESP_LOGI(TAG, "Found characteristics: LOW=0x%04X HIGH=0x%04X",
-                 char_low_handle_, char_high_handle_);
+    if (low && high) {
+        ESP_LOGI(TAG, "Bridge %u characteristics: LOW=0x%04X HIGH=0x%04X", br.index(), low, high);
+        br.set_handles(low, high);
+        register_notify(br);
+        on_bridge_ready(br);
+    } else {
+        ESP_LOGE(TAG, "Bridge %u: CSRMesh characteristics not found (LOW=0x%04X HIGH=0x%04X)",
+                 br.index(), low, high);
+        esp_ble_gattc_close(gattc_if_, br.conn_id());
+        on_bridge_disconnected(br);
+    }
+}
 
-        esp_ble_gattc_register_for_notify(gattc_if_, bridge_bda_, char_low_handle_);
-        esp_ble_gattc_register_for_notify(gattc_if_, bridge_bda_, char_high_handle_);
+void AvionMeshHub::on_bridge_ready(BridgeConnection &br) {
+    uint32_t now = esphome::millis();
+    bool mesh_was_ready = ble_state_ == BleState::Ready;
+    br.set_ready(now);
+    last_connect_ms_ = now - br.connect_started_ms();
+    last_connect_cached_ = br.from_cache();
+    if (!mesh_was_ready) {
+        if (boot_to_ready_ms_ == 0) {
+            boot_to_ready_ms_ = now - boot_ms_;
+            ESP_LOGI(TAG, "Boot to Ready: %ums", boot_to_ready_ms_);
+        } else {
+            reconnect_to_ready_ms_ = now - mesh_down_ms_;
+            ESP_LOGI(TAG, "Reconnect to Ready: %ums", reconnect_to_ready_ms_);
+        }
+    }
+    ESP_LOGI(TAG, "Bridge %u ready (%zu of %u links up)", br.index(), ready_bridges(), max_bridges_);
+    if (failover_pending_) {
+        uint32_t took = now - failover_start_ms_;
+        failover_pending_ = false;
+        failovers_++;
+        failover_last_ms_ = took;
+        failover_total_ms_ += took;
+        if (took > failover_max_ms_)
+            failover_max_ms_ = took;
+        ESP_LOGI(TAG, "Failover to %s took %ums", br.address().c_str(), took);
+    }
+    refresh_ble_state();
+    apply_conn_profile(br, ConnProfile::Idle);
+    /* A roam target is up: release the link it replaces */
+    if (roam_from_ >= 0 && roam_from_ != br.index() && bridges_[roam_from_].ready()) {
+        auto &old = bridges_[roam_from_];
+        ESP_LOGI(TAG, "Roamed to %s, releasing bridge %u", br.address().c_str(), old.index());
+        esp_ble_gattc_close(gattc_if_, old.conn_id());
+    }
+    /* Bring up the next link, if any slot is still free */
+    connect_next_bridge();
+}
 
-        ble_state_ = BleState::Ready;
-        /* Mesh is now fully operational (crypto + BLE connected) */
-        mesh_initialized_ = true;
-        ESP_LOGI(TAG, "BLE ready - mesh operational");
-    } else {
-        ESP_LOGE(TAG, "CSRMesh characteristics not found (LOW=0x%04X HIGH=0x%04X)",
-                 char_low_handle_, char_high_handle_);
-        esp_ble_gattc_close(gattc_if_, conn_id_);
-        on_disconnected();
+void AvionMeshHub::on_bridge_disconnected(BridgeConnection &br) {
+    uint32_t now = esphome::millis();
+    bool was_ready = br.ready();
+    if (connecting_bridge_ == br.index())
+        connecting_bridge_ = -1;
+    if (assoc_bridge_ == br.index() && associating_) {
+        associating_ = false;
+        csrmesh::associate_cancel(br.mesh_ctx());
+    }
+    bool roamed = roam_from_ == br.index();
+    if (roam_from_ >= 0) {
+        if (roamed)
+            roams_++;
+        else
+            ESP_LOGW(TAG, "Roam aborted: bridge %u dropped", br.index());
+        roam_from_ = -1;
+    }
+    // Rank this bridge out until a scan sees it again
+    mark_candidate_failed(br.bda());
+    if (was_ready && !roamed && !failover_pending_) {
+        failover_pending_ = true;
+        failover_start_ms_ = now;
     }
+    br.on_disconnect();
+
+    if (was_ready && ready_bridges() == 0)
+        on_disconnected();
+    else
+        refresh_ble_state();
+
+    /* Fail over straight to the next ranked candidate, no rescan */
+    reconnect_at_ms_ = now;
+    connect_next_bridge();
 }
 
 void AvionMeshHub::on_disconnected() {
-    char_low_handle_ = 0;
-    char_high_handle_ = 0;
+    mesh_down_ms_ = esphome::millis();
+    acks_.clear();
+    // State may change unseen while the mesh is unreachable: read all again
+    refresh_.stop(mesh_down_ms_);
+    refresh_.forget_all();
+    if (profiler_.running()) {
+        profiler_.cancel();
+        send_response("{\"action\":\"profile_latency\",\"status\":\"error\",\"message\":\"disconnected\"}");
+    }
+    bulk_until_ms_ = 0;
+    interactive_until_ms_ = 0;
     mqtt_subscribed_ = false;
     initial_read_done_ = false;
     time_synced_ = false;
 
     if (associating_) {
         associating_ = false;
-        csrmesh::associate_cancel(mesh_ctx_);
+        if (assoc_bridge_ >= 0)
+            csrmesh::associate_cancel(bridges_[assoc_bridge_].mesh_ctx());
     }
 
-    ble_state_ = BleState::Disconnected;
-    reconnect_at_ms_ = esphome::millis() + RECONNECT_DELAY_MS;
-    update_mesh_initialized();
-    ESP_LOGI(TAG, "Will reconnect in %ums", RECONNECT_DELAY_MS);
+    refresh_ble_state();
+    ESP_LOGW(TAG, "All bridge links down");
 }
 
 /* ---- Crypto initialization ---- */
@@ -388,22 +914,25 @@ bool AvionMeshHub::init_crypto() {
         return false;
     }
 
-    auto ble_write_fn = [this](csrmesh::Characteristic ch, const uint8_t *data,
-                               size_t len, bool response) -> int {
-        return ble_write(ch, data, len, response);
-    };
+    for (auto &br : bridges_) {
+        uint8_t idx = br.index();
+        auto ble_write_fn = [this, idx](csrmesh::Characteristic ch, const uint8_t *data,
+                                        size_t len, bool response) -> int {
+            return bridges_[idx].write(ch, data, len, response, esphome::millis());
+        };
 
-    auto err = csrmesh::init(mesh_ctx_, ble_write_fn, db_.passphrase().c_str());
-    if (err != csrmesh::Error::Ok) {
-        ESP_LOGE(TAG, "csrmesh::init failed: %d", static_cast<int>(err));
-        return false;
-    }
+        auto err = csrmesh::init(br.mesh_ctx(), ble_write_fn, db_.passphrase().c_str());
+        if (err != csrmesh::Error::Ok) {
+            ESP_LOGE(TAG, "csrmesh::init failed: %d", static_cast<int>(err));
+            return false;
+        }
 
-    csrmesh::set_rx_callback(mesh_ctx_, [this](uint16_t mcp_source, uint16_t crypto_source,
-                                                uint8_t opcode, const uint8_t *payload,
-                                                size_t payload_len) {
-        on_mesh_rx(mcp_source, crypto_source, opcode, payload, payload_len);
-    });
+        csrmesh::set_rx_callback(br.mesh_ctx(), [this, idx](uint16_t mcp_source, uint16_t crypto_source,
+                                                            uint8_t opcode, const uint8_t *payload,
+                                                            size_t payload_len) {
+            on_bridge_rx(idx, mcp_source, crypto_source, opcode, payload, payload_len);
+        });
+    }
 
     crypto_initialized_ = true;
     ESP_LOGI(TAG, "CSRMesh crypto initialized");
@@ -422,17 +951,79 @@ void AvionMeshHub::update_mesh_initialized() {
                  crypto_initialized_, static_cast<int>(ble_state_));
     }
 
-    if (mesh_initialized_ != was_initialized) {
-        char buf[128];
-        snprintf(buf, sizeof(buf),
-                 "{\"ble_state\":%u,\"mesh_initialized\":%s,\"rx_count\":%u}",
-                 static_cast<uint8_t>(ble_state_),
-                 mesh_initialized_ ? "true" : "false",
-                 rx_count_);
-        do_sse_emit("meta", buf);
+    if (mesh_initialized_ != was_initialized)
+        do_sse_emit("meta", meta_json());
+}
+
+std::string AvionMeshHub::meta_json() {
+    auto *br = primary_bridge();
+    char buf[224];
+    snprintf(buf, sizeof(buf),
+             "{\"ble_state\":%u,\"mesh_initialized\":%s,\"rx_count\":%u,\"bridges\":%zu,"
+             "\"conn_profile\":\"%s\",\"conn_interval_ms\":%.2f}",
+             static_cast<uint8_t>(ble_state_),
+             mesh_initialized_ ? "true" : "false",
+             rx_count_, ready_bridges(),
+             conn_profile_name(br ? br->profile() : ConnProfile::Idle),
+             br ? br->conn_interval() * 1.25f : 0.0f);
+    return buf;
+}
+
+/* ---- Connection parameter profiles ---- */
+
+const char *AvionMeshHub::conn_profile_name(ConnProfile profile) {
+    switch (profile) {
+    case ConnProfile::Idle:        return "idle";
+    case ConnProfile::Interactive: return "interactive";
+    case ConnProfile::Bulk:        return "bulk";
+    }
+    return "unknown";
+}
+
+void AvionMeshHub::hold_bulk_profile(uint32_t duration_ms) {
+    uint32_t until = esphome::millis() + duration_ms;
+    if (static_cast<int32_t>(until - bulk_until_ms_) > 0)
+        bulk_until_ms_ = until;
+    // Switch before the burst goes out rather than on the next loop
+    update_conn_profile();
+}
+
+void AvionMeshHub::update_conn_profile() {
+    if (ble_state_ != BleState::Ready)
+        return;
+
+    uint32_t now = esphome::millis();
+    size_t backlog = tx_.depth(TxClass::StateRead) + tx_.depth(TxClass::Provisioning);
+    if (backlog > BULK_BACKLOG_DEPTH)
+        bulk_until_ms_ = now + BULK_RELAX_MS;
+
+    /* Light control gets the shortest interval even during a bulk burst */
+    ConnProfile want = ConnProfile::Idle;
+    if (static_cast<int32_t>(interactive_until_ms_ - now) > 0)
+        want = ConnProfile::Interactive;
+    else if (static_cast<int32_t>(bulk_until_ms_ - now) > 0)
+        want = ConnProfile::Bulk;
+    for (auto &br : bridges_) {
+        if (!br.ready() || br.profile() == want ||
+            now - br.profile_changed_ms() < CONN_UPDATE_MIN_GAP_MS)
+            continue;
+        apply_conn_profile(br, want);
     }
 }
 
+void AvionMeshHub::apply_conn_profile(BridgeConnection &br, ConnProfile profile) {
+    const ConnParams *p = &CONN_PARAMS_IDLE;
+    if (profile == ConnProfile::Interactive)
+        p = &CONN_PARAMS_INTERACTIVE;
+    else if (profile == ConnProfile::Bulk)
+        p = &CONN_PARAMS_BULK;
+    if (!br.request_profile(profile, *p, esphome::millis()))
+        return;
+    ESP_LOGD(TAG, "Bridge %u: requesting %s connection profile", br.index(),
+             conn_profile_name(profile));
+    do_sse_emit("meta", meta_json());
+}
+
 /* ---- Main loop ---- */
 
 void AvionMeshHub::loop() {
@@ -452,24 +1043,45 @@ void AvionMeshHub::loop() {
 #endif
 
     /* Process deferred web requests on the main loop */
-    if (pending_discover_mesh_) {
-        pending_discover_mesh_ = false;
-        handle_discover_mesh();
-    }
-    if (pending_scan_unassoc_) {
-        pending_scan_unassoc_ = false;
-        handle_scan_unassociated();
-    }
-    if (pending_examine_) {
-        pending_examine_ = false;
-        handle_examine_device(pending_examine_id_);
-    }
-    if (pending_claim_auto_) {
-        pending_claim_auto_ = false;
-        handle_claim_device_auto();
-    }
+    {
+        SourceScope web(*this, TxSource::Web);
+        if (pending_discover_mesh_) {
+            pending_discover_mesh_ = false;
+            handle_discover_mesh();
+        }
+        if (pending_scan_unassoc_) {
+            pending_scan_unassoc_ = false;
+            handle_scan_unassociated();
+        }
+        if (pending_examine_) {
+            pending_examine_ = false;
+            handle_examine_device(pending_examine_id_);
+        }
+        if (pending_claim_auto_) {
+            pending_claim_auto_ = false;
+            handle_claim_device_auto();
+        }
 
-    process_deferred_actions();
+        process_deferred_actions();
+    }
+    flush_brightness_windows();
+    if (ble_state_ == BleState::Ready) {
+        update_conn_profile();
+        limiter_.poll(esphome::millis());
+        acks_.poll(esphome::millis());
+        profiler_.poll(esphome::millis());
+        // One read queued at a time, so the budget also bounds the backlog
+        if (tx_.depth(TxClass::StateRead) == 0)
+            refresh_.poll(db_, esphome::millis());
+        maintain_links(esphome::millis());
+    }
+    for (auto &br : bridges_)
+        if (br.ready())
+            br.pump(esphome::millis());
+    tx_.poll(esphome::millis());
+    flush_dirty_states();
+    pump_discovery(esphome::millis());
+    discovery_.config_hashes().poll(esphome::millis());
 
 #ifdef USE_ESP32
     /* Defer GATTC registration until esp32_ble has fully initialized BLE */
@@ -477,9 +1089,13 @@ void AvionMeshHub::loop() {
         esp_ble_gattc_app_register(0);
     }
 
-    if (ble_state_ == BleState::Disconnected &&
-        esphome::millis() >= reconnect_at_ms_) {
-        start_scan();
+    /* Fill free bridge slots: next scan candidate first, rescan when none left */
+    if (gattc_registered_ && !scanning_ && connecting_bridge_ < 0 &&
+        ready_bridges() < max_bridges_ && esphome::millis() >= reconnect_at_ms_) {
+        if (next_candidate())
+            connect_next_bridge();
+        else
+            start_scan();
     }
 
     if (!mgmt_subscribed_) {
@@ -495,6 +1111,14 @@ void AvionMeshHub::loop() {
     }
 #endif
 
+    {
+        auto *mqtt = esphome::mqtt::global_mqtt_client;
+        bool connected = mqtt && mqtt->is_connected();
+        if (connected && !mqtt_connected_)
+            on_mqtt_connected();
+        mqtt_connected_ = connected;
+    }
+
     if (!mqtt_subscribed_ && ble_state_ == BleState::Ready) {
         auto *mqtt = esphome::mqtt::global_mqtt_client;
         if (mqtt && mqtt->is_connected()) {
@@ -507,10 +1131,7 @@ void AvionMeshHub::loop() {
     if (mqtt_subscribed_ && !initial_read_done_) {
         initial_read_done_ = true;
         this->set_timeout("initial_read", 2000, [this]() {
-            read_all_dimming();
-            this->set_timeout("initial_color_read", 1000, [this]() {
-                read_all_color();
-            });
+            refresh_.start(esphome::millis());
         });
     }
 
@@ -521,7 +1142,9 @@ void AvionMeshHub::loop() {
         });
     }
 
-    csrmesh::poll(mesh_ctx_, esphome::millis());
+    for (auto &br : bridges_)
+        if (br.active())
+            csrmesh::poll(br.mesh_ctx(), esphome::millis());
 
     if (associating_) {
         if (csrmesh::protocol::is_complete(proto_ctx_)) {
@@ -542,7 +1165,8 @@ void AvionMeshHub::loop() {
             ESP_LOGE(TAG, "Association timed out (state=%s)",
                      csrmesh::protocol::state_name(proto_ctx_.state));
             associating_ = false;
-            csrmesh::associate_cancel(mesh_ctx_);
+            if (assoc_bridge_ >= 0)
+                csrmesh::associate_cancel(bridges_[assoc_bridge_].mesh_ctx());
             send_response("{\"action\":\"claim_device\",\"status\":\"error\",\"message\":\"timeout\"}");
         }
     }
@@ -563,22 +1187,18 @@ void AvionMeshHub::process_deferred_actions() {
         switch (act.type) {
         case DeferredAction::Control:
             if (act.brightness >= 0) {
-                Command cmd;
-                cmd_brightness(act.id1, static_cast<uint8_t>(act.brightness), cmd);
-                do_mesh_send(cmd);
+                send_brightness(act.id1, static_cast<uint8_t>(act.brightness));
                 auto &state = device_states_[act.id1];
                 state.brightness = static_cast<uint8_t>(act.brightness);
                 state.brightness_known = true;
-                publish_device_state(act.id1);
+                mark_state_dirty(act.id1);
             }
             if (act.color_temp > 0) {
-                Command cmd;
-                cmd_color_temp(act.id1, static_cast<uint16_t>(act.color_temp), cmd);
-                do_mesh_send(cmd);
+                transmit_color_temp(act.id1, static_cast<uint16_t>(act.color_temp));
                 auto &state = device_states_[act.id1];
                 state.color_temp = static_cast<uint16_t>(act.color_temp);
                 state.color_temp_known = true;
-                publish_device_state(act.id1);
+                mark_state_dirty(act.id1);
             }
             break;
 
@@ -675,6 +1295,7 @@ void AvionMeshHub::process_deferred_actions() {
 
         case DeferredAction::Import: {
             int added_devices = 0, added_groups = 0;
+            hold_bulk_profile(BULK_RELAX_MS);
             esphome::json::parse_json(act.body, [&](JsonObject root) -> bool {
                 if (root["reset"] | false) {
                     ESP_LOGI(TAG, "Import with reset: clearing existing data");
@@ -685,6 +1306,7 @@ void AvionMeshHub::process_deferred_actions() {
                     db_.clear();
                     db_.load();
                     device_states_.clear();
+                    latch_.invalidate();
                 }
 
                 if (root["passphrase"].is<const char *>()) {
@@ -729,7 +1351,7 @@ void AvionMeshHub::process_deferred_actions() {
                             db_.add_device_to_group(member_id, group_id);
                             Command cmd;
                             cmd_insert_group(member_id, group_id, cmd);
-                            do_mesh_send(cmd);
+                            mesh_send(cmd, TxClass::Provisioning);
                         }
                     }
                 }
@@ -787,32 +1409,7 @@ void AvionMeshHub::process_deferred_actions() {
                             discovery_.publish_light(id, grp->name, true, true);
                     }
                 }
-                /* Subscribe MQTT commands */
-                {
-                    bool has_dim = true, has_ct = true;
-                    auto *dev = db_.find_device(id);
-                    if (dev) {
-                        has_dim = has_dimming(dev->product_type);
-                        has_ct = has_color_temp(dev->product_type);
-                    }
-                    do_mqtt_subscribe(discovery_.command_topic(id),
-                                      [this, id](const std::string &, const std::string &payload) {
-                                          on_switch_command(id, payload);
-                                      });
-                    if (has_dim) {
-                        do_mqtt_subscribe(discovery_.brightness_command_topic(id),
-                                          [this, id](const std::string &, const std::string &payload) {
-                                              on_brightness_command(id, payload);
-                                          });
-                    }
-                    if (has_ct) {
-                        do_mqtt_subscribe(discovery_.color_temp_command_topic(id),
-                                          [this, id](const std::string &, const std::string &payload) {
-                                              on_color_temp_command(id, payload);
-                                          });
-                    }
-                }
-                publish_device_state(id);
+                mark_state_dirty(id, true);
             } else {
                 discovery_.remove_light(id);
             }
@@ -845,23 +1442,29 @@ void AvionMeshHub::process_deferred_actions() {
     }
 }
 
-/* ---- BLE write ---- */
-
-int AvionMeshHub::ble_write(csrmesh::Characteristic ch, const uint8_t *data,
-                              size_t len, bool response) {
-    if (ble_state_ != BleState::Ready || !char_low_handle_ || !char_high_handle_)
-        return -1;
+/* ---- Bridge TX / RX ---- */
 
-    uint16_t handle = (ch == csrmesh::Characteristic::Low) ? char_low_handle_
-                                                            : char_high_handle_;
+void AvionMeshHub::send_on(BridgeConnection &br, const Command &cmd) {
+    // Every link encrypts with the same keys; keep one sequence across them
+    br.mesh_ctx().mcp_seq = mcp_seq_;
+    if (is_disassociate(cmd))
+        csrmesh::disassociate(br.mesh_ctx(), cmd.dest_id);
+    else
+        send_cmd(br.mesh_ctx(), cmd);
+    mcp_seq_ = br.mesh_ctx().mcp_seq;
+}
 
-    auto err = esp_ble_gattc_write_char(
-        gattc_if_, conn_id_, handle,
-        len, const_cast<uint8_t *>(data),
-        response ? ESP_GATT_WRITE_TYPE_RSP : ESP_GATT_WRITE_TYPE_NO_RSP,
-        ESP_GATT_AUTH_REQ_NONE);
+void AvionMeshHub::on_bridge_rx(uint8_t bridge, uint16_t mcp_source, uint16_t crypto_source,
+                                uint8_t opcode, const uint8_t *payload, size_t payload_len) {
+    // Every relayed copy took air time, so the meter sees them before dedupe
+    airtime_.on_rx(payload, payload_len, esphome::millis());
+    if (!rx_dedupe_.accept(bridge, mcp_source, crypto_source, opcode, payload, payload_len,
+                           esphome::millis()))
+        return;
 
-    return (err == ESP_OK) ? 0 : -1;
+    rx_bridge_ = static_cast<int8_t>(bridge);
+    on_mesh_rx(mcp_source, crypto_source, opcode, payload, payload_len);
+    rx_bridge_ = -1;
 }
 
 /* ---- Mesh RX ---- */
@@ -873,6 +1476,10 @@ void AvionMeshHub::on_mesh_rx(uint16_t mcp_source, uint16_t crypto_source,
     uint16_t src = (mcp_source == 0x8000) ? crypto_source : mcp_source;
     ESP_LOGD(TAG, "RX #%u: src=%u opcode=0x%02X len=%zu", rx_count_, src, opcode, payload_len);
 
+    if (profiler_.running() && opcode == MODEL_OPCODE && mcp_source != 0 &&
+        payload_len >= 10 && payload[0] == static_cast<uint8_t>(Verb::Ping))
+        profiler_.on_reply(src, esphome::millis());
+
     if ((discovering_mesh_ || examining_) && opcode == MODEL_OPCODE &&
         payload_len >= 10 && payload[0] == static_cast<uint8_t>(Verb::Ping)) {
         uint16_t device_id = (mcp_source == 0x8000) ? crypto_source : mcp_source;
@@ -953,7 +1560,14 @@ void AvionMeshHub::on_mesh_rx(uint16_t mcp_source, uint16_t crypto_source,
         state.color_temp_known = true;
     }
 
-    publish_device_state(status.avid);
+    uint32_t now = esphome::millis();
+    refresh_.on_report(status.avid, now);
+    if (status.has_brightness)
+        acks_.on_report(status.avid, AckAttr::Brightness, status.brightness, now);
+    if (status.has_color_temp)
+        acks_.on_report(status.avid, AckAttr::ColorTemp, status.color_temp, now);
+
+    mark_state_dirty(status.avid);
     check_group_state_latch(status.avid);
 }
 
@@ -961,19 +1575,35 @@ void AvionMeshHub::on_mesh_rx(uint16_t mcp_source, uint16_t crypto_source,
 
 void AvionMeshHub::on_mqtt_command(const std::string &payload) {
     ESP_LOGI(TAG, "Management command: %s", payload.c_str());
+    SourceScope source(*this, TxSource::Management);
 
     esphome::json::parse_json(payload, [this](JsonObject root) -> bool {
         std::string action = root["action"] | "";
 
         if (action == "status") {
-            char buf[192];
+            char buf[256];
             snprintf(buf, sizeof(buf),
-                     "{\"action\":\"status\",\"ble_state\":%u,\"devices\":%zu,\"groups\":%zu,\"rx_count\":%u}",
-                     static_cast<uint8_t>(ble_state_), db_.devices().size(), db_.groups().size(), rx_count_);
+                     "{\"action\":\"status\",\"ble_state\":%u,\"devices\":%zu,\"groups\":%zu,\"rx_count\":%u,"
+                     "\"conn_profile\":\"%s\",\"conn_interval_ms\":%.2f}",
+                     static_cast<uint8_t>(ble_state_), db_.devices().size(), db_.groups().size(), rx_count_,
+                     conn_profile_name(primary_bridge() ? primary_bridge()->profile() : ConnProfile::Idle),
+                     primary_bridge() ? primary_bridge()->conn_interval() * 1.25f : 0.0f);
             send_response(buf);
             return true;
         }
 
+        if (action == "stats") {
+            send_response("{\"action\":\"stats\"," + stats_json().substr(1));
+            return true;
+        }
+
+        if (action == "resync_discovery") {
+            /* e.g. after the broker lost its retained messages */
+            publish_all_discovery(true);
+            send_response("{\"action\":\"resync_discovery\",\"status\":\"ok\"}");
+            return true;
+        }
+
         if (ble_state_ != BleState::Ready) {
             char buf[128];
             snprintf(buf, sizeof(buf),
@@ -1010,18 +1640,17 @@ void AvionMeshHub::on_mqtt_command(const std::string &payload) {
                 root["product_type"] | 0u);
         } else if (action == "examine_device") {
             handle_examine_device(root["avion_id"] | 0u);
+        } else if (action == "profile_latency") {
+            handle_profile_latency(root["avion_id"] | 0u, root["rounds"] | 3u);
         } else if (action == "set_mesh_brightness") {
-            Command cmd;
-            cmd_brightness(0, root["brightness"] | 0u, cmd);
-            do_mesh_send(cmd);
+            send_brightness(0, root["brightness"] | 0u);
         } else if (action == "set_mesh_color_temp") {
-            Command cmd;
-            cmd_color_temp(0, root["kelvin"] | 3000u, cmd);
-            do_mesh_send(cmd);
+            transmit_color_temp(0, root["kelvin"] | 3000u);
         } else if (action == "sync_time") {
             sync_time();
         } else if (action == "read_all") {
             read_all_dimming();
+            this->set_timeout("read_all_color", 1000, [this]() { read_all_color(); });
         } else {
             ESP_LOGW(TAG, "Unknown action: %s", action.c_str());
             return false;
@@ -1033,10 +1662,14 @@ void AvionMeshHub::on_mqtt_command(const std::string &payload) {
 void AvionMeshHub::handle_scan_unassociated() {
     ESP_LOGI(TAG, "Starting unassociated device scan...");
 
+    auto *br = primary_bridge();
+    if (!br)
+        return;
+    assoc_bridge_ = static_cast<int8_t>(br->index());
     scanning_unassociated_ = true;
     scan_uuid_hashes_.clear();
 
-    csrmesh::discover_start(mesh_ctx_, [this](const uint8_t *uuid, size_t uuid_len,
+    csrmesh::discover_start(br->mesh_ctx(), [this](const uint8_t *uuid, size_t uuid_len,
                                                uint32_t uuid_hash) {
         scan_uuid_hashes_.push_back(uuid_hash);
 
@@ -1047,7 +1680,8 @@ void AvionMeshHub::handle_scan_unassociated() {
     });
 
     this->set_timeout("scan_stop", 5000, [this]() {
-        csrmesh::discover_stop(mesh_ctx_);
+        if (assoc_bridge_ >= 0)
+            csrmesh::discover_stop(bridges_[assoc_bridge_].mesh_ctx());
 
         std::string json = "{\"uuid_hashes\":[";
         for (size_t i = 0; i < scan_uuid_hashes_.size(); i++) {
@@ -1084,7 +1718,14 @@ void AvionMeshHub::handle_claim_device(uint32_t uuid_hash, uint16_t device_id,
         return;
     }
 
-    err = csrmesh::associate_start(mesh_ctx_, &proto_ctx_, uuid_hash, device_id);
+    auto *br = primary_bridge();
+    if (!br) {
+        csrmesh::protocol::cleanup(proto_ctx_);
+        send_response("{\"action\":\"claim_device\",\"status\":\"error\",\"message\":\"ble_not_ready\"}");
+        return;
+    }
+    assoc_bridge_ = static_cast<int8_t>(br->index());
+    err = csrmesh::associate_start(br->mesh_ctx(), &proto_ctx_, uuid_hash, device_id);
     if (err != csrmesh::Error::Ok) {
         ESP_LOGE(TAG, "Associate start failed: %d", static_cast<int>(err));
         csrmesh::protocol::cleanup(proto_ctx_);
@@ -1128,12 +1769,13 @@ void AvionMeshHub::handle_claim_device_auto() {
 
     discovering_mesh_ = true;
     discovered_devices_.clear();
+    hold_bulk_profile(DISCOVER_WINDOW_MS);
 
     Command cmd;
     cmd_ping(0, cmd);
-    do_mesh_send(cmd);
+    mesh_send(cmd, TxClass::Provisioning);
 
-    this->set_timeout("auto_claim_scan", 5000, [this]() {
+    this->set_timeout("auto_claim_scan", DISCOVER_WINDOW_MS, [this]() {
         discovering_mesh_ = false;
 
         uint16_t device_id = next_device_id();
@@ -1159,10 +1801,21 @@ void AvionMeshHub::handle_unclaim_device(uint16_t avion_id) {
 
     if (associating_) {
         associating_ = false;
-        csrmesh::associate_cancel(mesh_ctx_);
+        if (assoc_bridge_ >= 0)
+            csrmesh::associate_cancel(bridges_[assoc_bridge_].mesh_ctx());
     }
 
-    csrmesh::disassociate(mesh_ctx_, avion_id);
+    mesh_send(disassociate_cmd(avion_id), TxClass::Provisioning);
+
+    // Nothing may keep retrying, refreshing or publishing a device that is gone
+    acks_.forget(avion_id);
+    limiter_.cancel(avion_id, AckAttr::Brightness);
+    limiter_.cancel(avion_id, AckAttr::ColorTemp);
+    brightness_windows_.erase(avion_id);
+    refresh_.forget(avion_id);
+    device_states_.erase(avion_id);
+    dirty_states_.erase(std::remove(dirty_states_.begin(), dirty_states_.end(), avion_id),
+                        dirty_states_.end());
     db_.remove_device(avion_id);
     discovery_.remove_light(avion_id);
 
@@ -1194,7 +1847,7 @@ void AvionMeshHub::handle_delete_group(uint16_t group_id) {
 void AvionMeshHub::handle_add_to_group(uint16_t avion_id, uint16_t group_id) {
     Command cmd;
     cmd_insert_group(avion_id, group_id, cmd);
-    do_mesh_send(cmd);
+    mesh_send(cmd, TxClass::Provisioning);
     db_.add_device_to_group(avion_id, group_id);
 
     char buf[128];
@@ -1207,7 +1860,7 @@ void AvionMeshHub::handle_add_to_group(uint16_t avion_id, uint16_t group_id) {
 void AvionMeshHub::handle_remove_from_group(uint16_t avion_id, uint16_t group_id) {
     Command cmd;
     cmd_delete_group(avion_id, group_id, cmd);
-    do_mesh_send(cmd);
+    mesh_send(cmd, TxClass::Provisioning);
     db_.remove_device_from_group(avion_id, group_id);
 
     char buf[128];
@@ -1226,12 +1879,13 @@ void AvionMeshHub::handle_discover_mesh() {
     ESP_LOGI(TAG, "Starting mesh discovery (broadcast PING)...");
     discovering_mesh_ = true;
     discovered_devices_.clear();
+    hold_bulk_profile(DISCOVER_WINDOW_MS);
 
     Command cmd;
     cmd_ping(0, cmd);
-    do_mesh_send(cmd);
+    mesh_send(cmd, TxClass::Provisioning);
 
-    this->set_timeout("discover_stop", 5000, [this]() {
+    this->set_timeout("discover_stop", DISCOVER_WINDOW_MS, [this]() {
         std::string devices_arr = "[";
         for (size_t i = 0; i < discovered_devices_.size(); i++) {
             auto &d = discovered_devices_[i];
@@ -1294,7 +1948,7 @@ void AvionMeshHub::handle_examine_device(uint16_t avion_id) {
 
     Command cmd;
     cmd_ping(avion_id, cmd);
-    do_mesh_send(cmd);
+    mesh_send(cmd, TxClass::Provisioning);
 
     this->set_timeout("examine_timeout", 5000, [this]() {
         if (examining_) {
@@ -1313,6 +1967,38 @@ void AvionMeshHub::handle_examine_device(uint16_t avion_id) {
     });
 }
 
+void AvionMeshHub::handle_profile_latency(uint16_t avion_id, uint8_t rounds) {
+    if (profiler_.running()) {
+        send_response("{\"action\":\"profile_latency\",\"status\":\"error\",\"message\":\"busy\"}");
+        return;
+    }
+
+    std::vector<uint16_t> targets;
+    if (avion_id != 0) {
+        targets.push_back(avion_id);
+    } else {
+        for (auto &dev : db_.devices())
+            targets.push_back(dev.avion_id);
+    }
+    rounds = std::clamp<uint8_t>(rounds, 1, 10);
+    if (!profiler_.start(targets, rounds, esphome::millis())) {
+        send_response("{\"action\":\"profile_latency\",\"status\":\"error\",\"message\":\"no_devices\"}");
+        return;
+    }
+
+    char buf[128];
+    snprintf(buf, sizeof(buf),
+             "{\"action\":\"profile_latency\",\"status\":\"started\",\"devices\":%zu,\"rounds\":%u}",
+             targets.size(), rounds);
+    send_response(buf);
+}
+
+void AvionMeshHub::on_profile_done() {
+    std::string devices = profiler_.results_json();
+    do_sse_emit("latency", "{\"devices\":" + devices + "}");
+    send_response("{\"action\":\"profile_latency\",\"status\":\"done\",\"devices\":" + devices + "}");
+}
+
 void AvionMeshHub::handle_set_passphrase(const std::string &passphrase) {
     ESP_LOGI(TAG, "Setting passphrase (length=%zu)", passphrase.size());
     db_.set_passphrase(passphrase);
@@ -1330,9 +2016,8 @@ void AvionMeshHub::handle_set_passphrase(const std::string &passphrase) {
         return;
     }
 
-    /* Trigger reconnection if disconnected */
-    if (ble_state_ == BleState::Disconnected || ble_state_ == BleState::Idle) {
-        ble_state_ = BleState::Disconnected;
+    /* Trigger reconnection if no bridge is up */
+    if (ready_bridges() == 0) {
         reconnect_at_ms_ = esphome::millis();  /* Reconnect immediately */
         ESP_LOGI(TAG, "Triggering BLE reconnection after passphrase set");
     }
@@ -1361,9 +2046,8 @@ void AvionMeshHub::handle_generate_passphrase() {
         return;
     }
 
-    /* Trigger reconnection if disconnected */
-    if (ble_state_ == BleState::Disconnected || ble_state_ == BleState::Idle) {
-        ble_state_ = BleState::Disconnected;
+    /* Trigger reconnection if no bridge is up */
+    if (ready_bridges() == 0) {
         reconnect_at_ms_ = esphome::millis();  /* Reconnect immediately */
         ESP_LOGI(TAG, "Triggering BLE reconnection after passphrase generated");
     }
@@ -1384,14 +2068,17 @@ void AvionMeshHub::handle_factory_reset() {
     for (auto &grp : db_.groups()) {
         discovery_.remove_light(grp.group_id);
     }
+    discovery_.config_hashes().clear();
 
-    /* Clear mesh context by reinitializing */
-    std::memset(&mesh_ctx_, 0, sizeof(mesh_ctx_));
+    /* Clear mesh contexts by reinitializing */
+    for (auto &br : bridges_)
+        br.clear_mesh_ctx();
     mesh_initialized_ = false;
     crypto_initialized_ = false;
 
     /* Clear database */
     db_.clear();
+    gatt_cache_.clear();
 
     /* Reload (empty) */
     db_.load();
@@ -1409,6 +2096,7 @@ void AvionMeshHub::handle_factory_reset() {
 /* ---- Light commands from MQTT (separate topics, bare payloads) ---- */
 
 void AvionMeshHub::on_switch_command(uint16_t avion_id, const std::string &payload) {
+    SourceScope source(*this, TxSource::Mqtt);
     uint8_t brightness;
     if (payload != "ON") {
         brightness = 0;
@@ -1420,112 +2108,386 @@ void AvionMeshHub::on_switch_command(uint16_t avion_id, const std::string &paylo
         brightness = (it != device_states_.end() && it->second.brightness > 0)
                      ? it->second.brightness : 255;
     }
-    Command cmd;
-    cmd_brightness(avion_id, brightness, cmd);
-    do_mesh_send(cmd);
+    // Explicit on/off bypasses the dim window, but must not be overtaken by a
+    // slider value still waiting for the window to close.
+    cancel_pending_brightness(avion_id);
+    transmit_brightness(avion_id, brightness);
     auto &state = device_states_[avion_id];
     state.brightness = brightness;
     state.brightness_known = true;
-    publish_device_state(avion_id);
+    mark_state_dirty(avion_id);
 }
 
 void AvionMeshHub::on_brightness_command(uint16_t avion_id, const std::string &payload) {
+    SourceScope source(*this, TxSource::Mqtt);
     uint8_t brightness = static_cast<uint8_t>(strtoul(payload.c_str(), nullptr, 10));
-
-    uint32_t now = esphome::millis();
-    auto it = last_brightness_ms_.find(avion_id);
-    if (it != last_brightness_ms_.end() &&
-        (now - it->second) < RAPID_DIM_THRESHOLD_MS) {
-        it->second = now;
-        auto &state = device_states_[avion_id];
-        state.brightness = brightness;
-        state.brightness_known = true;
-        publish_device_state(avion_id);
-        return;
-    }
-    last_brightness_ms_[avion_id] = now;
-
-    Command cmd;
-    cmd_brightness(avion_id, brightness, cmd);
-    do_mesh_send(cmd);
+    send_brightness(avion_id, brightness);
     auto &state = device_states_[avion_id];
     state.brightness = brightness;
     state.brightness_known = true;
-    publish_device_state(avion_id);
+    mark_state_dirty(avion_id);
 }
 
 void AvionMeshHub::on_color_temp_command(uint16_t avion_id, const std::string &payload) {
+    SourceScope source(*this, TxSource::Mqtt);
     uint16_t mireds = static_cast<uint16_t>(strtoul(payload.c_str(), nullptr, 10));
     uint16_t kelvin = mireds > 0 ? 1000000u / mireds : 3000;
-    Command cmd;
-    cmd_color_temp(avion_id, kelvin, cmd);
-    do_mesh_send(cmd);
+    transmit_color_temp(avion_id, kelvin);
     auto &state = device_states_[avion_id];
     state.color_temp = kelvin;
     state.color_temp_known = true;
-    publish_device_state(avion_id);
+    mark_state_dirty(avion_id);
 }
 
-/* ---- Helpers ---- */
+/* One JSON schema command carries state, brightness and color temp
+ * together, so ON + brightness is a single mesh write instead of a race. */
+void AvionMeshHub::on_json_command(uint16_t avion_id, const std::string &payload) {
+    SourceScope source(*this, TxSource::Mqtt);
+    esphome::json::parse_json(payload, [this, avion_id](JsonObject root) -> bool {
+        std::string on_off = root["state"] | "";
+        auto &state = device_states_[avion_id];
+        if (root["transition"].is<float>())
+            ESP_LOGD(TAG, "Transition for %u ignored: mesh writes apply immediately", avion_id);
+
+        if (on_off == "OFF") {
+            cancel_pending_brightness(avion_id);
+            transmit_brightness(avion_id, 0);
+            state.brightness = 0;
+            state.brightness_known = true;
+        } else if (root["brightness"].is<int>()) {
+            int value = root["brightness"] | 0;
+            uint8_t brightness = static_cast<uint8_t>(value < 0 ? 0 : value > 255 ? 255 : value);
+            send_brightness(avion_id, brightness);
+            state.brightness = brightness;
+            state.brightness_known = true;
+        } else if (on_off == "ON" && (!state.brightness_known || state.brightness == 0)) {
+            // Restore the last level, as on the switch topic. HA also sends
+            // "ON" with every color temp change; a light already on needs no
+            // brightness write for that.
+            uint8_t brightness = state.brightness > 0 ? state.brightness : 255;
+            cancel_pending_brightness(avion_id);
+            transmit_brightness(avion_id, brightness);
+            state.brightness = brightness;
+            state.brightness_known = true;
+        }
 
-void AvionMeshHub::publish_all_discovery() {
-    for (auto &dev : db_.devices()) {
-        if (!dev.mqtt_exposed)
-            continue;
-        bool has_dim = has_dimming(dev.product_type);
-        bool has_ct = has_color_temp(dev.product_type);
-        discovery_.publish_light(dev.avion_id, dev.name, has_dim, has_ct,
-                                  product_name(dev.product_type));
+        if (on_off != "OFF" && root["color_temp"].is<int>()) {
+            uint16_t mireds = root["color_temp"] | 0;
+            uint16_t kelvin = mireds > 0 ? 1000000u / mireds : 3000;
+            transmit_color_temp(avion_id, kelvin);
+            state.color_temp = kelvin;
+            state.color_temp_known = true;
+        }
+        mark_state_dirty(avion_id);
+        return true;
+    });
+}
+
+/* ---- Brightness coalescing ---- */
+
+void AvionMeshHub::send_brightness(uint16_t avion_id, uint8_t brightness) {
+    uint32_t now = esphome::millis();
+    auto it = brightness_windows_.find(avion_id);
+    if (it != brightness_windows_.end() &&
+        (now - it->second.opened_ms) < RAPID_DIM_THRESHOLD_MS) {
+        // Window still open: keep only the latest value for the trailing edge
+        it->second.pending_value = brightness;
+        it->second.pending = true;
+        return;
     }
-    for (auto &grp : db_.groups()) {
-        if (!grp.mqtt_exposed)
+    brightness_windows_[avion_id] = {now, 0, false};
+    transmit_brightness(avion_id, brightness);
+}
+
+void AvionMeshHub::cancel_pending_brightness(uint16_t avion_id) {
+    auto it = brightness_windows_.find(avion_id);
+    if (it != brightness_windows_.end())
+        it->second.pending = false;
+    // A slider value held back by the rate limiter is superseded too
+    limiter_.cancel(avion_id, AckAttr::Brightness);
+}
+
+void AvionMeshHub::flush_brightness_windows() {
+    uint32_t now = esphome::millis();
+    for (auto it = brightness_windows_.begin(); it != brightness_windows_.end();) {
+        auto &win = it->second;
+        if ((now - win.opened_ms) < RAPID_DIM_THRESHOLD_MS) {
+            ++it;
             continue;
-        discovery_.publish_light(grp.group_id, grp.name, true, true);
+        }
+        if (!win.pending) {
+            it = brightness_windows_.erase(it);
+            continue;
+        }
+        // Trailing edge: send the final value and open a fresh window so the
+        // mesh still sees at most one write per target per window.
+        ESP_LOGD(TAG, "Coalesced brightness %u -> %u", it->first, win.pending_value);
+        transmit_brightness(it->first, win.pending_value);
+        win.opened_ms = now;
+        win.pending = false;
+        ++it;
     }
-    if (mesh_mqtt_exposed_)
-        discovery_.publish_light(0, "All Lights", true, true, "Mesh Broadcast");
 }
 
-void AvionMeshHub::subscribe_all_commands() {
-    auto subscribe_light = [this](uint16_t id, bool has_brightness, bool has_ct) {
-        do_mqtt_subscribe(discovery_.command_topic(id),
-                          [this, id](const std::string &, const std::string &payload) {
-                              on_switch_command(id, payload);
-                          });
-        if (has_brightness) {
-            do_mqtt_subscribe(discovery_.brightness_command_topic(id),
-                              [this, id](const std::string &, const std::string &payload) {
-                                  on_brightness_command(id, payload);
-                              });
+/* ---- Acknowledged state writes ---- */
+
+void AvionMeshHub::transmit_brightness(uint16_t avion_id, uint8_t brightness) {
+    if (limiter_.admit(avion_id, AckAttr::Brightness, brightness, tx_source_, esphome::millis()))
+        write_brightness(avion_id, brightness);
+}
+
+void AvionMeshHub::transmit_color_temp(uint16_t avion_id, uint16_t kelvin) {
+    if (limiter_.admit(avion_id, AckAttr::ColorTemp, kelvin, tx_source_, esphome::millis()))
+        write_color_temp(avion_id, kelvin);
+}
+
+void AvionMeshHub::write_brightness(uint16_t avion_id, uint8_t brightness) {
+    Command cmd;
+    cmd_brightness(avion_id, brightness, cmd);
+    mesh_send(cmd, TxClass::Interactive);
+    track_ack(avion_id, AckAttr::Brightness, brightness, cmd);
+}
+
+void AvionMeshHub::write_color_temp(uint16_t avion_id, uint16_t kelvin) {
+    Command cmd;
+    cmd_color_temp(avion_id, kelvin, cmd);
+    mesh_send(cmd, TxClass::Interactive);
+    track_ack(avion_id, AckAttr::ColorTemp, kelvin, cmd);
+}
+
+void AvionMeshHub::track_ack(uint16_t target, AckAttr attr, uint16_t value, const Command &cmd) {
+    // Nothing reaches the mesh without a link, so there is nothing to confirm
+    if (ble_state_ != BleState::Ready)
+        return;
+
+    std::vector<uint16_t> members;
+    if (!db_.find_device(target)) {
+        auto capable = [&](uint16_t id) {
+            auto *dev = db_.find_device(id);
+            if (!dev)
+                return false;
+            return attr == AckAttr::Brightness ? has_dimming(dev->product_type)
+                                               : has_color_temp(dev->product_type);
+        };
+        if (target == 0) {
+            for (auto &dev : db_.devices())
+                if (capable(dev.avion_id))
+                    members.push_back(dev.avion_id);
+        } else if (auto *grp = db_.find_group(target)) {
+            for (auto mid : grp->member_ids)
+                if (capable(mid))
+                    members.push_back(mid);
         }
-        if (has_ct) {
-            do_mqtt_subscribe(discovery_.color_temp_command_topic(id),
-                              [this, id](const std::string &, const std::string &payload) {
-                                  on_color_temp_command(id, payload);
-                              });
+        if (members.empty())
+            return;  // no member could ever confirm it
+    }
+    acks_.track(target, attr, value, cmd, std::move(members), esphome::millis());
+}
+
+/* ---- Helpers ---- */
+
+void AvionMeshHub::publish_all_discovery(bool force) {
+    /* A new run (HA restart, import) starts over with the current set */
+    discovery_queue_.clear();
+    for (auto &dev : db_.devices())
+        if (dev.mqtt_exposed)
+            discovery_queue_.push_back(dev.avion_id);
+    for (auto &grp : db_.groups())
+        if (grp.mqtt_exposed)
+            discovery_queue_.push_back(grp.group_id);
+    if (mesh_mqtt_exposed_)
+        discovery_queue_.push_back(0);
+
+    discovery_total_ = discovery_queue_.size();
+    discovery_done_ = 0;
+    discovery_resume_ms_ = 0;
+    discovery_force_ = force;
+    discovery_run_active_ = true;
+    discovery_runs_++;
+    if (force && discovery_.device_discovery())
+        discovery_.invalidate_device_configs();
+    ESP_LOGI(TAG, "Publishing discovery for %zu entities%s", discovery_total_, force ? " (forced)" : "");
+    emit_discovery_progress();
+}
+
+bool AvionMeshHub::publish_discovery(uint16_t id) {
+    if (id == 0) {
+        if (!mesh_mqtt_exposed_)
+            return true;
+        return discovery_.publish_light(0, "All Lights", true, true, "Mesh Broadcast", discovery_force_);
+    }
+    if (auto *dev = db_.find_device(id)) {
+        if (!dev->mqtt_exposed)
+            return true;
+        return discovery_.publish_light(id, dev->name, has_dimming(dev->product_type),
+                                        has_color_temp(dev->product_type),
+                                        product_name(dev->product_type), discovery_force_);
+    }
+    if (auto *grp = db_.find_group(id)) {
+        if (!grp->mqtt_exposed)
+            return true;
+        return discovery_.publish_light(id, grp->name, true, true, "", discovery_force_);
+    }
+    return true;  // removed since it was queued
+}
+
+void AvionMeshHub::pump_discovery(uint32_t now) {
+    if (now < discovery_resume_ms_)
+        return;
+    if (discovery_queue_.empty()) {
+        flush_device_discovery(now);
+        return;
+    }
+
+    /* Device-based discovery only updates the component map here */
+    size_t per_tick = discovery_.device_discovery() ? DEVICE_COMPONENTS_PER_TICK : DISCOVERY_PER_TICK;
+    size_t sent = 0;
+    while (!discovery_queue_.empty() && sent < per_tick) {
+        if (!publish_discovery(discovery_queue_.front())) {
+            /* Client outbox is full; let it drain before trying this one again */
+            discovery_backpressure_++;
+            discovery_resume_ms_ = now + DISCOVERY_BACKOFF_MS;
+            break;
         }
-    };
+        discovery_queue_.pop_front();
+        discovery_done_++;
+        sent++;
+    }
+    if (sent == 0)
+        return;
+    if (discovery_queue_.empty())
+        ESP_LOGI(TAG, "Discovery published for %zu entities", discovery_total_);
+    emit_discovery_progress();
+}
 
-    for (auto &dev : db_.devices()) {
-        if (!dev.mqtt_exposed)
-            continue;
-        subscribe_light(dev.avion_id, has_dimming(dev.product_type),
-                        has_color_temp(dev.product_type));
+void AvionMeshHub::flush_device_discovery(uint32_t now) {
+    if (discovery_.device_configs_pending() && !discovery_.flush_device_configs()) {
+        discovery_backpressure_++;
+        discovery_resume_ms_ = now + DISCOVERY_BACKOFF_MS;
+        return;
     }
-    for (auto &grp : db_.groups()) {
-        if (!grp.mqtt_exposed)
+    if (!discovery_run_active_)
+        return;
+    /* Full run done: clear configs of the other mode, and chunks no longer needed */
+    discovery_run_active_ = false;
+    discovery_.retire_device_configs();
+}
+
+void AvionMeshHub::emit_discovery_progress() {
+    char buf[96];
+    snprintf(buf, sizeof(buf), "{\"done\":%u,\"total\":%u,\"backpressure\":%u}",
+             static_cast<unsigned>(discovery_done_), static_cast<unsigned>(discovery_total_),
+             discovery_backpressure_);
+    do_sse_emit("discovery_progress", buf);
+}
+
+void AvionMeshHub::republish_all_states() {
+    for (auto &kv : device_states_)
+        mark_state_dirty(kv.first, true);
+}
+
+void AvionMeshHub::on_mqtt_connected() {
+    if (device_states_.empty())
+        return;
+    ESP_LOGI(TAG, "MQTT connected, re-publishing %zu states", device_states_.size());
+    republish_all_states();
+}
+
+void AvionMeshHub::mark_state_dirty(uint16_t avion_id, bool force) {
+    auto it = device_states_.find(avion_id);
+    if (it == device_states_.end())
+        return;
+    state_marks_++;
+    latch_.on_level(db_, avion_id);
+    it->second.force_publish = it->second.force_publish || force;
+    if (it->second.dirty)
+        return;
+    it->second.dirty = true;
+    dirty_states_.push_back(avion_id);
+    state_flush_max_backlog_ = std::max(state_flush_max_backlog_, dirty_states_.size());
+}
+
+void AvionMeshHub::flush_dirty_states() {
+    size_t n = 0;
+    while (!dirty_states_.empty()) {
+        if (n == STATE_FLUSH_MAX) {
+            state_flush_deferred_++;
+            return;
+        }
+        uint16_t avion_id = dirty_states_.front();
+        dirty_states_.pop_front();
+        auto it = device_states_.find(avion_id);
+        if (it == device_states_.end())
             continue;
-        subscribe_light(grp.group_id, true, true);
+        bool force = it->second.force_publish;
+        it->second.dirty = false;
+        it->second.force_publish = false;
+        publish_device_state(avion_id, force);
+        state_flushes_++;
+        n++;
     }
-    if (mesh_mqtt_exposed_)
-        subscribe_light(0, true, true);
+}
+
+void AvionMeshHub::on_light_command(const std::string &topic, const std::string &payload) {
+    uint16_t id;
+    LightCommand cmd;
+    if (!discovery_.parse_command_topic(topic, id, cmd))
+        return;
+
+    /* The wildcard also delivers commands for entities that are not (or no
+     * longer) exposed, and attributes the light does not have */
+    bool exposed = false, has_dim = true, has_ct = true;
+    if (id == 0) {
+        exposed = mesh_mqtt_exposed_;
+    } else if (auto *dev = db_.find_device(id)) {
+        exposed = dev->mqtt_exposed;
+        has_dim = has_dimming(dev->product_type);
+        has_ct = has_color_temp(dev->product_type);
+    } else if (auto *grp = db_.find_group(id)) {
+        exposed = grp->mqtt_exposed;
+    }
+    if (!exposed) {
+        ESP_LOGD(TAG, "Ignoring MQTT command for unexposed %u", id);
+        mqtt_commands_ignored_++;
+        return;
+    }
+
+    if (discovery_.json_schema()) {
+        if (cmd == LightCommand::Switch)
+            on_json_command(id, payload);
+        return;
+    }
+    switch (cmd) {
+        case LightCommand::Switch:
+            on_switch_command(id, payload);
+            break;
+        case LightCommand::Brightness:
+            if (has_dim)
+                on_brightness_command(id, payload);
+            break;
+        case LightCommand::ColorTemp:
+            if (has_ct)
+                on_color_temp_command(id, payload);
+            break;
+    }
+}
+
+void AvionMeshHub::subscribe_all_commands() {
+    /* Two wildcard subscriptions for every light, exposed now or later,
+     * instead of up to three per entity */
+    auto cb = [this](const std::string &topic, const std::string &payload) {
+        on_light_command(topic, payload);
+    };
+    do_mqtt_subscribe(discovery_.switch_command_filter(), cb);
+    if (!discovery_.json_schema())
+        do_mqtt_subscribe(discovery_.attr_command_filter(), cb);
 
     mqtt_subscribed_ = true;
     ESP_LOGI(TAG, "MQTT subscriptions active");
 }
 
 void AvionMeshHub::send_response(const std::string &payload) {
-    do_mqtt_publish(discovery_.management_response_topic(), payload, false);
+    do_mqtt_publish(discovery_.management_response_topic().c_str(), payload.c_str(), false);
 }
 
 void AvionMeshHub::sync_time() {
@@ -1543,29 +2505,31 @@ void AvionMeshHub::sync_time() {
     cmd_set_date(static_cast<uint16_t>(t->tm_year + 1900),
                  static_cast<uint8_t>(t->tm_mon + 1),
                  static_cast<uint8_t>(t->tm_mday), cmd);
-    do_mesh_send(cmd);
+    mesh_send(cmd, TxClass::Housekeeping);
 
     cmd_set_time(static_cast<uint8_t>(t->tm_hour),
                  static_cast<uint8_t>(t->tm_min),
                  static_cast<uint8_t>(t->tm_sec), cmd);
-    do_mesh_send(cmd);
+    mesh_send(cmd, TxClass::Housekeeping);
 }
 
 void AvionMeshHub::read_all_dimming() {
     ESP_LOGI(TAG, "Broadcasting READ DIMMING");
+    hold_bulk_profile(REFRESH_BULK_MS);
     Command cmd;
     cmd_read_all_dimming(cmd);
-    do_mesh_send(cmd);
+    mesh_send(cmd, TxClass::StateRead);
 }
 
 void AvionMeshHub::read_all_color() {
     ESP_LOGI(TAG, "Broadcasting READ COLOR");
+    hold_bulk_profile(REFRESH_BULK_MS);
     Command cmd;
     cmd_read_all_color(cmd);
-    do_mesh_send(cmd);
+    mesh_send(cmd, TxClass::StateRead);
 }
 
-void AvionMeshHub::publish_device_state(uint16_t avion_id) {
+void AvionMeshHub::publish_device_state(uint16_t avion_id, bool force) {
     auto it = device_states_.find(avion_id);
     if (it == device_states_.end())
         return;
@@ -1594,12 +2558,15 @@ void AvionMeshHub::publish_device_state(uint16_t avion_id) {
         }
     }
 
-    if (mqtt_exposed) {
-        discovery_.publish_on_off_state(avion_id, state.brightness > 0);
-        discovery_.publish_brightness_state(avion_id, state.brightness);
+    if (mqtt_exposed && discovery_.json_schema()) {
+        discovery_.publish_json_state(avion_id, state.brightness, state.color_temp_known && supports_ct,
+                                      state.color_temp, force);
+    } else if (mqtt_exposed) {
+        discovery_.publish_on_off_state(avion_id, state.brightness > 0, force);
+        discovery_.publish_brightness_state(avion_id, state.brightness, force);
 
         if (state.color_temp_known && supports_ct)
-            discovery_.publish_color_temp_state(avion_id, state.color_temp);
+            discovery_.publish_color_temp_state(avion_id, state.color_temp, force);
     }
 
     {
@@ -1618,25 +2585,116 @@ void AvionMeshHub::publish_device_state(uint16_t avion_id) {
     }
 }
 
+void AvionMeshHub::mesh_send(const Command &cmd, TxClass cls) {
+    if (cls == TxClass::Interactive) {
+        last_interactive_ms_ = esphome::millis();
+        interactive_until_ms_ = last_interactive_ms_ + INTERACTIVE_RELAX_MS;
+        update_conn_profile();
+    }
+    tx_.enqueue(cmd, cls, esphome::millis(), tx_source_);
+}
+
+std::string AvionMeshHub::stats_json() {
+    std::string json = "{\"tx\":";
+    json += tx_.stats_json();
+
+    json += ",\"bridges\":[";
+    bool first = true;
+    for (auto &br : bridges_) {
+        if (br.index() >= max_bridges_ && !br.active())
+            continue;
+        if (!first)
+            json += ",";
+        json += br.stats_json();
+        first = false;
+    }
+    json += "],\"rx_duplicates\":";
+    json += std::to_string(rx_dedupe_.duplicates());
+    json += ",\"rx_dedupe\":";
+    json += rx_dedupe_.stats_json();
+
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+             ",\"mqtt_state\":{\"published\":%u,\"suppressed\":%u,\"failed\":%u,\"commands_ignored\":%u},"
+             "\"state_flush\":{\"marks\":%u,\"flushes\":%u,\"pending\":%u,\"max_backlog\":%u,"
+             "\"deferred_ticks\":%u}",
+             discovery_.states_published(), discovery_.states_suppressed(), discovery_.states_failed(),
+             mqtt_commands_ignored_, state_marks_,
+             state_flushes_, static_cast<unsigned>(dirty_states_.size()),
+             static_cast<unsigned>(state_flush_max_backlog_), state_flush_deferred_);
+    json += buf;
+
+    snprintf(buf, sizeof(buf),
+             ",\"discovery\":{\"runs\":%u,\"done\":%u,\"total\":%u,\"pending\":%u,\"backpressure\":%u,"
+             "\"published\":%u,\"skipped\":%u,\"bytes\":%u,\"hashes\":%u,\"chunks\":%u}",
+             discovery_runs_, static_cast<unsigned>(discovery_done_),
+             static_cast<unsigned>(discovery_total_), static_cast<unsigned>(discovery_queue_.size()),
+             discovery_backpressure_, discovery_.configs_published(), discovery_.configs_skipped(),
+             discovery_.config_bytes(), static_cast<unsigned>(discovery_.config_hashes().size()),
+             static_cast<unsigned>(discovery_.device_chunks()));
+    json += buf;
+
+    snprintf(buf, sizeof(buf),
+             ",\"failover\":{\"count\":%u,\"rescans\":%u,\"last_ms\":%u,\"max_ms\":%u,"
+             "\"avg_ms\":%u,\"candidates\":%zu}",
+             failovers_, failover_rescans_, failover_last_ms_, failover_max_ms_,
+             failovers_ ? static_cast<uint32_t>(failover_total_ms_ / failovers_) : 0u,
+             scan_candidates_.size());
+    json += buf;
+
+    snprintf(buf, sizeof(buf), ",\"roam\":{\"scans\":%u,\"roams\":%u}", roam_scans_, roams_);
+    json += buf;
+
+    snprintf(buf, sizeof(buf),
+             ",\"link\":{\"boot_to_ready_ms\":%u,\"reconnect_to_ready_ms\":%u,"
+             "\"last_connect_ms\":%u,\"last_connect_cached\":%s,\"cache_hits\":%u,"
+             "\"cache_misses\":%u,\"cache_fallbacks\":%u}",
+             boot_to_ready_ms_, reconnect_to_ready_ms_, last_connect_ms_,
+             last_connect_cached_ ? "true" : "false", gatt_cache_hits_, gatt_cache_misses_,
+             gatt_cache_fallbacks_);
+    json += buf;
+    json += ",\"ack\":";
+    json += acks_.stats_json();
+    json += ",\"refresh\":";
+    json += refresh_.stats_json();
+    json += ",\"rate_limit\":";
+    json += limiter_.stats_json();
+    json += ",\"airtime\":";
+    json += airtime_.stats_json(esphome::millis());
+    json += ",\"group_latch\":";
+    json += latch_.stats_json();
+    json += "}";
+    return json;
+}
+
 /* ---- Virtual seam default implementations ---- */
 
 void AvionMeshHub::do_mesh_send(const Command &cmd) {
 #ifdef USE_ESP32
-    send_cmd(mesh_ctx_, cmd);
+    auto *br = pick_bridge();
+    if (!br) {
+        ESP_LOGW(TAG, "No bridge ready, dropping mesh command to %u", cmd.dest_id);
+        return;
+    }
+    send_on(*br, cmd);
 #else
     (void)cmd;
 #endif
 }
 
-void AvionMeshHub::do_mqtt_publish(const std::string &topic,
-                                   const std::string &payload, bool retain) {
+bool AvionMeshHub::do_mesh_accepting() const {
+    return bridge_accepting();
+}
+
+bool AvionMeshHub::do_mqtt_publish(const char *topic, const char *payload, bool retain) {
 #ifdef USE_ESP32
     auto *mqtt = esphome::mqtt::global_mqtt_client;
     if (mqtt)
-        mqtt->publish(topic, payload, 0, retain);
+        return mqtt->publish(topic, payload, strlen(payload), 0, retain);
 #else
     (void)topic; (void)payload; (void)retain;
 #endif
+    return false;
 }
 
 void AvionMeshHub::do_mqtt_subscribe(const std::string &topic,
@@ -1662,80 +2720,22 @@ void AvionMeshHub::do_sse_emit(const std::string &event, const std::string &data
 
 /* ---- Group state latch ---- */
 
-// Returns true if device `mid` is a member of group `gid`.
-static bool is_group_member(const GroupEntry &grp, uint16_t mid) {
-    for (auto m : grp.member_ids)
-        if (m == mid) return true;
-    return false;
-}
-
 void AvionMeshHub::check_group_state_latch(uint16_t avid) {
     auto avit = device_states_.find(avid);
     if (avit == device_states_.end() || !avit->second.brightness_known)
         return;
     uint8_t brightness = avit->second.brightness;
 
-    // 1. candidate_groups: every group avid belongs to.
-    std::vector<uint16_t> candidate_ids;
-    for (auto &grp : db_.groups())
-        if (is_group_member(grp, avid))
-            candidate_ids.push_back(grp.group_id);
-    if (candidate_ids.empty())
+    // A candidate group (one avid belongs to) is triggered when a member
+    // exclusive to it among the candidates reports the same brightness;
+    // every group contained in a triggered group is latched with it.
+    // GroupLatch keeps both precomputed, see group_latch.h.
+    SlotBitset triggered;
+    if (!latch_.decide(db_, avid, brightness, triggered))
         return;
 
-    // 2. For each candidate group G, look for an exclusive witness:
-    //    a member of G that is NOT in any other candidate group AND has
-    //    reported the same brightness (proving G specifically was triggered).
-    std::set<uint16_t> triggered;
-    for (uint16_t gid : candidate_ids) {
-        auto *grp = db_.find_group(gid);
-        if (!grp) continue;
-
-        for (auto mid : grp->member_ids) {
-            // Is mid exclusive to gid within candidate_ids?
-            bool exclusive = true;
-            for (uint16_t other : candidate_ids) {
-                if (other == gid) continue;
-                auto *og = db_.find_group(other);
-                if (og && is_group_member(*og, mid)) { exclusive = false; break; }
-            }
-            if (!exclusive) continue;
-
-            // Did this exclusive witness report the same brightness?
-            auto sit = device_states_.find(mid);
-            if (sit != device_states_.end() &&
-                sit->second.brightness_known &&
-                sit->second.brightness == brightness) {
-                triggered.insert(gid);
-                break;
-            }
-        }
-    }
-    if (triggered.empty())
-        return;
-
-    // 3. Propagation: fixed-point expansion — also latch any group H whose
-    //    members are all contained within an already-triggered group (H ⊆ G).
-    //    Iterate until stable (handles chains like G1 ⊆ G2 ⊆ G3).
-    bool changed = true;
-    while (changed) {
-        changed = false;
-        for (auto &h : db_.groups()) {
-            if (triggered.count(h.group_id) || h.member_ids.empty())
-                continue;
-            for (uint16_t tgid : triggered) {
-                auto *tg = db_.find_group(tgid);
-                if (!tg) continue;
-                bool subset = true;
-                for (auto hmid : h.member_ids)
-                    if (!is_group_member(*tg, hmid)) { subset = false; break; }
-                if (subset) { triggered.insert(h.group_id); changed = true; break; }
-            }
-        }
-    }
-
-    // 4. Latch all triggered (and propagated) groups.
-    for (uint16_t gid : triggered) {
+    triggered.for_each([&](size_t gs) {
+        uint16_t gid = db_.group_at(gs);
         auto &gstate = device_states_[gid];
         gstate.brightness = brightness;
         gstate.brightness_known = true;
@@ -1744,8 +2744,8 @@ void AvionMeshHub::check_group_state_latch(uint16_t avid) {
             gstate.color_temp = avit->second.color_temp;
             gstate.color_temp_known = true;
         }
-        publish_device_state(gid);
-    }
+        mark_state_dirty(gid);
+    });
 }
 
 }  // namespace avionmesh
@@ -1,7 +1,17 @@
 #pragma once
 
+#include "ack_tracker.h"
+#include "airtime.h"
+#include "bridge_connection.h"
 #include "device_db.h"
+#include "gatt_cache.h"
+#include "group_latch.h"
+#include "latency_profiler.h"
+#include "mesh_tx.h"
 #include "mqtt_discovery.h"
+#include "rate_limiter.h"
+#include "rx_dedupe.h"
+#include "state_refresh.h"
 
 #include "esphome/core/component.h"
 #include "esphome/components/esp32_ble/ble.h"
@@ -10,6 +20,8 @@
 #include <recsrmesh/csrmesh.h>
 #include <avionmesh/avionmesh.h>
 
+#include <array>
+#include <deque>
 #include <functional>
 #include <map>
 #include <mutex>
@@ -47,6 +59,17 @@ struct DeviceState {
     uint16_t color_temp{0};
     bool brightness_known{false};
     bool color_temp_known{false};
+    bool dirty{false};          // queued for the next state flush
+    bool force_publish{false};  // flush republishes MQTT even if unchanged
+};
+
+/* Per-target brightness coalescing window: the first write goes out
+ * immediately, later writes inside the window only replace the pending value,
+ * which is sent when the window expires. */
+struct BrightnessWindow {
+    uint32_t opened_ms{0};
+    uint8_t pending_value{0};
+    bool pending{false};
 };
 
 struct DiscoveredDevice {
@@ -57,20 +80,31 @@ struct DiscoveredDevice {
     uint8_t csr_product_id;
 };
 
-enum class BleState : uint8_t {
-    Idle,
-    Scanning,
-    Connecting,
-    Discovering,
-    Ready,
-    Disconnected,
+/* A bridge seen by a scan, ranked by RSSI and aged by when it was last seen */
+struct ScanCandidate {
+    esp_bd_addr_t bda;
+    int rssi;
+    uint32_t seen_ms;  // last advertisement
+    bool failed;       // connect failed or link dropped since last seen
 };
 
 class AvionMeshHub : public esphome::Component {
     friend class AvionMeshWebHandler;
 
  public:
+    AvionMeshHub();
+
     void set_passphrase(const std::string &passphrase) { passphrase_ = passphrase; }
+    void set_ack_retries(uint8_t retries) { acks_.set_max_retries(retries); }
+    void set_state_refresh_interval(uint32_t interval_ms) { refresh_.set_interval(interval_ms); }
+    void set_state_refresh_budget(float reads_per_s) { refresh_.set_budget(reads_per_s); }
+    void set_airtime_budget(float packets_per_s) { airtime_.set_budget(packets_per_s); }
+    void set_target_rate_limit(float per_s, float burst) { limiter_.set_target_rate(per_s, burst); }
+    void set_ingress_rate_limit(float per_s, float burst) { limiter_.set_ingress_rate(per_s, burst); }
+    void set_mqtt_json_schema(bool json) { discovery_.set_json_schema(json); }
+    void set_mqtt_device_discovery(bool device) { discovery_.set_device_discovery(device); }
+    void set_mqtt_discovery_chunk_size(uint32_t bytes) { discovery_.set_chunk_bytes(bytes); }
+    void set_max_bridges(uint8_t count) { max_bridges_ = count < 1 ? 1 : count > MAX_BRIDGES ? MAX_BRIDGES : count; }
 
     void setup() override;
     void loop() override;
@@ -86,26 +120,117 @@ class AvionMeshHub : public esphome::Component {
  protected:
     std::string passphrase_;  // From YAML (if provided), used to initialize db
 
-    csrmesh::MeshContext mesh_ctx_{};
     bool mesh_initialized_{false};  // true when crypto is ready AND BLE is connected
     bool crypto_initialized_{false};  // true when csrmesh::init() succeeded
 
-    /* BLE connection management */
+    /* BLE connection management. ble_state_ is the aggregate over all bridge
+     * links: Ready as long as at least one bridge is usable. */
     BleState ble_state_{BleState::Idle};
-    esp_bd_addr_t bridge_bda_{};
-    int best_rssi_{-999};
+    bool scanning_{false};
+    std::vector<ScanCandidate> scan_candidates_;
     uint32_t scan_start_ms_{0};
     static constexpr uint32_t SCAN_WINDOW_MS = 5000;
     static constexpr uint32_t RECONNECT_DELAY_MS = 3000;
+    static constexpr uint32_t BRIDGE_REFILL_INTERVAL_MS = 60000;  // rescan for spare bridges
+    static constexpr uint32_t CANDIDATE_MAX_AGE_MS = 300000;      // older entries force a rescan
+    static constexpr size_t MAX_SCAN_CANDIDATES = 8;
     uint32_t reconnect_at_ms_{0};
+    ScanCandidate *next_candidate();
+    void mark_candidate_failed(const uint8_t *bda);
+
+    /* Failover: time from losing a ready link to the next link being ready */
+    bool failover_pending_{false};
+    uint32_t failover_start_ms_{0};
+    uint32_t failovers_{0};
+    uint32_t failover_rescans_{0};  // failovers that had to wait for a scan
+    uint32_t failover_last_ms_{0};
+    uint32_t failover_max_ms_{0};
+    uint64_t failover_total_ms_{0};
+
+    /* Link quality and roaming: background scans while idle, switch to a
+     * candidate only when it beats the weakest link by a clear margin */
+    static constexpr uint32_t RSSI_POLL_MS = 5000;
+    static constexpr uint32_t ROAM_SCAN_INTERVAL_MS = 120000;
+    static constexpr uint32_t ROAM_SCAN_WINDOW_MS = 2000;
+    static constexpr uint32_t ROAM_IDLE_MS = 10000;       // no interactive traffic for this long
+    static constexpr uint32_t ROAM_MIN_DWELL_MS = 60000;  // keep a new link at least this long
+    static constexpr uint8_t ROAM_HYSTERESIS = 20;        // score points a candidate must win by
+    uint32_t scan_window_ms_{SCAN_WINDOW_MS};
+    uint32_t last_rssi_poll_ms_{0};
+    uint32_t last_roam_scan_ms_{0};
+    uint32_t last_interactive_ms_{0};
+    int8_t roam_from_{-1};  // link being replaced by a better bridge
+    int8_t rx_bridge_{-1};  // link the packet being handled arrived on
+    uint32_t roam_scans_{0};
+    uint32_t roams_{0};
+    void maintain_links(uint32_t now);
+    bool link_idle(uint32_t now) const;
+    void consider_roam();
+    void open_bridge(BridgeConnection &slot, const ScanCandidate &candidate);
+
+    /* GATT handle cache: known bridges reconnect without scan or discovery */
+    GattCache gatt_cache_;
+    uint32_t gatt_cache_hits_{0};
+    uint32_t gatt_cache_misses_{0};
+    uint32_t gatt_cache_fallbacks_{0};
+    bool seed_candidates_from_cache();
+    void register_notify(BridgeConnection &br);
+    void fall_back_to_discovery(BridgeConnection &br);
+    void store_gatt_cache(BridgeConnection &br);
+
+    /* Time-to-Ready metrics */
+    uint32_t boot_ms_{0};
+    uint32_t boot_to_ready_ms_{0};       // 0 until the first link is up
+    uint32_t mesh_down_ms_{0};           // when the last link was lost
+    uint32_t reconnect_to_ready_ms_{0};  // last link lost -> a link ready again
+    uint32_t last_connect_ms_{0};        // gattc_open -> ready, last link
+    bool last_connect_cached_{false};
 
     esp_gatt_if_t gattc_if_{0};
-    uint16_t conn_id_{0};
-    uint16_t char_low_handle_{0};
-    uint16_t char_high_handle_{0};
     bool gattc_registered_{false};
     uint16_t app_id_{0};
 
+    /* Bridge links: traffic is spread across every ready link */
+    static constexpr uint8_t MAX_BRIDGES = 3;
+    std::array<BridgeConnection, MAX_BRIDGES> bridges_;
+    uint8_t max_bridges_{2};
+    int8_t connecting_bridge_{-1};  // slot with a gattc_open in progress
+    uint32_t mcp_seq_{0};           // shared across bridge contexts
+    int8_t assoc_bridge_{-1};       // link carrying association / MASP discovery
+    BridgeConnection *bridge_by_conn_id(uint16_t conn_id);
+    BridgeConnection *bridge_by_bda(const uint8_t *bda);
+    BridgeConnection *pick_bridge();     // least loaded ready link
+    BridgeConnection *primary_bridge();  // lowest ready slot
+    size_t ready_bridges() const;
+    bool bridge_accepting() const;
+    void connect_next_bridge();
+    void on_bridge_ready(BridgeConnection &br);
+    void on_bridge_disconnected(BridgeConnection &br);
+    void refresh_ble_state();
+    void send_on(BridgeConnection &br, const Command &cmd);
+
+    /* RX dedupe: relays and every bridge deliver copies of the same packet */
+    RxDedupe rx_dedupe_;
+    void on_bridge_rx(uint8_t bridge, uint16_t mcp_source, uint16_t crypto_source,
+                      uint8_t opcode, const uint8_t *payload, size_t payload_len);
+
+    /* Connection parameter profile management */
+    static constexpr ConnParams CONN_PARAMS_IDLE = {12, 24, 0, 400};        // 15-30 ms
+    static constexpr ConnParams CONN_PARAMS_INTERACTIVE = {6, 6, 0, 400};   // 7.5 ms
+    static constexpr ConnParams CONN_PARAMS_BULK = {6, 12, 0, 400};         // 7.5-15 ms
+    static constexpr uint32_t CONN_UPDATE_MIN_GAP_MS = 1000;  // let the last update settle
+    static constexpr uint32_t BULK_RELAX_MS = 2000;           // idle time before relaxing
+    static constexpr size_t BULK_BACKLOG_DEPTH = 16;          // queued background cmds
+    static constexpr uint32_t REFRESH_BULK_MS = 3000;         // status burst after a read-all
+    static constexpr uint32_t INTERACTIVE_RELAX_MS = 5000;    // after the last light command
+    uint32_t bulk_until_ms_{0};
+    uint32_t interactive_until_ms_{0};
+    void hold_bulk_profile(uint32_t duration_ms);
+    void update_conn_profile();
+    void apply_conn_profile(BridgeConnection &br, ConnProfile profile);
+    static const char *conn_profile_name(ConnProfile profile);
+    std::string meta_json();
+
     /* Association state */
     csrmesh::protocol::Context proto_ctx_{};
     bool associating_{false};
@@ -117,11 +242,14 @@ class AvionMeshHub : public esphome::Component {
 
     bool mgmt_subscribed_{false};
     bool mqtt_subscribed_{false};
+    bool mqtt_connected_{false};
+    uint32_t mqtt_commands_ignored_{0};
     bool mesh_mqtt_exposed_{false};
     bool initial_read_done_{false};
     bool time_synced_{false};
 
     /* Mesh discovery state */
+    static constexpr uint32_t DISCOVER_WINDOW_MS = 5000;
     bool discovering_mesh_{false};
     std::vector<DiscoveredDevice> discovered_devices_;
 
@@ -129,6 +257,9 @@ class AvionMeshHub : public esphome::Component {
     bool examining_{false};
     uint16_t examine_target_{0};
 
+    /* Per-device ping round trips; also sets per-device ack timeouts */
+    LatencyProfiler profiler_;
+
     /* Web handler */
     AvionMeshWebHandler *web_handler_{nullptr};
     bool web_registered_{false};
@@ -161,26 +292,56 @@ class AvionMeshHub : public esphome::Component {
     /* Per-device cached state for complete MQTT publishes */
     std::map<uint16_t, DeviceState> device_states_;
 
-    /* Rapid dimming detection */
+    /* Rapid dimming: at most one brightness write per target per window */
     static constexpr uint32_t RAPID_DIM_THRESHOLD_MS = 750;
-    std::map<uint16_t, uint32_t> last_brightness_ms_;
-
-    static constexpr uint32_t STATE_REFRESH_INTERVAL_MS = 60000;
+    std::map<uint16_t, BrightnessWindow> brightness_windows_;
+    void send_brightness(uint16_t avion_id, uint8_t brightness);
+    void cancel_pending_brightness(uint16_t avion_id);
+    void flush_brightness_windows();
+
+    /* Brightness / color-temp writes that must be confirmed by a status report */
+    AckTracker acks_;
+    /* Light writes pass the per-target / per-ingress token buckets first */
+    RateLimiter limiter_;
+    void transmit_brightness(uint16_t avion_id, uint8_t brightness);
+    void transmit_color_temp(uint16_t avion_id, uint16_t kelvin);
+    void write_brightness(uint16_t avion_id, uint8_t brightness);
+    void write_color_temp(uint16_t avion_id, uint16_t kelvin);
+    void track_ack(uint16_t target, AckAttr attr, uint16_t value, const Command &cmd);
+
+    /* Paced, stale-first background reads of device state */
+    StateRefresher refresh_;
 
     uint32_t rx_count_{0};
 
+    /* Prioritised mesh transmit queue; every mesh command goes through it */
+    MeshTxScheduler tx_;
+    void mesh_send(const Command &cmd, TxClass cls);
+
+    /* Mesh traffic meter and background airtime budget. Commands are
+     * attributed to tx_source_, set for the duration of a handler. */
+    AirtimeMeter airtime_;
+    TxSource tx_source_{TxSource::Internal};
+    struct SourceScope {
+        SourceScope(AvionMeshHub &hub, TxSource source) : hub_(hub), prev_(hub.tx_source_) {
+            hub.tx_source_ = source;
+        }
+        ~SourceScope() { hub_.tx_source_ = prev_; }
+        AvionMeshHub &hub_;
+        TxSource prev_;
+    };
+
+    static constexpr uint32_t STATS_INTERVAL_MS = 10000;
+    std::string stats_json();
+
     /* GAP scanning */
-    void start_scan();
+    void start_scan(uint32_t window_ms = SCAN_WINDOW_MS);
     void stop_scan_and_connect();
 
     /* GATTC connection */
-    void connect_to_best();
-    void on_connected(esp_gatt_if_t gattc_if, uint16_t conn_id);
-    void on_service_discovery_complete();
-    void on_disconnected();
-
-    /* CSRMesh BLE write */
-    int ble_write(csrmesh::Characteristic ch, const uint8_t *data, size_t len, bool response);
+    void on_connected(BridgeConnection &br, esp_gatt_if_t gattc_if, uint16_t conn_id);
+    void on_service_discovery_complete(BridgeConnection &br);
+    void on_disconnected();  // last bridge gone
 
     /* Mesh RX handler */
     void on_mesh_rx(uint16_t mcp_source, uint16_t crypto_source,
@@ -202,29 +363,77 @@ class AvionMeshHub : public esphome::Component {
     void handle_discover_mesh();
     void handle_add_discovered(uint16_t device_id, const std::string &name, uint8_t product_type);
     void handle_examine_device(uint16_t avion_id);
+    void handle_profile_latency(uint16_t avion_id, uint8_t rounds);
+    void on_profile_done();
     void handle_set_passphrase(const std::string &passphrase);
     void handle_generate_passphrase();
     void handle_factory_reset();
     void on_switch_command(uint16_t avion_id, const std::string &payload);
     void on_brightness_command(uint16_t avion_id, const std::string &payload);
     void on_color_temp_command(uint16_t avion_id, const std::string &payload);
+    void on_json_command(uint16_t avion_id, const std::string &payload);
 
     /* Crypto initialization - returns true if successful */
     bool init_crypto();
     void update_mesh_initialized();
 
-    void publish_all_discovery();
+    /* force: republish configs even when their hash matches the last one sent */
+    void publish_all_discovery(bool force = false);
     void subscribe_all_commands();
+    /* Dispatcher for the light command wildcards */
+    void on_light_command(const std::string &topic, const std::string &payload);
     void send_response(const std::string &payload);
     void sync_time();
     void read_all_dimming();
     void read_all_color();
-    void publish_device_state(uint16_t avion_id);
+    /* force: republish MQTT state even if unchanged since the last publish */
+    void publish_device_state(uint16_t avion_id, bool force = false);
+    void republish_all_states();
+    /* Broker (re)connected: retained state may have been refused while offline */
+    void on_mqtt_connected();
+
+    /* State changes only mark the entity dirty; once per loop() tick the
+     * dirty set is flushed to MQTT / SSE, at most STATE_FLUSH_MAX per tick. */
+    static constexpr size_t STATE_FLUSH_MAX = 16;
+    std::deque<uint16_t> dirty_states_;
+    uint32_t state_marks_{0};
+    uint32_t state_flushes_{0};
+    uint32_t state_flush_deferred_{0};  // ticks that hit STATE_FLUSH_MAX
+    size_t state_flush_max_backlog_{0};
+    void mark_state_dirty(uint16_t avion_id, bool force = false);
+    void flush_dirty_states();
+
+    /* HA discovery is published incrementally: publish_all_discovery() only
+     * queues the exposed entities, and each loop() tick sends at most
+     * DISCOVERY_PER_TICK configs. When the MQTT client refuses one, the
+     * publisher backs off and resumes with the same entity. */
+    static constexpr size_t DISCOVERY_PER_TICK = 4;
+    static constexpr uint32_t DISCOVERY_BACKOFF_MS = 250;
+    std::deque<uint16_t> discovery_queue_;
+    size_t discovery_total_{0};
+    size_t discovery_done_{0};
+    uint32_t discovery_resume_ms_{0};
+    uint32_t discovery_backpressure_{0};
+    uint32_t discovery_runs_{0};
+    bool discovery_force_{false};
+    bool discovery_run_active_{false};
+    /* Device-based discovery builds components only; chunks go out once the queue drains */
+    static constexpr size_t DEVICE_COMPONENTS_PER_TICK = 32;
+    void pump_discovery(uint32_t now);
+    void flush_device_discovery(uint32_t now);
+    bool publish_discovery(uint16_t id);
+    void emit_discovery_progress();
+
+    /* Group state latch; its counters follow device levels through mark_state_dirty() */
+    GroupLatch latch_;
     void check_group_state_latch(uint16_t avid);
 
     /* Virtual seams — overridden by TestHub in tests; default impls use real globals */
     virtual void do_mesh_send(const Command &cmd);
-    virtual void do_mqtt_publish(const std::string &topic, const std::string &payload, bool retain);
+    /* False while no bridge link can take a write; the TX queues hold meanwhile */
+    virtual bool do_mesh_accepting() const;
+    /* False when the MQTT client refused the message (outbox full, disconnected) */
+    virtual bool do_mqtt_publish(const char *topic, const char *payload, bool retain);
     virtual void do_mqtt_subscribe(const std::string &topic,
                                    std::function<void(const std::string &,
                                                        const std::string &)> cb);
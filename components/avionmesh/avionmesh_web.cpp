@@ -177,13 +177,7 @@ void AvionMeshWebHandler::send_initial_sync(SseSession *session) {
 
     // Meta event
     {
-        char buf[128];
-        snprintf(buf, sizeof(buf),
-                 "{\"ble_state\":%u,\"mesh_initialized\":%s,\"rx_count\":%u}",
-                 static_cast<uint8_t>(hub_->ble_state_),
-                 hub_->mesh_initialized_ ? "true" : "false",
-                 hub_->rx_count_);
-        session->send("meta", buf);
+        session->send("meta", hub_->meta_json());
         if (session->dead()) return;
     }
 
@@ -306,10 +300,8 @@ void AvionMeshWebHandler::sse_loop() {
         uint32_t now = esphome::millis();
         if (now - last_state_read_ms_ > 10000) {
             last_state_read_ms_ = now;
-            hub_->read_all_dimming();
-            hub_->set_timeout("sse_color_read", 1000, [this]() {
-                hub_->read_all_color();
-            });
+            // Paced re-read, oldest first, rather than a broadcast read
+            hub_->refresh_.expire_all();
         }
     }
 }
@@ -0,0 +1,301 @@
+#include "bridge_connection.h"
+
+#include "esphome/core/log.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace avionmesh {
+
+static const char *TAG = "avionmesh.bridge";
+
+/* ---- Link lifecycle ---- */
+
+void BridgeConnection::begin_connect(const uint8_t *bda, int rssi, uint32_t now) {
+    std::memcpy(bda_, bda, sizeof(bda_));
+    rssi_ = rssi;
+    connect_started_ms_ = now;
+
+    /* Quality history starts over with the scan reading */
+    rssi_avg_ = static_cast<float>(rssi);
+    write_fail_avg_ = 0.0f;
+    notify_liveness_ = 1.0f;
+    ack_latency_avg_ = 0.0f;
+    window_start_ms_ = now;
+    window_writes_ = writes_;
+    window_notifies_ = 0;
+    state_ = BleState::Connecting;
+}
+
+void BridgeConnection::on_open(esp_gatt_if_t gattc_if, uint16_t conn_id) {
+    gattc_if_ = gattc_if;
+    conn_id_ = conn_id;
+    state_ = BleState::Discovering;
+}
+
+void BridgeConnection::set_handles(uint16_t low, uint16_t high) {
+    char_low_handle_ = low;
+    char_high_handle_ = high;
+}
+
+void BridgeConnection::forget_handles() {
+    char_low_handle_ = 0;
+    char_high_handle_ = 0;
+    cccd_low_handle_ = 0;
+    cccd_high_handle_ = 0;
+    notify_regs_pending_ = 0;
+    cccd_writes_pending_ = 0;
+    from_cache_ = false;
+}
+
+size_t BridgeConnection::begin_rediscovery() {
+    // Queued writes carry the handles being replaced
+    size_t dropped = tx_queue_.size();
+    if (dropped) {
+        ESP_LOGW(TAG, "Bridge %u: discarding %zu writes to stale handles", index_, dropped);
+        write_drops_ += dropped;
+    }
+    tx_queue_.clear();
+    writes_in_flight_ = 0;
+    congested_ = false;
+    forget_handles();
+    state_ = BleState::Discovering;
+    return dropped;
+}
+
+size_t BridgeConnection::on_disconnect() {
+    size_t dropped = tx_queue_.size();
+    if (dropped) {
+        ESP_LOGW(TAG, "Bridge %u: discarding %zu queued writes", index_, dropped);
+        write_drops_ += dropped;
+    }
+    tx_queue_.clear();
+    writes_in_flight_ = 0;
+    congested_ = false;
+    conn_interval_ = 0;
+    forget_handles();
+    profile_ = ConnProfile::Idle;
+    state_ = BleState::Disconnected;
+    return dropped;
+}
+
+bool BridgeConnection::has_bda(const uint8_t *bda) const {
+    return std::memcmp(bda_, bda, sizeof(bda_)) == 0;
+}
+
+std::string BridgeConnection::address() const {
+    char buf[18];
+    snprintf(buf, sizeof(buf), "%02X:%02X:%02X:%02X:%02X:%02X",
+             bda_[0], bda_[1], bda_[2], bda_[3], bda_[4], bda_[5]);
+    return buf;
+}
+
+void BridgeConnection::expect_notify_reg(uint16_t handle) {
+    if (handle == char_low_handle_)
+        notify_regs_pending_ |= 1;
+    if (handle == char_high_handle_)
+        notify_regs_pending_ |= 2;
+}
+
+bool BridgeConnection::take_notify_reg(uint16_t handle) {
+    uint8_t bit = (handle == char_low_handle_) ? 1 : (handle == char_high_handle_) ? 2 : 0;
+    if (!bit || !(notify_regs_pending_ & bit))
+        return false;
+    notify_regs_pending_ &= ~bit;
+    return true;
+}
+
+void BridgeConnection::set_cccd_handle(uint16_t char_handle, uint16_t cccd) {
+    if (char_handle == char_low_handle_)
+        cccd_low_handle_ = cccd;
+    else if (char_handle == char_high_handle_)
+        cccd_high_handle_ = cccd;
+}
+
+uint16_t BridgeConnection::cccd_handle(uint16_t char_handle) const {
+    if (char_handle == char_low_handle_)
+        return cccd_low_handle_;
+    if (char_handle == char_high_handle_)
+        return cccd_high_handle_;
+    return 0;
+}
+
+bool BridgeConnection::take_cccd_write() {
+    if (cccd_writes_pending_ == 0)
+        return false;
+    return --cccd_writes_pending_ == 0;
+}
+
+/* ---- GATT write flow control ---- */
+
+int BridgeConnection::write(csrmesh::Characteristic ch, const uint8_t *data, size_t len,
+                            bool response, uint32_t now) {
+    if (!ready())
+        return -1;
+
+    if (len > PendingWrite::MAX_LEN) {
+        ESP_LOGE(TAG, "BLE write too long: %zu", len);
+        return -1;
+    }
+    if (tx_queue_.size() >= TX_QUEUE_MAX) {
+        write_drops_++;
+        ESP_LOGW(TAG, "Bridge %u: write queue full, dropping write", index_);
+        return -1;
+    }
+
+    PendingWrite w;
+    w.handle = (ch == csrmesh::Characteristic::Low) ? char_low_handle_ : char_high_handle_;
+    w.len = static_cast<uint8_t>(len);
+    w.response = response;
+    std::memcpy(w.data, data, len);
+    tx_queue_.push_back(w);
+    if (tx_queue_.size() > tx_max_depth_)
+        tx_max_depth_ = tx_queue_.size();
+
+    pump(now);
+    return 0;
+}
+
+uint32_t BridgeConnection::write_spacing_ms_() const {
+    // Spread one credit window across a connection interval
+    return (static_cast<uint32_t>(conn_interval_) * 5 / 4) / MAX_INFLIGHT_WRITES;
+}
+
+void BridgeConnection::pump(uint32_t now) {
+    /* Safety net: reclaim credits if completions stop arriving */
+    if (writes_in_flight_ > 0 && now - last_write_progress_ms_ > WRITE_CREDIT_TIMEOUT_MS) {
+        ESP_LOGW(TAG, "Bridge %u: write completions overdue, reclaiming %u credits",
+                 index_, writes_in_flight_);
+        writes_in_flight_ = 0;
+    }
+
+    while (!tx_queue_.empty()) {
+        if (congested_ || writes_in_flight_ >= MAX_INFLIGHT_WRITES)
+            return;
+        uint32_t spacing = write_spacing_ms_();
+        if (spacing > 0 && writes_ > 0 && now - last_write_ms_ < spacing)
+            return;
+
+        auto &w = tx_queue_.front();
+        auto err = esp_ble_gattc_write_char(
+            gattc_if_, conn_id_, w.handle, w.len, w.data,
+            w.response ? ESP_GATT_WRITE_TYPE_RSP : ESP_GATT_WRITE_TYPE_NO_RSP,
+            ESP_GATT_AUTH_REQ_NONE);
+        if (err != ESP_OK) {
+            // Stack refused (buffers full) — keep the write and retry next pump
+            write_errors_++;
+            return;
+        }
+
+        if (writes_in_flight_ == 0)
+            last_write_progress_ms_ = now;
+        writes_in_flight_++;
+        last_write_ms_ = now;
+        writes_++;
+        tx_queue_.pop_front();
+    }
+}
+
+void BridgeConnection::on_write_complete(esp_gatt_status_t status, uint32_t now) {
+    if (writes_in_flight_ > 0)
+        writes_in_flight_--;
+    last_write_progress_ms_ = now;
+    if (status != ESP_GATT_OK) {
+        write_errors_++;
+        ESP_LOGW(TAG, "Bridge %u: write failed: %d", index_, status);
+    }
+    write_fail_avg_ = write_fail_avg_ * 0.9f + (status != ESP_GATT_OK ? 0.1f : 0.0f);
+    pump(now);
+}
+
+void BridgeConnection::on_congest(bool congested, uint32_t now) {
+    congested_ = congested;
+    if (congested_) {
+        congest_events_++;
+        ESP_LOGD(TAG, "Bridge %u: GATT congested (%zu writes queued)", index_, tx_queue_.size());
+    } else {
+        pump(now);
+    }
+}
+
+/* ---- Connection parameters ---- */
+
+bool BridgeConnection::request_profile(ConnProfile profile, const ConnParams &params,
+                                       uint32_t now) {
+    esp_ble_conn_update_params_t update = {};
+    std::memcpy(update.bda, bda_, sizeof(update.bda));
+    update.min_int = params.min_int;
+    update.max_int = params.max_int;
+    update.latency = params.latency;
+    update.timeout = params.timeout;
+
+    auto err = esp_ble_gap_update_conn_params(&update);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Bridge %u: connection parameter update rejected: %d", index_, err);
+        return false;
+    }
+    profile_ = profile;
+    profile_changed_ms_ = now;
+    return true;
+}
+
+/* ---- Link quality ---- */
+
+void BridgeConnection::on_rssi(int rssi) {
+    rssi_ = rssi;
+    rssi_avg_ = rssi_avg_ * 0.75f + static_cast<float>(rssi) * 0.25f;
+}
+
+void BridgeConnection::on_ack_latency(uint32_t ms) {
+    float sample = static_cast<float>(ms);
+    ack_latency_avg_ = ack_latency_avg_ == 0.0f ? sample : ack_latency_avg_ * 0.8f + sample * 0.2f;
+}
+
+void BridgeConnection::update_quality(uint32_t now) {
+    if (now - window_start_ms_ < QUALITY_WINDOW_MS)
+        return;
+    // Only windows that sent something say anything about responsiveness
+    if (writes_ != window_writes_) {
+        float sample = window_notifies_ > 0 ? 1.0f : 0.0f;
+        notify_liveness_ = notify_liveness_ * 0.7f + sample * 0.3f;
+    }
+    window_start_ms_ = now;
+    window_writes_ = writes_;
+    window_notifies_ = 0;
+}
+
+uint8_t BridgeConnection::rssi_score(float rssi) {
+    // -90 dBm and below scores 0, -50 dBm and above 100
+    float s = (rssi + 90.0f) * 2.5f;
+    return static_cast<uint8_t>(s < 0.0f ? 0.0f : s > 100.0f ? 100.0f : s);
+}
+
+uint8_t BridgeConnection::score() const {
+    float s = rssi_score(rssi_avg_);
+    s *= 1.0f - write_fail_avg_;
+    s *= notify_liveness_;
+    if (ack_latency_avg_ > ACK_LATENCY_GOOD_MS) {
+        float penalty = 1.0f - (ack_latency_avg_ - ACK_LATENCY_GOOD_MS) / 2000.0f;
+        s *= penalty < 0.5f ? 0.5f : penalty;
+    }
+    return static_cast<uint8_t>(s + 0.5f);
+}
+
+std::string BridgeConnection::stats_json() const {
+    char buf[448];
+    snprintf(buf, sizeof(buf),
+             "{\"index\":%u,\"address\":\"%s\",\"rssi\":%d,\"state\":%u,\"writes\":%u,"
+             "\"queued\":%zu,\"max_queued\":%zu,\"in_flight\":%u,\"errors\":%u,\"drops\":%u,"
+             "\"congest_events\":%u,\"congested\":%s,\"conn_interval_ms\":%u,"
+             "\"score\":%u,\"rssi_avg\":%.1f,\"write_fail_pct\":%.1f,\"notify_liveness\":%.2f,"
+             "\"ack_latency_ms\":%u,\"notifies\":%u}",
+             index_, address().c_str(), rssi_, static_cast<uint8_t>(state_), writes_,
+             tx_queue_.size(), tx_max_depth_, writes_in_flight_, write_errors_, write_drops_,
+             congest_events_, congested_ ? "true" : "false",
+             static_cast<unsigned>(conn_interval_) * 5 / 4,
+             score(), rssi_avg_, write_fail_avg_ * 100.0f, notify_liveness_,
+             static_cast<unsigned>(ack_latency_avg_), notifies_);
+    return buf;
+}
+
+}  // namespace avionmesh
@@ -0,0 +1,190 @@
+#pragma once
+
+#include "esphome/components/esp32_ble/ble.h"
+
+#include <recsrmesh/csrmesh.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+
+namespace avionmesh {
+
+enum class BleState : uint8_t {
+    Idle,
+    Scanning,
+    Connecting,
+    Discovering,
+    Ready,
+    Disconnected,
+};
+
+/* Connection parameter profiles requested from the bridge. Idle is the
+ * relaxed power-saving default; Interactive asks for the shortest interval
+ * while lights are being controlled; Bulk allows a short interval range while
+ * imports, discovery or refreshes are running. */
+enum class ConnProfile : uint8_t {
+    Idle,
+    Interactive,
+    Bulk,
+};
+
+struct ConnParams {
+    uint16_t min_int;   // 1.25 ms units
+    uint16_t max_int;   // 1.25 ms units
+    uint16_t latency;   // connection events the peripheral may skip
+    uint16_t timeout;   // supervision timeout, 10 ms units
+};
+
+/* One GATT characteristic write waiting for a flow-control credit */
+struct PendingWrite {
+    static constexpr size_t MAX_LEN = 20;  // ATT payload at the default MTU
+    uint16_t handle;
+    uint8_t len;
+    bool response;
+    uint8_t data[MAX_LEN];
+};
+
+/* One GATT link to a CSRMesh bridge. Each link owns its csrmesh context so
+ * MTL fragments from different bridges never interleave, and its own write
+ * pump (credit window, congestion, interval pacing). */
+class BridgeConnection {
+ public:
+    static constexpr uint8_t MAX_INFLIGHT_WRITES = 4;
+    static constexpr size_t TX_QUEUE_MAX = 64;
+    static constexpr size_t TX_READY_DEPTH = 4;  // scheduler holds back beyond this
+    static constexpr uint32_t WRITE_CREDIT_TIMEOUT_MS = 1000;
+
+    void set_index(uint8_t index) { index_ = index; }
+    uint8_t index() const { return index_; }
+
+    /* Link lifecycle */
+    void begin_connect(const uint8_t *bda, int rssi, uint32_t now);
+    void on_open(esp_gatt_if_t gattc_if, uint16_t conn_id);
+    void set_handles(uint16_t low, uint16_t high);
+    void forget_handles();
+    /* Leave Ready and drop handles to rediscover services on the same link;
+     * returns how many queued writes were discarded */
+    size_t begin_rediscovery();
+    void set_ready(uint32_t now) {
+        state_ = BleState::Ready;
+        ready_since_ms_ = now;
+    }
+    uint32_t ready_since_ms() const { return ready_since_ms_; }
+    /* Drop the link; returns how many queued writes were discarded */
+    size_t on_disconnect();
+
+    BleState state() const { return state_; }
+    bool ready() const { return state_ == BleState::Ready && char_low_handle_ && char_high_handle_; }
+    bool active() const { return state_ == BleState::Connecting || state_ == BleState::Discovering ||
+                                 state_ == BleState::Ready; }
+    const uint8_t *bda() const { return bda_; }
+    bool has_bda(const uint8_t *bda) const;
+    std::string address() const;
+    int rssi() const { return rssi_; }
+    esp_gatt_if_t gattc_if() const { return gattc_if_; }
+    uint16_t conn_id() const { return conn_id_; }
+    uint16_t char_low_handle() const { return char_low_handle_; }
+    uint16_t char_high_handle() const { return char_high_handle_; }
+    uint32_t connect_started_ms() const { return connect_started_ms_; }
+    csrmesh::MeshContext &mesh_ctx() { return mesh_ctx_; }
+    void clear_mesh_ctx() { mesh_ctx_ = csrmesh::MeshContext{}; }
+
+    /* Notification registration: CCCD writes still owed for this link */
+    void expect_notify_reg(uint16_t handle);
+    bool take_notify_reg(uint16_t handle);
+
+    /* CCCD descriptor handles, and whether the layout came from the GATT cache.
+     * A cached link is only Ready once both CCCD writes are confirmed. */
+    void set_cccd_handle(uint16_t char_handle, uint16_t cccd);
+    uint16_t cccd_handle(uint16_t char_handle) const;
+    uint16_t cccd_low_handle() const { return cccd_low_handle_; }
+    uint16_t cccd_high_handle() const { return cccd_high_handle_; }
+    void set_from_cache(bool from_cache) { from_cache_ = from_cache; }
+    bool from_cache() const { return from_cache_; }
+    void expect_cccd_writes(uint8_t count) { cccd_writes_pending_ = count; }
+    bool take_cccd_write();  // true once the last expected write is confirmed
+
+    /* GATT write flow control */
+    int write(csrmesh::Characteristic ch, const uint8_t *data, size_t len, bool response,
+              uint32_t now);
+    void pump(uint32_t now);
+    void on_write_complete(esp_gatt_status_t status, uint32_t now);
+    void on_congest(bool congested, uint32_t now);
+    bool accepting() const { return ready() && tx_queue_.size() < TX_READY_DEPTH; }
+    size_t load() const { return tx_queue_.size() + writes_in_flight_; }
+    size_t queued() const { return tx_queue_.size(); }
+    uint8_t in_flight() const { return writes_in_flight_; }
+    bool congested() const { return congested_; }
+    uint32_t writes() const { return writes_; }
+    uint32_t drops() const { return write_drops_; }
+
+    /* Connection parameters */
+    void set_conn_interval(uint16_t interval) { conn_interval_ = interval; }
+    uint16_t conn_interval() const { return conn_interval_; }
+    ConnProfile profile() const { return profile_; }
+    uint32_t profile_changed_ms() const { return profile_changed_ms_; }
+    bool request_profile(ConnProfile profile, const ConnParams &params, uint32_t now);
+
+    /* Link quality: smoothed RSSI, write failure rate, notify responsiveness
+     * and ack latency, combined into a 0-100 score */
+    static constexpr uint32_t QUALITY_WINDOW_MS = 10000;
+    static constexpr uint32_t ACK_LATENCY_GOOD_MS = 300;
+    void on_rssi(int rssi);
+    void on_notify() { window_notifies_++; notifies_++; }
+    void on_ack_latency(uint32_t ms);
+    void update_quality(uint32_t now);
+    uint8_t score() const;
+    float rssi_avg() const { return rssi_avg_; }
+    /* Score a link with this RSSI and no history would get */
+    static uint8_t rssi_score(float rssi);
+
+    std::string stats_json() const;
+
+ protected:
+    uint8_t index_{0};
+    BleState state_{BleState::Idle};
+    esp_bd_addr_t bda_{};
+    int rssi_{-999};
+    esp_gatt_if_t gattc_if_{0};
+    uint16_t conn_id_{0};
+    uint16_t char_low_handle_{0};
+    uint16_t char_high_handle_{0};
+    uint8_t notify_regs_pending_{0};  // bit 0 = low, bit 1 = high
+    uint16_t cccd_low_handle_{0};
+    uint16_t cccd_high_handle_{0};
+    bool from_cache_{false};
+    uint8_t cccd_writes_pending_{0};
+    uint32_t connect_started_ms_{0};
+    uint32_t ready_since_ms_{0};
+    csrmesh::MeshContext mesh_ctx_{};
+
+    std::deque<PendingWrite> tx_queue_;
+    uint8_t writes_in_flight_{0};
+    bool congested_{false};
+    uint16_t conn_interval_{0};  // 1.25 ms units, 0 = unknown
+    uint32_t last_write_ms_{0};
+    uint32_t last_write_progress_ms_{0};
+    uint32_t writes_{0};
+    uint32_t write_errors_{0};
+    uint32_t write_drops_{0};
+    uint32_t congest_events_{0};
+    size_t tx_max_depth_{0};
+
+    ConnProfile profile_{ConnProfile::Idle};
+    uint32_t profile_changed_ms_{0};
+
+    float rssi_avg_{-100.0f};
+    float write_fail_avg_{0.0f};    // fraction of completions reporting an error
+    float notify_liveness_{1.0f};   // fraction of busy windows with notifies back
+    float ack_latency_avg_{0.0f};   // 0 = no confirmed writes yet
+    uint32_t notifies_{0};
+    uint32_t window_start_ms_{0};
+    uint32_t window_writes_{0};     // writes_ at window start
+    uint32_t window_notifies_{0};
+
+    uint32_t write_spacing_ms_() const;
+};
+
+}  // namespace avionmesh
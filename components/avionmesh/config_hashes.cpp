@@ -0,0 +1,130 @@
+#include "config_hashes.h"
+
+#ifdef USE_ESP32
+#include <nvs_flash.h>
+#include <nvs.h>
+#endif
+
+#include <vector>
+
+namespace avionmesh {
+
+#ifdef USE_ESP32
+static const char *NVS_NAMESPACE = "avionmesh";
+static const char *NVS_KEY_CONFIG_HASHES = "disc_hash";
+
+/*
+ * NVS storage format, one blob:
+ * [key(4) hash(4)]...   little endian
+ */
+static constexpr size_t ENTRY_LEN = 8;
+
+static uint32_t get_u32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static void put_u32(std::vector<uint8_t> &buf, uint32_t v) {
+    for (int shift = 0; shift < 32; shift += 8)
+        buf.push_back((v >> shift) & 0xFF);
+}
+#endif
+
+uint32_t ConfigHashes::hash(const std::string &topic, const std::string &config) {
+    uint32_t h = 2166136261u;
+    auto mix = [&h](const std::string &s) {
+        for (char c : s)
+            h = (h ^ static_cast<uint8_t>(c)) * 16777619u;
+    };
+    mix(topic);
+    h = (h ^ 0) * 16777619u;  // separator, so topic/config boundaries cannot shift
+    mix(config);
+    return h;
+}
+
+void ConfigHashes::load() {
+    hashes_.clear();
+    dirty_ = false;
+#ifdef USE_ESP32
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK)
+        return;
+    size_t len = 0;
+    if (nvs_get_blob(handle, NVS_KEY_CONFIG_HASHES, nullptr, &len) == ESP_OK && len > 0) {
+        std::vector<uint8_t> buf(len);
+        if (nvs_get_blob(handle, NVS_KEY_CONFIG_HASHES, buf.data(), &len) == ESP_OK) {
+            for (size_t pos = 0; pos + ENTRY_LEN <= len; pos += ENTRY_LEN)
+                hashes_[get_u32(&buf[pos])] = get_u32(&buf[pos + 4]);
+        }
+    }
+    nvs_close(handle);
+#endif
+}
+
+bool ConfigHashes::matches(uint32_t key, uint32_t hash) const {
+    auto it = hashes_.find(key);
+    return it != hashes_.end() && it->second == hash;
+}
+
+void ConfigHashes::set(uint32_t key, uint32_t hash) {
+    auto it = hashes_.find(key);
+    if (it != hashes_.end() && it->second == hash)
+        return;
+    hashes_[key] = hash;
+    mark_dirty_();
+}
+
+void ConfigHashes::erase(uint32_t key) {
+    if (hashes_.erase(key))
+        mark_dirty_();
+}
+
+void ConfigHashes::clear() {
+    if (hashes_.empty())
+        return;
+    hashes_.clear();
+    mark_dirty_();
+}
+
+void ConfigHashes::mark_dirty_() {
+    dirty_ = true;
+    changes_++;
+}
+
+void ConfigHashes::poll(uint32_t now) {
+    if (!dirty_)
+        return;
+    // Changes since the last poll restart the settle timer
+    if (changes_ != seen_changes_) {
+        seen_changes_ = changes_;
+        changed_ms_ = now;
+        return;
+    }
+    if (now - changed_ms_ < SAVE_DELAY_MS)
+        return;
+    save_();
+    dirty_ = false;
+    saves_++;
+}
+
+void ConfigHashes::save_() {
+#ifdef USE_ESP32
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK)
+        return;
+    if (hashes_.empty()) {
+        nvs_erase_key(handle, NVS_KEY_CONFIG_HASHES);
+    } else {
+        std::vector<uint8_t> buf;
+        buf.reserve(hashes_.size() * ENTRY_LEN);
+        for (auto &kv : hashes_) {
+            put_u32(buf, kv.first);
+            put_u32(buf, kv.second);
+        }
+        nvs_set_blob(handle, NVS_KEY_CONFIG_HASHES, buf.data(), buf.size());
+    }
+    nvs_commit(handle);
+    nvs_close(handle);
+#endif
+}
+
+}  // namespace avionmesh
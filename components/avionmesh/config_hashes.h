@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace avionmesh {
+
+/* Hash of the last HA discovery config published per entity, persisted in
+ * NVS, so a republish run (HA restart, reboot) can skip configs the broker
+ * already holds retained. Changes are written back in one batch once they
+ * have settled, not per config. */
+class ConfigHashes {
+ public:
+    static constexpr uint32_t SAVE_DELAY_MS = 5000;
+
+    void load();
+    /* FNV-1a over the discovery topic and config */
+    static uint32_t hash(const std::string &topic, const std::string &config);
+
+    /* Keys are entity IDs, or DEVICE_CHUNK_KEY + n for device-based discovery chunk n */
+    static constexpr uint32_t DEVICE_CHUNK_KEY = 0x10000;
+
+    bool matches(uint32_t key, uint32_t hash) const;
+    bool contains(uint32_t key) const { return hashes_.count(key) > 0; }
+    void set(uint32_t key, uint32_t hash);
+    void erase(uint32_t key);
+    void clear();
+    size_t size() const { return hashes_.size(); }
+    const std::map<uint32_t, uint32_t> &entries() const { return hashes_; }
+
+    /* Writes pending changes once no change was seen for SAVE_DELAY_MS */
+    void poll(uint32_t now);
+    bool dirty() const { return dirty_; }
+    uint32_t saves() const { return saves_; }
+
+ protected:
+    std::map<uint32_t, uint32_t> hashes_;
+    bool dirty_{false};
+    uint32_t changes_{0};
+    uint32_t seen_changes_{0};
+    uint32_t changed_ms_{0};
+    uint32_t saves_{0};
+
+    void mark_dirty_();
+    void save_();
+};
+
+}  // namespace avionmesh
@@ -27,6 +27,182 @@ static const char *NVS_KEY_PASSPHRASE = "passphrase";
  */
 #endif
 
+/* ---- IdIndex ---- */
+
+void IdIndex::reset_(size_t entries) {
+    bits_ = 3;
+    while ((1u << bits_) < entries * 2)
+        bits_++;
+    slots_.assign(1u << bits_, EMPTY);
+    used_ = 0;
+}
+
+uint16_t IdIndex::find(uint16_t id) const {
+    if (slots_.empty())
+        return NOT_FOUND;
+    size_t mask = slots_.size() - 1;
+    for (size_t i = home_(id);; i = (i + 1) & mask) {
+        uint32_t s = slots_[i];
+        if (s == EMPTY)
+            return NOT_FOUND;
+        if ((s >> 16) == id)
+            return static_cast<uint16_t>(s & 0xFFFF);
+    }
+}
+
+void IdIndex::insert(uint16_t id, uint16_t pos) {
+    if (slots_.empty() || (used_ + 1) * 2 > slots_.size()) {
+        /* Grow: re-place every entry in a table twice the size */
+        std::vector<uint32_t> old;
+        old.swap(slots_);
+        size_t n = used_ + 1;
+        reset_(n);
+        for (uint32_t s : old)
+            if (s != EMPTY)
+                insert(static_cast<uint16_t>(s >> 16), static_cast<uint16_t>(s & 0xFFFF));
+    }
+    size_t mask = slots_.size() - 1;
+    for (size_t i = home_(id);; i = (i + 1) & mask) {
+        if (slots_[i] == EMPTY) {
+            slots_[i] = (static_cast<uint32_t>(id) << 16) | pos;
+            used_++;
+            return;
+        }
+        if ((slots_[i] >> 16) == id) {
+            slots_[i] = (static_cast<uint32_t>(id) << 16) | pos;
+            return;
+        }
+    }
+}
+
+/* ---- SlotBitset ---- */
+
+void SlotBitset::set(size_t i) {
+    if (i / 32 >= words_.size())
+        words_.resize(i / 32 + 1, 0);
+    words_[i / 32] |= 1u << (i % 32);
+}
+
+void SlotBitset::reset(size_t i) {
+    if (i / 32 < words_.size())
+        words_[i / 32] &= ~(1u << (i % 32));
+}
+
+void SlotBitset::merge(const SlotBitset &other) {
+    if (other.words_.size() > words_.size())
+        words_.resize(other.words_.size(), 0);
+    for (size_t i = 0; i < other.words_.size(); i++)
+        words_[i] |= other.words_[i];
+}
+
+bool SlotBitset::any() const {
+    for (uint32_t w : words_)
+        if (w)
+            return true;
+    return false;
+}
+
+size_t SlotBitset::count() const {
+    size_t n = 0;
+    for (uint32_t w : words_)
+        n += __builtin_popcount(w);
+    return n;
+}
+
+bool SlotBitset::intersects(const SlotBitset &other) const {
+    size_t n = std::min(words_.size(), other.words_.size());
+    for (size_t i = 0; i < n; i++)
+        if (words_[i] & other.words_[i])
+            return true;
+    return false;
+}
+
+size_t SlotBitset::intersect_count(const SlotBitset &other) const {
+    size_t n = std::min(words_.size(), other.words_.size());
+    size_t c = 0;
+    for (size_t i = 0; i < n; i++)
+        c += __builtin_popcount(words_[i] & other.words_[i]);
+    return c;
+}
+
+bool SlotBitset::is_subset_of(const SlotBitset &other) const {
+    for (size_t i = 0; i < words_.size(); i++) {
+        uint32_t o = i < other.words_.size() ? other.words_[i] : 0;
+        if (words_[i] & ~o)
+            return false;
+    }
+    return true;
+}
+
+/* ---- DeviceDB ---- */
+
+void DeviceDB::reindex_() {
+    device_index_.rebuild(devices_.begin(), devices_.end(), [](const DeviceEntry &d) { return d.avion_id; });
+    group_index_.rebuild(groups_.begin(), groups_.end(), [](const GroupEntry &g) { return g.group_id; });
+}
+
+uint16_t DeviceDB::alloc_slot_(std::vector<uint16_t> &slots, std::vector<SlotBitset> &rows, uint16_t id) {
+    /* Reuse the lowest free slot so the matrix stays dense */
+    size_t slot = std::find(slots.begin(), slots.end(), 0) - slots.begin();
+    if (slot == slots.size()) {
+        slots.push_back(0);
+        rows.emplace_back();
+    }
+    slots[slot] = id;
+    rows[slot].clear();
+    return static_cast<uint16_t>(slot);
+}
+
+void DeviceDB::refresh_device_view_(size_t slot) {
+    auto *dev = find_device(device_slots_[slot]);
+    if (!dev)
+        return;
+    dev->groups.clear();
+    device_rows_[slot].for_each([this, dev](size_t g) { dev->groups.push_back(group_slots_[g]); });
+}
+
+void DeviceDB::refresh_group_view_(size_t slot) {
+    auto *grp = find_group(group_slots_[slot]);
+    if (!grp)
+        return;
+    grp->member_ids.clear();
+    group_rows_[slot].for_each([this, grp](size_t d) { grp->member_ids.push_back(device_slots_[d]); });
+}
+
+void DeviceDB::rebuild_matrix_() {
+    /* Slots follow load order; membership is the union of both stored lists,
+     * dropping references to entries that no longer exist */
+    generation_++;
+    device_slots_.clear();
+    group_slots_.clear();
+    device_rows_.clear();
+    group_rows_.clear();
+    for (auto &d : devices_)
+        d.slot = alloc_slot_(device_slots_, device_rows_, d.avion_id);
+    for (auto &g : groups_)
+        g.slot = alloc_slot_(group_slots_, group_rows_, g.group_id);
+
+    auto link = [this](uint16_t avion_id, uint16_t group_id) {
+        auto *dev = find_device(avion_id);
+        auto *grp = find_group(group_id);
+        if (!dev || !grp)
+            return;
+        device_rows_[dev->slot].set(grp->slot);
+        group_rows_[grp->slot].set(dev->slot);
+    };
+    for (auto &d : devices_)
+        for (auto gid : d.groups)
+            link(d.avion_id, gid);
+    for (auto &g : groups_)
+        for (auto mid : g.member_ids)
+            link(mid, g.group_id);
+
+    for (auto &d : devices_)
+        refresh_device_view_(d.slot);
+    for (auto &g : groups_)
+        refresh_group_view_(g.slot);
+}
+
 void DeviceDB::load() {
 #ifdef USE_ESP32
     nvs_handle_t handle;
@@ -87,6 +263,8 @@ void DeviceDB::load() {
 
     nvs_close(handle);
 #endif
+    reindex_();
+    rebuild_matrix_();
 }
 
 void DeviceDB::save() {
@@ -144,63 +322,84 @@ void DeviceDB::save() {
 bool DeviceDB::add_device(uint16_t avion_id, uint8_t product_type, const std::string &name) {
     if (find_device(avion_id))
         return false;
-    devices_.push_back({avion_id, product_type, name, {}});
+    uint16_t slot = alloc_slot_(device_slots_, device_rows_, avion_id);
+    devices_.push_back({avion_id, product_type, name, {}, false, slot});
+    generation_++;
+    device_index_.insert(avion_id, static_cast<uint16_t>(devices_.size() - 1));
     save();
     return true;
 }
 
 bool DeviceDB::remove_device(uint16_t avion_id) {
-    auto it = std::remove_if(devices_.begin(), devices_.end(),
-                              [avion_id](const DeviceEntry &d) { return d.avion_id == avion_id; });
-    if (it == devices_.end())
+    auto *dev = find_device(avion_id);
+    if (!dev)
         return false;
-    devices_.erase(it, devices_.end());
 
-    for (auto &g : groups_) {
-        g.member_ids.erase(
-            std::remove(g.member_ids.begin(), g.member_ids.end(), avion_id),
-            g.member_ids.end());
-    }
+    /* Only the groups in the device's row need their views regenerated */
+    size_t slot = dev->slot;
+    device_rows_[slot].for_each([this, slot](size_t g) {
+        group_rows_[g].reset(slot);
+        refresh_group_view_(g);
+    });
+    device_rows_[slot].clear();
+    device_slots_[slot] = 0;
+    generation_++;
+
+    devices_.erase(devices_.begin() + (dev - devices_.data()));
+    device_index_.rebuild(devices_.begin(), devices_.end(), [](const DeviceEntry &d) { return d.avion_id; });
     save();
     return true;
 }
 
 DeviceEntry *DeviceDB::find_device(uint16_t avion_id) {
-    for (auto &d : devices_)
-        if (d.avion_id == avion_id)
-            return &d;
-    return nullptr;
+    uint16_t pos = device_index_.find(avion_id);
+    return pos != IdIndex::NOT_FOUND ? &devices_[pos] : nullptr;
+}
+
+const DeviceEntry *DeviceDB::find_device(uint16_t avion_id) const {
+    uint16_t pos = device_index_.find(avion_id);
+    return pos != IdIndex::NOT_FOUND ? &devices_[pos] : nullptr;
 }
 
 bool DeviceDB::add_group(uint16_t group_id, const std::string &name) {
     if (find_group(group_id))
         return false;
-    groups_.push_back({group_id, name, {}});
+    uint16_t slot = alloc_slot_(group_slots_, group_rows_, group_id);
+    groups_.push_back({group_id, name, {}, false, slot});
+    generation_++;
+    group_index_.insert(group_id, static_cast<uint16_t>(groups_.size() - 1));
     save();
     return true;
 }
 
 bool DeviceDB::remove_group(uint16_t group_id) {
-    auto it = std::remove_if(groups_.begin(), groups_.end(),
-                              [group_id](const GroupEntry &g) { return g.group_id == group_id; });
-    if (it == groups_.end())
+    auto *grp = find_group(group_id);
+    if (!grp)
         return false;
-    groups_.erase(it, groups_.end());
 
-    for (auto &d : devices_) {
-        d.groups.erase(
-            std::remove(d.groups.begin(), d.groups.end(), group_id),
-            d.groups.end());
-    }
+    size_t slot = grp->slot;
+    group_rows_[slot].for_each([this, slot](size_t d) {
+        device_rows_[d].reset(slot);
+        refresh_device_view_(d);
+    });
+    group_rows_[slot].clear();
+    group_slots_[slot] = 0;
+    generation_++;
+
+    groups_.erase(groups_.begin() + (grp - groups_.data()));
+    group_index_.rebuild(groups_.begin(), groups_.end(), [](const GroupEntry &g) { return g.group_id; });
     save();
     return true;
 }
 
 GroupEntry *DeviceDB::find_group(uint16_t group_id) {
-    for (auto &g : groups_)
-        if (g.group_id == group_id)
-            return &g;
-    return nullptr;
+    uint16_t pos = group_index_.find(group_id);
+    return pos != IdIndex::NOT_FOUND ? &groups_[pos] : nullptr;
+}
+
+const GroupEntry *DeviceDB::find_group(uint16_t group_id) const {
+    uint16_t pos = group_index_.find(group_id);
+    return pos != IdIndex::NOT_FOUND ? &groups_[pos] : nullptr;
 }
 
 bool DeviceDB::add_device_to_group(uint16_t avion_id, uint16_t group_id) {
@@ -209,11 +408,13 @@ bool DeviceDB::add_device_to_group(uint16_t avion_id, uint16_t group_id) {
     if (!dev || !grp)
         return false;
 
-    if (std::find(dev->groups.begin(), dev->groups.end(), group_id) == dev->groups.end())
-        dev->groups.push_back(group_id);
-    if (std::find(grp->member_ids.begin(), grp->member_ids.end(), avion_id) == grp->member_ids.end())
-        grp->member_ids.push_back(avion_id);
-
+    if (!device_rows_[dev->slot].test(grp->slot)) {
+        device_rows_[dev->slot].set(grp->slot);
+        group_rows_[grp->slot].set(dev->slot);
+        refresh_device_view_(dev->slot);
+        refresh_group_view_(grp->slot);
+        generation_++;
+    }
     save();
     return true;
 }
@@ -224,14 +425,25 @@ bool DeviceDB::remove_device_from_group(uint16_t avion_id, uint16_t group_id) {
     if (!dev || !grp)
         return false;
 
-    dev->groups.erase(std::remove(dev->groups.begin(), dev->groups.end(), group_id),
-                      dev->groups.end());
-    grp->member_ids.erase(std::remove(grp->member_ids.begin(), grp->member_ids.end(), avion_id),
-                           grp->member_ids.end());
+    if (device_rows_[dev->slot].test(grp->slot)) {
+        device_rows_[dev->slot].reset(grp->slot);
+        group_rows_[grp->slot].reset(dev->slot);
+        refresh_device_view_(dev->slot);
+        refresh_group_view_(grp->slot);
+        generation_++;
+    }
     save();
     return true;
 }
 
+bool DeviceDB::is_member(uint16_t avion_id, uint16_t group_id) const {
+    uint16_t d = device_index_.find(avion_id);
+    uint16_t g = group_index_.find(group_id);
+    if (d == IdIndex::NOT_FOUND || g == IdIndex::NOT_FOUND)
+        return false;
+    return group_rows_[groups_[g].slot].test(devices_[d].slot);
+}
+
 void DeviceDB::clear() {
 #ifdef USE_ESP32
     nvs_handle_t handle;
@@ -246,6 +458,13 @@ void DeviceDB::clear() {
 #endif
     devices_.clear();
     groups_.clear();
+    device_index_.clear();
+    group_index_.clear();
+    device_rows_.clear();
+    group_rows_.clear();
+    device_slots_.clear();
+    group_slots_.clear();
+    generation_++;
     passphrase_.clear();
 }
 
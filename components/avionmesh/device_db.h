@@ -6,12 +6,15 @@
 
 namespace avionmesh {
 
+/* groups / member_ids are views of DeviceDB's membership matrix, rebuilt by
+ * DeviceDB whenever membership changes; change membership only through it. */
 struct DeviceEntry {
     uint16_t avion_id;
     uint8_t product_type;
     std::string name;
     std::vector<uint16_t> groups;
     bool mqtt_exposed{false};
+    uint16_t slot{0};  // column in the membership matrix
 };
 
 struct GroupEntry {
@@ -19,6 +22,74 @@ struct GroupEntry {
     std::string name;
     std::vector<uint16_t> member_ids;
     bool mqtt_exposed{false};
+    uint16_t slot{0};  // row in the membership matrix
+};
+
+/* Dense bitset over device or group slots; grows on set() */
+class SlotBitset {
+ public:
+    bool test(size_t i) const {
+        return i / 32 < words_.size() && (words_[i / 32] >> (i % 32)) & 1u;
+    }
+    void set(size_t i);
+    void reset(size_t i);
+    void clear() { words_.clear(); }
+    /* this |= other */
+    void merge(const SlotBitset &other);
+
+    bool any() const;
+    size_t count() const;
+    bool intersects(const SlotBitset &other) const;
+    size_t intersect_count(const SlotBitset &other) const;
+    bool is_subset_of(const SlotBitset &other) const;
+    bool operator==(const SlotBitset &other) const { return is_subset_of(other) && other.is_subset_of(*this); }
+
+    /* f(slot) for every set bit, lowest first */
+    template<typename F> void for_each(F f) const {
+        for (size_t w = 0; w < words_.size(); w++) {
+            uint32_t bits = words_[w];
+            while (bits) {
+                f(w * 32 + __builtin_ctz(bits));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+ protected:
+    std::vector<uint32_t> words_;
+};
+
+/* Open-addressing map from a 16-bit ID to its position in an entry vector.
+ * Linear probing, at most half full. Positions shift when an entry is
+ * erased from the vector, so removals rebuild the whole index instead of
+ * leaving tombstones; they are rare next to lookups. */
+class IdIndex {
+ public:
+    static constexpr uint16_t NOT_FOUND = 0xFFFF;
+
+    uint16_t find(uint16_t id) const;
+    void insert(uint16_t id, uint16_t pos);
+    template<typename It, typename Key> void rebuild(It begin, It end, Key key) {
+        size_t n = static_cast<size_t>(end - begin);
+        reset_(n);
+        uint16_t pos = 0;
+        for (auto it = begin; it != end; ++it)
+            insert(key(*it), pos++);
+    }
+    void clear() { reset_(0); }
+    size_t capacity() const { return slots_.size(); }
+
+ protected:
+    static constexpr uint32_t EMPTY = 0xFFFFFFFF;
+    std::vector<uint32_t> slots_;  // id << 16 | pos
+    size_t used_{0};
+    uint8_t bits_{0};
+
+    size_t home_(uint16_t id) const {
+        /* Fibonacci hashing spreads the sequential IDs the mesh hands out */
+        return bits_ ? (static_cast<uint32_t>(id) * 2654435769u) >> (32 - bits_) : 0;
+    }
+    void reset_(size_t entries);
 };
 
 class DeviceDB {
@@ -30,16 +101,30 @@ class DeviceDB {
     bool add_device(uint16_t avion_id, uint8_t product_type, const std::string &name);
     bool remove_device(uint16_t avion_id);
     DeviceEntry *find_device(uint16_t avion_id);
+    const DeviceEntry *find_device(uint16_t avion_id) const;
     const std::vector<DeviceEntry> &devices() const { return devices_; }
 
     bool add_group(uint16_t group_id, const std::string &name);
     bool remove_group(uint16_t group_id);
     GroupEntry *find_group(uint16_t group_id);
+    const GroupEntry *find_group(uint16_t group_id) const;
     const std::vector<GroupEntry> &groups() const { return groups_; }
 
     bool add_device_to_group(uint16_t avion_id, uint16_t group_id);
     bool remove_device_from_group(uint16_t avion_id, uint16_t group_id);
 
+    /* Membership matrix: one bit per (group slot, device slot), kept both
+     * as group rows and as device rows so either side is one bitset */
+    bool is_member(uint16_t avion_id, uint16_t group_id) const;
+    const SlotBitset &members(const GroupEntry &grp) const { return group_rows_[grp.slot]; }
+    const SlotBitset &memberships(const DeviceEntry &dev) const { return device_rows_[dev.slot]; }
+    uint16_t device_at(size_t slot) const { return slot < device_slots_.size() ? device_slots_[slot] : 0; }
+    uint16_t group_at(size_t slot) const { return slot < group_slots_.size() ? group_slots_[slot] : 0; }
+    size_t device_slots() const { return device_slots_.size(); }
+    size_t group_slots() const { return group_slots_.size(); }
+    /* Bumped by every change to the entries, their slots or the matrix */
+    uint32_t generation() const { return generation_; }
+
     const std::string &passphrase() const { return passphrase_; }
     void set_passphrase(const std::string &passphrase);
     void generate_passphrase();
@@ -48,6 +133,20 @@ class DeviceDB {
     std::vector<DeviceEntry> devices_;
     std::vector<GroupEntry> groups_;
     std::string passphrase_;
+    IdIndex device_index_;
+    IdIndex group_index_;
+
+    std::vector<SlotBitset> group_rows_;   // by group slot: device slots
+    std::vector<SlotBitset> device_rows_;  // by device slot: group slots
+    std::vector<uint16_t> device_slots_;   // slot -> avion_id, 0 = free
+    std::vector<uint16_t> group_slots_;    // slot -> group_id, 0 = free
+    uint32_t generation_{0};
+
+    void reindex_();
+    void rebuild_matrix_();
+    static uint16_t alloc_slot_(std::vector<uint16_t> &slots, std::vector<SlotBitset> &rows, uint16_t id);
+    void refresh_device_view_(size_t slot);
+    void refresh_group_view_(size_t slot);
 };
 
 }  // namespace avionmesh
@@ -0,0 +1,155 @@
+#include "gatt_cache.h"
+
+#ifdef USE_ESP32
+#include <nvs_flash.h>
+#include <nvs.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace avionmesh {
+
+#ifdef USE_ESP32
+static const char *NVS_NAMESPACE = "avionmesh";
+static const char *NVS_KEY_GATT_INDEX = "gatt_idx";
+
+/*
+ * NVS storage format:
+ * Index:          [bda(6)]...                 most recent first
+ * Entry "g<hex>": [bda(6) rssi(1) char_low(2) char_high(2) cccd_low(2) cccd_high(2)]
+ */
+static constexpr size_t ENTRY_BLOB_LEN = 15;
+#endif
+
+void GattCache::nvs_key(const uint8_t *bda, char *key) {
+    snprintf(key, 14, "g%02x%02x%02x%02x%02x%02x", bda[0], bda[1], bda[2], bda[3], bda[4], bda[5]);
+}
+
+void GattCache::load() {
+    entries_.clear();
+#ifdef USE_ESP32
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK)
+        return;
+
+    uint8_t index[MAX_ENTRIES * 6];
+    size_t index_len = sizeof(index);
+    if (nvs_get_blob(handle, NVS_KEY_GATT_INDEX, index, &index_len) == ESP_OK) {
+        for (size_t pos = 0; pos + 6 <= index_len; pos += 6) {
+            char key[14];
+            nvs_key(&index[pos], key);
+            uint8_t buf[ENTRY_BLOB_LEN];
+            size_t len = sizeof(buf);
+            if (nvs_get_blob(handle, key, buf, &len) != ESP_OK || len != ENTRY_BLOB_LEN)
+                continue;
+
+            GattCacheEntry e;
+            std::memcpy(e.bda, buf, 6);
+            e.rssi = static_cast<int8_t>(buf[6]);
+            e.char_low = buf[7] | (buf[8] << 8);
+            e.char_high = buf[9] | (buf[10] << 8);
+            e.cccd_low = buf[11] | (buf[12] << 8);
+            e.cccd_high = buf[13] | (buf[14] << 8);
+            entries_.push_back(e);
+        }
+    }
+    nvs_close(handle);
+#endif
+}
+
+const GattCacheEntry *GattCache::find(const uint8_t *bda) const {
+    for (auto &e : entries_)
+        if (std::memcmp(e.bda, bda, sizeof(e.bda)) == 0)
+            return &e;
+    return nullptr;
+}
+
+void GattCache::store(const GattCacheEntry &entry) {
+    entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                  [&entry](const GattCacheEntry &e) {
+                                      return std::memcmp(e.bda, entry.bda, sizeof(e.bda)) == 0;
+                                  }),
+                   entries_.end());
+    entries_.insert(entries_.begin(), entry);
+
+#ifdef USE_ESP32
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK)
+        return;
+    if (entries_.size() > MAX_ENTRIES) {
+        char key[14];
+        nvs_key(entries_.back().bda, key);
+        nvs_erase_key(handle, key);
+    }
+
+    uint8_t buf[ENTRY_BLOB_LEN];
+    std::memcpy(buf, entry.bda, 6);
+    buf[6] = static_cast<uint8_t>(entry.rssi);
+    buf[7] = entry.char_low & 0xFF;  buf[8] = entry.char_low >> 8;
+    buf[9] = entry.char_high & 0xFF; buf[10] = entry.char_high >> 8;
+    buf[11] = entry.cccd_low & 0xFF; buf[12] = entry.cccd_low >> 8;
+    buf[13] = entry.cccd_high & 0xFF; buf[14] = entry.cccd_high >> 8;
+    char key[14];
+    nvs_key(entry.bda, key);
+    nvs_set_blob(handle, key, buf, sizeof(buf));
+    nvs_commit(handle);
+    nvs_close(handle);
+#endif
+
+    if (entries_.size() > MAX_ENTRIES)
+        entries_.pop_back();
+    save_index();
+}
+
+void GattCache::erase(const uint8_t *bda) {
+    auto it = std::remove_if(entries_.begin(), entries_.end(), [bda](const GattCacheEntry &e) {
+        return std::memcmp(e.bda, bda, sizeof(e.bda)) == 0;
+    });
+    if (it == entries_.end())
+        return;
+    entries_.erase(it, entries_.end());
+
+#ifdef USE_ESP32
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle) == ESP_OK) {
+        char key[14];
+        nvs_key(bda, key);
+        nvs_erase_key(handle, key);
+        nvs_commit(handle);
+        nvs_close(handle);
+    }
+#endif
+    save_index();
+}
+
+void GattCache::clear() {
+    while (!entries_.empty()) {
+        uint8_t bda[6];
+        std::memcpy(bda, entries_.front().bda, sizeof(bda));
+        erase(bda);
+    }
+}
+
+void GattCache::save_index() {
+#ifdef USE_ESP32
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK)
+        return;
+    uint8_t index[MAX_ENTRIES * 6];
+    size_t len = 0;
+    for (auto &e : entries_) {
+        std::memcpy(&index[len], e.bda, 6);
+        len += 6;
+    }
+    if (len)
+        nvs_set_blob(handle, NVS_KEY_GATT_INDEX, index, len);
+    else
+        nvs_erase_key(handle, NVS_KEY_GATT_INDEX);
+    nvs_commit(handle);
+    nvs_close(handle);
+#endif
+}
+
+}  // namespace avionmesh
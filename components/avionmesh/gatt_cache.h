@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace avionmesh {
+
+/* GATT layout of one bridge, remembered so a reconnect can skip service discovery */
+struct GattCacheEntry {
+    uint8_t bda[6];
+    int8_t rssi;         // last RSSI seen, ranks cached bridges at boot
+    uint16_t char_low;
+    uint16_t char_high;
+    uint16_t cccd_low;
+    uint16_t cccd_high;
+};
+
+/* Bridge handle cache persisted in NVS: one key per bridge ("g" + the 12 hex
+ * digits of its address) plus an index of addresses, most recent first. */
+class GattCache {
+ public:
+    static constexpr size_t MAX_ENTRIES = 4;
+
+    void load();
+    const GattCacheEntry *find(const uint8_t *bda) const;
+    void store(const GattCacheEntry &entry);  // becomes the most recent entry
+    void erase(const uint8_t *bda);
+    void clear();
+    const std::vector<GattCacheEntry> &entries() const { return entries_; }
+
+ protected:
+    std::vector<GattCacheEntry> entries_;
+
+    void save_index();
+    static void nvs_key(const uint8_t *bda, char *key);
+};
+
+}  // namespace avionmesh
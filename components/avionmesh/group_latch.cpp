@@ -0,0 +1,145 @@
+#include "group_latch.h"
+
+#include "esphome/core/log.h"
+
+#include <cstdio>
+
+namespace avionmesh {
+
+static const char *TAG = "avionmesh.latch";
+
+void GroupLatch::ensure_built_(const DeviceDB &db) {
+    if (!built_ || generation_ != db.generation())
+        rebuild_(db);
+}
+
+void GroupLatch::rebuild_(const DeviceDB &db) {
+    built_ = true;
+    generation_ = db.generation();
+    rebuilds_++;
+    plans_.clear();
+    plan_of_.assign(db.device_slots(), NO_PLAN);
+    witness_.assign(db.device_slots(), {});
+    level_.assign(db.device_slots(), -1);
+
+    for (auto &dev : db.devices()) {
+        const SlotBitset &groups = db.memberships(dev);
+        if (level_fn_)
+            level_[dev.slot] = static_cast<int16_t>(level_fn_(dev.avion_id));
+        if (!groups.any())
+            continue;
+        uint16_t p = 0;
+        while (p < plans_.size() && !(plans_[p].groups == groups))
+            p++;
+        if (p == plans_.size()) {
+            plans_.push_back({groups, {}});
+            groups.for_each([this, p](size_t g) {
+                plans_[p].candidates.push_back({static_cast<uint16_t>(g), {}});
+            });
+        }
+        plan_of_[dev.slot] = p;
+    }
+
+    /* Exclusive members: in exactly one of the plan's groups */
+    for (uint16_t p = 0; p < plans_.size(); p++) {
+        Plan &plan = plans_[p];
+        for (uint16_t c = 0; c < plan.candidates.size(); c++) {
+            const GroupEntry *grp = db.find_group(db.group_at(plan.candidates[c].group_slot));
+            if (!grp)
+                continue;
+            db.members(*grp).for_each([&](size_t ds) {
+                const DeviceEntry *dev = db.find_device(db.device_at(ds));
+                if (!dev || db.memberships(*dev).intersect_count(plan.groups) != 1)
+                    return;
+                WitnessRef ref{p, c};
+                witness_[ds].push_back(ref);
+                count_(ref, level_[ds], 1);
+            });
+        }
+    }
+
+    /* Containment closure. Subset is transitive, so the direct relation
+     * already covers chains like G1 ⊆ G2 ⊆ G3. */
+    contained_.assign(db.group_slots(), {});
+    for (auto &g : db.groups()) {
+        const SlotBitset &gm = db.members(g);
+        for (auto &h : db.groups()) {
+            const SlotBitset &hm = db.members(h);
+            if (hm.any() && hm.is_subset_of(gm))
+                contained_[g.slot].set(h.slot);
+        }
+    }
+    ESP_LOGD(TAG, "Rebuilt: %zu plans for %zu devices, %zu groups", plans_.size(), db.devices().size(),
+             db.groups().size());
+}
+
+void GroupLatch::count_(const WitnessRef &ref, int level, int delta) {
+    if (level < 0)
+        return;
+    auto &levels = plans_[ref.plan].candidates[ref.candidate].levels;
+    for (size_t i = 0; i < levels.size(); i++) {
+        if (levels[i].first != level)
+            continue;
+        levels[i].second += delta;
+        if (levels[i].second == 0) {
+            levels[i] = levels.back();
+            levels.pop_back();
+        }
+        return;
+    }
+    if (delta > 0)
+        levels.emplace_back(static_cast<uint8_t>(level), static_cast<uint16_t>(delta));
+}
+
+void GroupLatch::on_level(const DeviceDB &db, uint16_t avion_id) {
+    const DeviceEntry *dev = db.find_device(avion_id);
+    if (!dev || !level_fn_)
+        return;
+    if (!built_ || generation_ != db.generation()) {
+        rebuild_(db);  // reads every level, this one included
+        return;
+    }
+    int level = level_fn_(avion_id);
+    int old = level_[dev->slot];
+    if (level == old)
+        return;
+    for (auto &ref : witness_[dev->slot]) {
+        count_(ref, old, -1);
+        count_(ref, level, 1);
+    }
+    level_[dev->slot] = static_cast<int16_t>(level);
+}
+
+bool GroupLatch::decide(const DeviceDB &db, uint16_t avion_id, uint8_t level, SlotBitset &out) {
+    out.clear();
+    const DeviceEntry *dev = db.find_device(avion_id);
+    if (!dev)
+        return false;
+    ensure_built_(db);
+    decisions_++;
+    uint16_t p = plan_of_[dev->slot];
+    if (p == NO_PLAN)
+        return false;
+
+    for (auto &cand : plans_[p].candidates) {
+        for (auto &lv : cand.levels) {
+            if (lv.first != level)
+                continue;
+            out.merge(contained_[cand.group_slot]);
+            break;
+        }
+    }
+    if (!out.any())
+        return false;
+    latches_++;
+    return true;
+}
+
+std::string GroupLatch::stats_json() const {
+    char buf[96];
+    snprintf(buf, sizeof(buf), "{\"plans\":%u,\"rebuilds\":%u,\"decisions\":%u,\"latches\":%u}",
+             static_cast<unsigned>(plans_.size()), rebuilds_, decisions_, latches_);
+    return buf;
+}
+
+}  // namespace avionmesh
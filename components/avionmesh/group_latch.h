@@ -0,0 +1,75 @@
+#pragma once
+
+#include "device_db.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace avionmesh {
+
+/* Precomputed state behind the group state latch. When a device reports a
+ * level, a candidate group G (one the device belongs to) was triggered if a
+ * member exclusive to G among the candidates reports the same level, and
+ * every group contained in a triggered group follows it.
+ *
+ * Devices with the same set of groups share a plan: the candidate groups,
+ * and for each a count of its exclusive members at every reported level.
+ * Plans, the exclusive-member references and the containment closure of
+ * each group are rebuilt only when the DeviceDB generation changes; level
+ * changes just move a device between counters. A latch decision then costs
+ * one counter lookup per candidate group plus a bitset OR per hit. */
+class GroupLatch {
+ public:
+    /* Known level of a device, or -1 */
+    void set_level_fn(std::function<int(uint16_t)> fn) { level_fn_ = std::move(fn); }
+
+    /* The device's known level may have changed; non-devices are ignored */
+    void on_level(const DeviceDB &db, uint16_t avion_id);
+    /* Group slots to latch when avion_id reports level; false if none */
+    bool decide(const DeviceDB &db, uint16_t avion_id, uint8_t level, SlotBitset &out);
+    /* Rebuild on next use, e.g. after the level source was cleared */
+    void invalidate() { built_ = false; }
+
+    size_t plans() const { return plans_.size(); }
+    std::string stats_json() const;
+
+ protected:
+    static constexpr uint16_t NO_PLAN = 0xFFFF;
+
+    struct Candidate {
+        uint16_t group_slot;
+        /* (level, exclusive members at that level); a handful of levels at most */
+        std::vector<std::pair<uint8_t, uint16_t>> levels;
+    };
+    struct Plan {
+        SlotBitset groups;
+        std::vector<Candidate> candidates;
+    };
+    struct WitnessRef {
+        uint16_t plan;
+        uint16_t candidate;
+    };
+
+    std::function<int(uint16_t)> level_fn_;
+    bool built_{false};
+    uint32_t generation_{0};
+    std::vector<Plan> plans_;
+    std::vector<uint16_t> plan_of_;                 // by device slot
+    std::vector<std::vector<WitnessRef>> witness_;  // by device slot
+    std::vector<int16_t> level_;                    // by device slot, -1 unknown
+    std::vector<SlotBitset> contained_;             // by group slot: non-empty groups it contains, itself included
+
+    uint32_t rebuilds_{0};
+    uint32_t decisions_{0};
+    uint32_t latches_{0};
+
+    void ensure_built_(const DeviceDB &db);
+    void rebuild_(const DeviceDB &db);
+    void count_(const WitnessRef &ref, int level, int delta);
+};
+
+}  // namespace avionmesh
@@ -0,0 +1,140 @@
+#include "latency_profiler.h"
+
+#include "esphome/core/log.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace avionmesh {
+
+static const char *TAG = "avionmesh.latency";
+
+void DeviceLatency::add(uint32_t rtt_ms) {
+    if (samples == 0 || rtt_ms < min_ms)
+        min_ms = rtt_ms;
+    if (rtt_ms > max_ms)
+        max_ms = rtt_ms;
+    samples++;
+    total_ms += rtt_ms;
+    last_ms = rtt_ms;
+
+    size_t b = 0;
+    while (b < BUCKETS - 1 && rtt_ms >= BUCKET_LIMITS_MS[b])
+        b++;
+    hist[b]++;
+}
+
+bool LatencyProfiler::start(const std::vector<uint16_t> &targets, uint8_t rounds, uint32_t now) {
+    if (running_ || targets.empty())
+        return false;
+    queue_.clear();
+    // Round-robin so one slow device doesn't delay everyone else's samples
+    for (uint8_t r = 0; r < rounds; r++)
+        queue_.insert(queue_.end(), targets.begin(), targets.end());
+    next_ = 0;
+    running_ = true;
+    awaiting_ = false;
+    next_send_ms_ = now;
+    ESP_LOGI(TAG, "Profiling %zu device(s), %u round(s)", targets.size(), rounds);
+    return true;
+}
+
+void LatencyProfiler::cancel() {
+    running_ = false;
+    awaiting_ = false;
+    queue_.clear();
+    next_ = 0;
+}
+
+void LatencyProfiler::on_dispatch(const Command &cmd, uint32_t now) {
+    if (!awaiting_ || dispatched_ || cmd.dest_id != target_ ||
+        cmd.payload[0] != static_cast<uint8_t>(Verb::Ping))
+        return;
+    dispatched_ = true;
+    sent_ms_ = now;
+}
+
+void LatencyProfiler::on_reply(uint16_t device_id, uint32_t now) {
+    if (!awaiting_ || device_id != target_)
+        return;
+    uint32_t rtt = now - sent_ms_;
+    results_[device_id].add(rtt);
+    ESP_LOGD(TAG, "Device %u: %ums", device_id, rtt);
+    finish_ping_(now);
+}
+
+void LatencyProfiler::poll(uint32_t now) {
+    if (!running_)
+        return;
+    if (awaiting_) {
+        if (now - sent_ms_ < PING_TIMEOUT_MS)
+            return;
+        ESP_LOGD(TAG, "Device %u: no reply", target_);
+        results_[target_].lost++;
+        finish_ping_(now);
+        return;
+    }
+    if (static_cast<int32_t>(now - next_send_ms_) < 0)
+        return;
+
+    target_ = queue_[next_++];
+    awaiting_ = true;
+    dispatched_ = false;
+    sent_ms_ = now;  // restarted by on_dispatch once the ping leaves the queue
+    Command cmd;
+    cmd_ping(target_, cmd);
+    if (send_fn_)
+        send_fn_(cmd);
+}
+
+void LatencyProfiler::finish_ping_(uint32_t now) {
+    awaiting_ = false;
+    next_send_ms_ = now + PING_GAP_MS;
+    if (next_ < queue_.size())
+        return;
+    running_ = false;
+    queue_.clear();
+    next_ = 0;
+    ESP_LOGI(TAG, "Latency profile complete");
+    if (done_fn_)
+        done_fn_();
+}
+
+const DeviceLatency *LatencyProfiler::find(uint16_t device_id) const {
+    auto it = results_.find(device_id);
+    return it != results_.end() ? &it->second : nullptr;
+}
+
+uint32_t LatencyProfiler::ack_timeout_ms(uint16_t device_id) const {
+    auto *d = find(device_id);
+    if (!d || d->samples == 0)
+        return 0;
+    return std::min(d->max_ms * 2, MAX_ACK_TIMEOUT_MS);
+}
+
+std::string LatencyProfiler::device_json(uint16_t device_id) const {
+    DeviceLatency empty;
+    auto *d = find(device_id);
+    if (!d)
+        d = &empty;
+    char buf[224];
+    snprintf(buf, sizeof(buf),
+             "{\"avion_id\":%u,\"samples\":%u,\"lost\":%u,\"min_ms\":%u,\"avg_ms\":%u,"
+             "\"max_ms\":%u,\"last_ms\":%u,\"hist\":[%u,%u,%u,%u,%u,%u]}",
+             device_id, d->samples, d->lost, d->min_ms, d->avg_ms(), d->max_ms, d->last_ms,
+             d->hist[0], d->hist[1], d->hist[2], d->hist[3], d->hist[4], d->hist[5]);
+    return buf;
+}
+
+std::string LatencyProfiler::results_json() const {
+    std::string json = "[";
+    for (auto &kv : results_) {
+        if (json.size() > 1)
+            json += ",";
+        json += device_json(kv.first);
+    }
+    json += "]";
+    return json;
+}
+
+}  // namespace avionmesh
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <avionmesh/avionmesh.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace avionmesh {
+
+/* Round-trip history of one device */
+struct DeviceLatency {
+    static constexpr size_t BUCKETS = 6;
+    /* Histogram bucket upper bounds (ms); the last bucket is open-ended */
+    static constexpr uint32_t BUCKET_LIMITS_MS[BUCKETS - 1] = {100, 200, 400, 800, 1600};
+
+    uint32_t samples{0};
+    uint32_t lost{0};
+    uint32_t min_ms{0};
+    uint32_t max_ms{0};
+    uint32_t total_ms{0};
+    uint32_t last_ms{0};
+    std::array<uint32_t, BUCKETS> hist{};
+
+    uint32_t avg_ms() const { return samples ? total_ms / samples : 0; }
+    void add(uint32_t rtt_ms);
+};
+
+/* Pings devices one at a time and records each round trip. Only one ping is
+ * outstanding; the next goes out PING_GAP_MS after the previous one was
+ * answered or timed out, so a run never adds more than one packet at a time
+ * to the mesh. Results are kept across runs and feed ack retry timeouts. */
+class LatencyProfiler {
+ public:
+    void set_send_fn(std::function<void(const Command &)> fn) { send_fn_ = std::move(fn); }
+    /* Called once the last ping of a run has been answered or timed out */
+    void set_done_fn(std::function<void()> fn) { done_fn_ = std::move(fn); }
+
+    /* Ping every target `rounds` times. False if a run is already active. */
+    bool start(const std::vector<uint16_t> &targets, uint8_t rounds, uint32_t now);
+    void cancel();
+    /* The scheduler put a command on air: starts the clock for our ping */
+    void on_dispatch(const Command &cmd, uint32_t now);
+    /* A Ping response arrived from device_id */
+    void on_reply(uint16_t device_id, uint32_t now);
+    void poll(uint32_t now);
+
+    bool running() const { return running_; }
+    size_t remaining() const { return queue_.size() - next_; }
+    const DeviceLatency *find(uint16_t device_id) const;
+    /* First ack timeout for a device: twice its slowest round trip, 0 if never profiled */
+    uint32_t ack_timeout_ms(uint16_t device_id) const;
+    void clear() { results_.clear(); }
+
+    std::string device_json(uint16_t device_id) const;
+    /* JSON array of every profiled device */
+    std::string results_json() const;
+
+    static constexpr uint32_t PING_TIMEOUT_MS = 3000;
+    static constexpr uint32_t PING_GAP_MS = 250;
+    static constexpr uint32_t MAX_ACK_TIMEOUT_MS = 4000;
+
+ protected:
+    std::function<void(const Command &)> send_fn_;
+    std::function<void()> done_fn_;
+    std::map<uint16_t, DeviceLatency> results_;
+
+    std::vector<uint16_t> queue_;  // one entry per ping, rounds interleaved
+    size_t next_{0};
+    bool running_{false};
+    bool awaiting_{false};
+    bool dispatched_{false};
+    uint16_t target_{0};
+    uint32_t sent_ms_{0};
+    uint32_t next_send_ms_{0};
+
+    void finish_ping_(uint32_t now);
+};
+
+}  // namespace avionmesh
@@ -0,0 +1,145 @@
+#include "mesh_tx.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace avionmesh {
+
+const char *MeshTxScheduler::class_name(TxClass cls) {
+    switch (cls) {
+    case TxClass::Interactive:  return "interactive";
+    case TxClass::StateRead:    return "state_read";
+    case TxClass::Provisioning: return "provisioning";
+    case TxClass::Housekeeping: return "housekeeping";
+    }
+    return "unknown";
+}
+
+const char *MeshTxScheduler::source_name(TxSource source) {
+    switch (source) {
+    case TxSource::Mqtt:       return "mqtt";
+    case TxSource::Web:        return "web";
+    case TxSource::Management: return "management";
+    case TxSource::Internal:   return "internal";
+    }
+    return "unknown";
+}
+
+bool MeshTxScheduler::same_command_(const Command &a, const Command &b) {
+    return a.dest_id == b.dest_id && std::memcmp(a.payload, b.payload, sizeof(a.payload)) == 0;
+}
+
+bool MeshTxScheduler::same_write_target_(const Command &a, const Command &b) {
+    return a.dest_id == b.dest_id && a.payload[0] == static_cast<uint8_t>(Verb::Write) &&
+           b.payload[0] == a.payload[0] && a.payload[1] == b.payload[1];
+}
+
+void MeshTxScheduler::enqueue(const Command &cmd, TxClass cls, uint32_t now, TxSource source) {
+    size_t idx = static_cast<size_t>(cls);
+    auto &q = queues_[idx];
+    auto &st = stats_[idx];
+    st.enqueued++;
+
+    if (cls == TxClass::Interactive && q.empty() && ready_()) {
+        dispatch_(cls, {cmd, now, source}, now);
+        return;
+    }
+
+    /* A read or time sync identical to one already waiting adds nothing */
+    if (cls == TxClass::StateRead || cls == TxClass::Housekeeping) {
+        for (auto &e : q) {
+            if (same_command_(e.cmd, cmd))
+                return;
+        }
+    }
+
+    /* A newer write to the same target and attribute takes the waiting
+     * write's place; a full interactive queue refuses new targets rather
+     * than dropping another light's command */
+    if (cls == TxClass::Interactive) {
+        for (auto &e : q) {
+            if (same_write_target_(e.cmd, cmd)) {
+                e.cmd = cmd;
+                e.source = source;
+                st.coalesced++;
+                return;
+            }
+        }
+        if (q.size() >= MAX_DEPTH[idx]) {
+            st.dropped++;
+            return;
+        }
+    } else if (MAX_DEPTH[idx] && q.size() >= MAX_DEPTH[idx]) {
+        q.pop_front();
+        st.dropped++;
+    }
+    q.push_back({cmd, now, source});
+    if (q.size() > st.max_depth)
+        st.max_depth = static_cast<uint16_t>(q.size());
+}
+
+void MeshTxScheduler::poll(uint32_t now) {
+    /* Interactive work is never held behind the background gate */
+    auto &iq = queues_[static_cast<size_t>(TxClass::Interactive)];
+    while (!iq.empty()) {
+        if (!ready_())
+            return;
+        Entry e = iq.front();
+        iq.pop_front();
+        dispatch_(TxClass::Interactive, e, now);
+    }
+
+    if (static_cast<int32_t>(now - background_gate_ms_) < 0 || !ready_())
+        return;
+
+    for (size_t idx = 1; idx < TX_CLASS_COUNT; idx++) {
+        auto &q = queues_[idx];
+        if (q.empty())
+            continue;
+        if (budget_fn_ && !budget_fn_())
+            return;
+        Entry e = q.front();
+        q.pop_front();
+        dispatch_(static_cast<TxClass>(idx), e, now);
+        return;  // one background command per spacing interval
+    }
+}
+
+void MeshTxScheduler::clear() {
+    for (auto &q : queues_)
+        q.clear();
+}
+
+void MeshTxScheduler::dispatch_(TxClass cls, const Entry &e, uint32_t now) {
+    auto &st = stats_[static_cast<size_t>(cls)];
+    uint32_t wait = now - e.enqueued_ms;
+    st.sent++;
+    st.total_wait_ms += wait;
+    if (wait > st.max_wait_ms)
+        st.max_wait_ms = wait;
+
+    background_gate_ms_ = now + BACKGROUND_SPACING_MS;
+    dispatch_source_ = e.source;
+    if (send_fn_)
+        send_fn_(e.cmd);
+    dispatch_source_ = TxSource::Internal;
+}
+
+std::string MeshTxScheduler::stats_json() const {
+    std::string json = "{";
+    for (size_t idx = 0; idx < TX_CLASS_COUNT; idx++) {
+        auto &st = stats_[idx];
+        char buf[192];
+        snprintf(buf, sizeof(buf),
+                 "%s\"%s\":{\"depth\":%u,\"max_depth\":%u,\"sent\":%u,\"dropped\":%u,"
+                 "\"coalesced\":%u,\"avg_wait_ms\":%u,\"max_wait_ms\":%u}",
+                 idx > 0 ? "," : "", class_name(static_cast<TxClass>(idx)),
+                 static_cast<unsigned>(queues_[idx].size()), st.max_depth, st.sent, st.dropped, st.coalesced,
+                 st.sent ? st.total_wait_ms / st.sent : 0u, st.max_wait_ms);
+        json += buf;
+    }
+    json += "}";
+    return json;
+}
+
+}  // namespace avionmesh
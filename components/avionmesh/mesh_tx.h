@@ -0,0 +1,98 @@
+#pragma once
+
+#include <avionmesh/avionmesh.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+
+namespace avionmesh {
+
+/* Priority classes, highest first. Lower classes only transmit when every
+ * higher class is empty and the background spacing gate has elapsed. */
+enum class TxClass : uint8_t {
+    Interactive,   // light control from MQTT, /api/control, management
+    StateRead,     // dimming / color reads
+    Provisioning,  // group edits, unclaim, import, discovery and examine pings
+    Housekeeping,  // time sync
+};
+
+static constexpr size_t TX_CLASS_COUNT = 4;
+
+/* Where a command came from, for airtime accounting */
+enum class TxSource : uint8_t {
+    Mqtt,        // light command topics
+    Web,         // web UI / HTTP API
+    Management,  // MQTT management channel
+    Internal,    // refresh, retries, time sync and other hub-initiated work
+};
+
+static constexpr size_t TX_SOURCE_COUNT = 4;
+
+struct TxClassStats {
+    uint32_t enqueued{0};
+    uint32_t sent{0};
+    uint32_t dropped{0};
+    uint32_t coalesced{0};  // replaced a waiting write to the same target and attribute
+    uint16_t max_depth{0};
+    uint32_t total_wait_ms{0};
+    uint32_t max_wait_ms{0};
+};
+
+class MeshTxScheduler {
+ public:
+    void set_send_fn(std::function<void(const Command &)> fn) { send_fn_ = std::move(fn); }
+    /* Link back-pressure: nothing is dispatched while this returns false */
+    void set_ready_fn(std::function<bool()> fn) { ready_fn_ = std::move(fn); }
+    /* Airtime budget: background classes wait while this returns false */
+    void set_budget_fn(std::function<bool()> fn) { budget_fn_ = std::move(fn); }
+
+    /* Queue a command. Interactive commands go out immediately when nothing of
+     * their class is already waiting and the link is ready; everything else
+     * waits for poll(). */
+    void enqueue(const Command &cmd, TxClass cls, uint32_t now,
+                 TxSource source = TxSource::Internal);
+    void poll(uint32_t now);
+    void clear();
+
+    size_t depth(TxClass cls) const { return queues_[static_cast<size_t>(cls)].size(); }
+    const TxClassStats &stats(TxClass cls) const { return stats_[static_cast<size_t>(cls)]; }
+    std::string stats_json() const;
+
+    /* Source of the command being handed to the send function */
+    TxSource dispatch_source() const { return dispatch_source_; }
+
+    static const char *class_name(TxClass cls);
+    static const char *source_name(TxSource source);
+
+    /* Minimum gap after any transmission before background work may send */
+    static constexpr uint32_t BACKGROUND_SPACING_MS = 120;
+
+ protected:
+    struct Entry {
+        Command cmd;
+        uint32_t enqueued_ms;
+        TxSource source;
+    };
+
+    /* 0 = unbounded. Provisioning carries group edits whose DB change is
+     * already committed, so dropping one would split DB and mesh. */
+    static constexpr size_t MAX_DEPTH[TX_CLASS_COUNT] = {64, 32, 0, 8};
+
+    std::function<void(const Command &)> send_fn_;
+    std::function<bool()> ready_fn_;
+    std::function<bool()> budget_fn_;
+    std::deque<Entry> queues_[TX_CLASS_COUNT];
+    TxClassStats stats_[TX_CLASS_COUNT];
+    uint32_t background_gate_ms_{0};
+    TxSource dispatch_source_{TxSource::Internal};
+
+    bool ready_() const { return !ready_fn_ || ready_fn_(); }
+    void dispatch_(TxClass cls, const Entry &e, uint32_t now);
+    static bool same_command_(const Command &a, const Command &b);
+    static bool same_write_target_(const Command &a, const Command &b);
+};
+
+}  // namespace avionmesh
@@ -1,109 +1,158 @@
 #include "mqtt_discovery.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
 #ifdef USE_ESP32
 #include "esphome/components/mqtt/mqtt_client.h"
 #endif
 
 namespace avionmesh {
 
-std::string MqttDiscovery::state_topic(uint16_t avion_id) const {
-    char buf[128];
-    snprintf(buf, sizeof(buf), "%s/light/%u/state",
-             topic_prefix_.c_str(), avion_id);
-    return buf;
+void MqttDiscovery::set_node_name(const std::string &name) {
+    node_name_ = name;
+    rebuild_topics_();
 }
 
-std::string MqttDiscovery::command_topic(uint16_t avion_id) const {
-    char buf[128];
-    snprintf(buf, sizeof(buf), "%s/light/%u/set",
-             topic_prefix_.c_str(), avion_id);
-    return buf;
+void MqttDiscovery::set_topic_prefix(const std::string &prefix) {
+    topic_prefix_ = prefix;
+    rebuild_topics_();
 }
 
-std::string MqttDiscovery::brightness_state_topic(uint16_t avion_id) const {
-    char buf[128];
-    snprintf(buf, sizeof(buf), "%s/light/%u/brightness/state",
-             topic_prefix_.c_str(), avion_id);
-    return buf;
+void MqttDiscovery::rebuild_topics_() {
+    topics_.clear();
+    management_command_topic_ = topic_prefix_ + "/avionmesh/command";
+    management_response_topic_ = topic_prefix_ + "/avionmesh/response";
+    airtime_topic_ = topic_prefix_ + "/avionmesh/airtime";
+    light_topic_base_ = topic_prefix_ + "/light/";
+    switch_command_filter_ = light_topic_base_ + "+/set";
+    attr_command_filter_ = light_topic_base_ + "+/+/set";
 }
 
-std::string MqttDiscovery::brightness_command_topic(uint16_t avion_id) const {
-    char buf[128];
-    snprintf(buf, sizeof(buf), "%s/light/%u/brightness/set",
-             topic_prefix_.c_str(), avion_id);
-    return buf;
-}
+bool MqttDiscovery::parse_command_topic(const std::string &topic, uint16_t &avion_id,
+                                        LightCommand &cmd) const {
+    size_t pos = light_topic_base_.size();
+    if (topic.size() <= pos || topic.compare(0, pos, light_topic_base_) != 0)
+        return false;
 
-std::string MqttDiscovery::color_temp_state_topic(uint16_t avion_id) const {
-    char buf[128];
-    snprintf(buf, sizeof(buf), "%s/light/%u/color_temp/state",
-             topic_prefix_.c_str(), avion_id);
-    return buf;
+    uint32_t id = 0;
+    size_t digits = 0;
+    while (pos < topic.size() && topic[pos] >= '0' && topic[pos] <= '9' && digits < 6) {
+        id = id * 10 + (topic[pos] - '0');
+        pos++;
+        digits++;
+    }
+    if (digits == 0 || id > 0xFFFF)
+        return false;
+
+    if (topic.compare(pos, std::string::npos, "/set") == 0) {
+        cmd = LightCommand::Switch;
+    } else if (topic.compare(pos, std::string::npos, "/brightness/set") == 0) {
+        cmd = LightCommand::Brightness;
+    } else if (topic.compare(pos, std::string::npos, "/color_temp/set") == 0) {
+        cmd = LightCommand::ColorTemp;
+    } else {
+        return false;
+    }
+    avion_id = static_cast<uint16_t>(id);
+    return true;
 }
 
-std::string MqttDiscovery::color_temp_command_topic(uint16_t avion_id) const {
-    char buf[128];
-    snprintf(buf, sizeof(buf), "%s/light/%u/color_temp/set",
-             topic_prefix_.c_str(), avion_id);
-    return buf;
+std::string MqttDiscovery::light_topic_base(uint16_t avion_id) const {
+    return light_topic_base_ + std::to_string(avion_id);
 }
 
 std::string MqttDiscovery::discovery_topic(uint16_t avion_id) const {
     char buf[128];
-    snprintf(buf, sizeof(buf), "homeassistant/light/%s_%u/config",
-             node_name_.c_str(), avion_id);
+    snprintf(buf, sizeof(buf), "homeassistant/light/%s_%u/config", node_name_.c_str(), avion_id);
     return buf;
 }
 
-std::string MqttDiscovery::management_command_topic() const {
-    char buf[128];
-    snprintf(buf, sizeof(buf), "%s/avionmesh/command",
-             topic_prefix_.c_str());
-    return buf;
+const MqttDiscovery::LightTopics &MqttDiscovery::topics(uint16_t avion_id) const {
+    auto it = topics_.find(avion_id);
+    if (it != topics_.end())
+        return it->second;
+
+    char base[96];
+    int len = snprintf(base, sizeof(base), "%s/light/%u", topic_prefix_.c_str(), avion_id);
+    len = std::max(0, std::min(len, static_cast<int>(sizeof(base)) - 1));
+    LightTopics t;
+    t.base_len = static_cast<uint16_t>(len);
+    t.arena.reserve(3 * len + 43);
+    for (const char *suffix : {"/state", "/brightness/state", "/color_temp/state"}) {
+        t.arena.append(base, len);
+        t.arena.append(suffix);
+        t.arena.push_back('\0');
+    }
+    t.arena.pop_back();  // c_str() supplies the last terminator
+    return topics_.emplace(avion_id, std::move(t)).first->second;
 }
 
-std::string MqttDiscovery::management_response_topic() const {
-    char buf[128];
-    snprintf(buf, sizeof(buf), "%s/avionmesh/response",
-             topic_prefix_.c_str());
-    return buf;
+size_t MqttDiscovery::topic_table_bytes() const {
+    /* A std::map node carries three pointers and a colour ahead of the value */
+    size_t bytes = 0;
+    for (auto &kv : topics_)
+        bytes += 4 * sizeof(void *) + sizeof(kv) + kv.second.arena.capacity() + 1;
+    return bytes;
 }
 
-void MqttDiscovery::publish_(const std::string &topic, const std::string &payload, bool retain) {
-    if (publish_fn_) {
-        publish_fn_(topic, payload, retain);
-        return;
-    }
+bool MqttDiscovery::publish_(const char *topic, const char *payload, bool retain) {
+    if (publish_fn_)
+        return publish_fn_(topic, payload, retain);
 #ifdef USE_ESP32
     auto *mqtt = esphome::mqtt::global_mqtt_client;
     if (mqtt)
-        mqtt->publish(topic, payload, 0, retain);
+        return mqtt->publish(topic, payload, strlen(payload), 0, retain);
 #endif
+    return false;
 }
 
-void MqttDiscovery::publish_light(uint16_t avion_id, const std::string &name,
+bool MqttDiscovery::publish_light(uint16_t avion_id, const std::string &name,
                                    bool has_brightness, bool has_color_temp,
-                                   const std::string &product_name) {
+                                   const std::string &product_name, bool force) {
+    topics(avion_id);  // state publishes follow
+    const std::string discovery = discovery_topic(avion_id);
+    const std::string base = light_topic_base(avion_id);
     char uid[64];
     snprintf(uid, sizeof(uid), "%s_%u", node_name_.c_str(), avion_id);
 
+    if (device_discovery_) {
+        /* A per-light config left over from before the switch would duplicate the entity */
+        if (config_hashes_.contains(avion_id)) {
+            publish_(discovery, "", true);
+            config_hashes_.erase(avion_id);
+        }
+        add_component_(avion_id, device_component_(avion_id, uid, name, has_brightness, has_color_temp));
+        return true;
+    }
+
     std::string config = "{";
     config += "\"name\":\"" + name + "\",";
     config += "\"unique_id\":\"" + std::string(uid) + "\",";
-    config += "\"command_topic\":\"" + command_topic(avion_id) + "\",";
-    config += "\"state_topic\":\"" + state_topic(avion_id) + "\",";
+    config += "\"command_topic\":\"" + base + "/set\",";
+    config += "\"state_topic\":\"" + base + "/state\",";
+
+    if (json_schema_)
+        config += "\"schema\":\"json\",";
 
     if (has_brightness) {
-        config += "\"brightness_command_topic\":\"" + brightness_command_topic(avion_id) + "\",";
-        config += "\"brightness_state_topic\":\"" + brightness_state_topic(avion_id) + "\",";
+        if (json_schema_) {
+            config += "\"brightness\":true,";
+        } else {
+            config += "\"brightness_command_topic\":\"" + base + "/brightness/set\",";
+            config += "\"brightness_state_topic\":\"" + base + "/brightness/state\",";
+        }
         config += "\"brightness_scale\":255,";
     }
     if (has_color_temp) {
         config += "\"supported_color_modes\":[\"color_temp\"],";
         config += "\"min_mireds\":200,";
         config += "\"max_mireds\":370,";
-        config += "\"color_temp_command_topic\":\"" + color_temp_command_topic(avion_id) + "\",";
-        config += "\"color_temp_state_topic\":\"" + color_temp_state_topic(avion_id) + "\",";
+        if (!json_schema_) {
+            config += "\"color_temp_command_topic\":\"" + base + "/color_temp/set\",";
+            config += "\"color_temp_state_topic\":\"" + base + "/color_temp/state\",";
+        }
     } else if (has_brightness) {
         config += "\"supported_color_modes\":[\"brightness\"],";
     }
@@ -119,28 +168,267 @@ void MqttDiscovery::publish_light(uint16_t avion_id, const std::string &name,
 
     config += "}";
 
-    publish_(discovery_topic(avion_id), config, true);
+    uint32_t hash = ConfigHashes::hash(discovery, config);
+    if (!force && config_hashes_.matches(avion_id, hash)) {
+        configs_skipped_++;
+        return true;
+    }
+    if (!publish_(discovery, config, true))
+        return false;
+    config_hashes_.set(avion_id, hash);
+    configs_published_++;
+    config_bytes_ += discovery.size() + config.size();
+    return true;
 }
 
 void MqttDiscovery::remove_light(uint16_t avion_id) {
-    publish_(discovery_topic(avion_id), "", true);
+    if (device_discovery_)
+        remove_component_(avion_id);
+    if (!device_discovery_ || config_hashes_.contains(avion_id))
+        publish_(discovery_topic(avion_id), "", true);
+    config_hashes_.erase(avion_id);
+    forget_state(avion_id);
+    topics_.erase(avion_id);
+}
+
+/* ---- Device-based discovery ---- */
+
+std::string MqttDiscovery::device_component_(uint16_t avion_id, const std::string &uid,
+                                             const std::string &name, bool has_brightness,
+                                             bool has_color_temp) {
+    /* Abbreviated keys and a "~" base topic keep each component small, so
+     * more fit in one chunk */
+    std::string c = "\"" + uid + "\":{\"p\":\"light\",";
+    c += "\"name\":\"" + name + "\",";
+    c += "\"uniq_id\":\"" + uid + "\",";
+    c += "\"~\":\"" + light_topic_base(avion_id) + "\",";
+    c += "\"cmd_t\":\"~/set\",\"stat_t\":\"~/state\",";
+    if (json_schema_)
+        c += "\"schema\":\"json\",";
+    if (has_brightness) {
+        if (json_schema_)
+            c += "\"brightness\":true,";
+        else
+            c += "\"bri_cmd_t\":\"~/brightness/set\",\"bri_stat_t\":\"~/brightness/state\",";
+        c += "\"bri_scl\":255,";
+    }
+    if (has_color_temp) {
+        c += "\"sup_clrm\":[\"color_temp\"],\"min_mirs\":200,\"max_mirs\":370,";
+        if (!json_schema_)
+            c += "\"clr_temp_cmd_t\":\"~/color_temp/set\",\"clr_temp_stat_t\":\"~/color_temp/state\",";
+    } else if (has_brightness) {
+        c += "\"sup_clrm\":[\"brightness\"],";
+    }
+    c.back() = '}';
+    return c;
 }
 
-void MqttDiscovery::publish_on_off_state(uint16_t avion_id, bool on) {
-    publish_(state_topic(avion_id), on ? "ON" : "OFF", true);
+std::string MqttDiscovery::device_header_() const {
+    return "{\"dev\":{\"ids\":[\"" + node_name_ + "\"],\"name\":\"" + node_name_ +
+           "\",\"mf\":\"Avi-on\"},\"o\":{\"name\":\"avionmesh\"},\"cmps\":{";
 }
 
-void MqttDiscovery::publish_brightness_state(uint16_t avion_id, uint8_t brightness) {
+std::string MqttDiscovery::device_config_topic(size_t chunk) const {
+    char buf[96];
+    snprintf(buf, sizeof(buf), "homeassistant/device/%s_lights_%u/config", node_name_.c_str(),
+             static_cast<unsigned>(chunk));
+    return buf;
+}
+
+size_t MqttDiscovery::chunk_size_(const DeviceChunk &chunk) {
+    size_t n = 0;
+    for (auto &kv : chunk.components)
+        n += kv.second.size() + 1;
+    for (auto &r : chunk.removed)
+        n += r.size() + 1;
+    return n;
+}
+
+std::string MqttDiscovery::device_payload_(const DeviceChunk &chunk) const {
+    std::string payload = device_header_();
+    payload.reserve(payload.size() + chunk_size_(chunk) + 2);
+    bool first = true;
+    for (auto &r : chunk.removed) {
+        if (!first)
+            payload += ",";
+        payload += r;
+        first = false;
+    }
+    for (auto &kv : chunk.components) {
+        if (!first)
+            payload += ",";
+        payload += kv.second;
+        first = false;
+    }
+    payload += "}}";
+    return payload;
+}
+
+void MqttDiscovery::add_component_(uint16_t avion_id, std::string entry) {
+    size_t budget = chunk_bytes_ > device_header_().size() + 2 ? chunk_bytes_ - device_header_().size() - 2 : 0;
+
+    auto it = chunk_of_.find(avion_id);
+    if (it != chunk_of_.end()) {
+        auto &chunk = chunks_[it->second];
+        auto &cur = chunk.components[avion_id];
+        if (cur == entry)
+            return;
+        if (chunk_size_(chunk) - cur.size() + entry.size() <= budget) {
+            cur = std::move(entry);
+            chunk.dirty = true;
+            return;
+        }
+        // Grew out of its chunk; the new chunk re-registers it, so no tombstone
+        remove_component_(avion_id, false);
+    }
+
+    /* First chunk with room, so a new light only touches one config */
+    size_t idx = 0;
+    while (idx < chunks_.size() && chunk_size_(chunks_[idx]) + entry.size() + 1 > budget)
+        idx++;
+    if (idx == chunks_.size())
+        chunks_.emplace_back();
+    auto &chunk = chunks_[idx];
+    /* Re-exposed before the removal went out: the tombstone would cancel it */
+    std::string key = entry.substr(0, entry.find(':') + 1);
+    chunk.removed.erase(std::remove_if(chunk.removed.begin(), chunk.removed.end(),
+                                       [&key](const std::string &r) { return r.compare(0, key.size(), key) == 0; }),
+                        chunk.removed.end());
+    chunk.components[avion_id] = std::move(entry);
+    chunk.dirty = true;
+    chunk_of_[avion_id] = idx;
+}
+
+void MqttDiscovery::remove_component_(uint16_t avion_id, bool tombstone) {
+    auto it = chunk_of_.find(avion_id);
+    if (it == chunk_of_.end())
+        return;
+    auto &chunk = chunks_[it->second];
+    chunk.components.erase(avion_id);
+    if (tombstone) {
+        /* HA drops a component when it is listed with only its platform */
+        char uid[64];
+        snprintf(uid, sizeof(uid), "%s_%u", node_name_.c_str(), avion_id);
+        chunk.removed.push_back("\"" + std::string(uid) + "\":{\"p\":\"light\"}");
+    }
+    chunk.dirty = true;
+    chunk_of_.erase(it);
+}
+
+bool MqttDiscovery::device_configs_pending() const {
+    for (auto &chunk : chunks_)
+        if (chunk.dirty)
+            return true;
+    return false;
+}
+
+void MqttDiscovery::invalidate_device_configs() {
+    for (auto &chunk : chunks_) {
+        chunk.dirty = true;
+        chunk.force = true;
+    }
+}
+
+bool MqttDiscovery::flush_device_configs() {
+    for (size_t i = 0; i < chunks_.size(); i++) {
+        auto &chunk = chunks_[i];
+        if (!chunk.dirty)
+            continue;
+        std::string topic = device_config_topic(i);
+        std::string payload = device_payload_(chunk);
+        uint32_t key = ConfigHashes::DEVICE_CHUNK_KEY + i;
+        uint32_t hash = ConfigHashes::hash(topic, payload);
+        if (!chunk.force && config_hashes_.matches(key, hash)) {
+            configs_skipped_++;
+        } else {
+            if (!publish_(topic, payload, true))
+                return false;
+            config_hashes_.set(key, hash);
+            configs_published_++;
+            config_bytes_ += topic.size() + payload.size();
+        }
+        chunk.removed.clear();
+        chunk.dirty = false;
+        chunk.force = false;
+    }
+    return true;
+}
+
+void MqttDiscovery::retire_device_configs() {
+    std::vector<uint32_t> stale;
+    for (auto &kv : config_hashes_.entries())
+        if (kv.first >= ConfigHashes::DEVICE_CHUNK_KEY &&
+            (!device_discovery_ || kv.first - ConfigHashes::DEVICE_CHUNK_KEY >= chunks_.size()))
+            stale.push_back(kv.first);
+    for (uint32_t key : stale) {
+        publish_(device_config_topic(key - ConfigHashes::DEVICE_CHUNK_KEY), "", true);
+        config_hashes_.erase(key);
+    }
+}
+
+bool MqttDiscovery::publish_state_(const char *topic, const char *payload) {
+    if (!publish_(topic, payload, true)) {
+        states_failed_++;
+        return false;
+    }
+    states_published_++;
+    return true;
+}
+
+void MqttDiscovery::publish_on_off_state(uint16_t avion_id, bool on, bool force) {
+    auto &last = last_state_[avion_id];
+    int8_t value = on ? 1 : 0;
+    if (state_unchanged_(last.on, value, force))
+        return;
+    if (publish_state_(state_topic(avion_id), on ? "ON" : "OFF"))
+        last.on = value;
+}
+
+void MqttDiscovery::publish_brightness_state(uint16_t avion_id, uint8_t brightness, bool force) {
+    auto &last = last_state_[avion_id];
+    if (state_unchanged_<int16_t>(last.brightness, brightness, force))
+        return;
     char payload[8];
     snprintf(payload, sizeof(payload), "%u", brightness);
-    publish_(brightness_state_topic(avion_id), payload, true);
+    if (publish_state_(brightness_state_topic(avion_id), payload))
+        last.brightness = brightness;
 }
 
-void MqttDiscovery::publish_color_temp_state(uint16_t avion_id, uint16_t kelvin) {
+void MqttDiscovery::publish_color_temp_state(uint16_t avion_id, uint16_t kelvin, bool force) {
+    auto &last = last_state_[avion_id];
+    int32_t mireds = kelvin > 0 ? 1000000u / kelvin : 0;
+    if (state_unchanged_(last.mireds, mireds, force))
+        return;
     char payload[8];
-    uint16_t mireds = kelvin > 0 ? 1000000u / kelvin : 0;
-    snprintf(payload, sizeof(payload), "%u", mireds);
-    publish_(color_temp_state_topic(avion_id), payload, true);
+    snprintf(payload, sizeof(payload), "%u", static_cast<unsigned>(mireds));
+    if (publish_state_(color_temp_state_topic(avion_id), payload))
+        last.mireds = mireds;
+}
+
+void MqttDiscovery::publish_json_state(uint16_t avion_id, uint8_t brightness, bool has_ct,
+                                       uint16_t kelvin, bool force) {
+    auto &last = last_state_[avion_id];
+    int32_t mireds = has_ct && kelvin > 0 ? 1000000u / kelvin : -1;
+    int8_t on = brightness > 0 ? 1 : 0;
+    if (!force && last.on == on && last.brightness == brightness && last.mireds == mireds) {
+        states_suppressed_++;
+        return;
+    }
+
+    char payload[96];
+    if (mireds >= 0) {
+        snprintf(payload, sizeof(payload),
+                 "{\"state\":\"%s\",\"brightness\":%u,\"color_mode\":\"color_temp\",\"color_temp\":%d}",
+                 on ? "ON" : "OFF", brightness, static_cast<int>(mireds));
+    } else {
+        snprintf(payload, sizeof(payload), "{\"state\":\"%s\",\"brightness\":%u}", on ? "ON" : "OFF",
+                 brightness);
+    }
+    if (!publish_state_(state_topic(avion_id), payload))
+        return;
+    last.on = on;
+    last.brightness = brightness;
+    last.mireds = mireds;
 }
 
 }  // namespace avionmesh
@@ -1,45 +1,181 @@
 #pragma once
 
+#include "config_hashes.h"
+
 #include <cstdint>
 #include <functional>
+#include <map>
 #include <string>
+#include <vector>
 
 namespace avionmesh {
 
+/* Which command topic of a light a message arrived on */
+enum class LightCommand : uint8_t { Switch, Brightness, ColorTemp };
+
 class MqttDiscovery {
  public:
-    void set_node_name(const std::string &name) { node_name_ = name; }
-    void set_topic_prefix(const std::string &prefix) { topic_prefix_ = prefix; }
-    void set_publish_fn(std::function<void(const std::string &, const std::string &, bool)> fn) {
+    void set_node_name(const std::string &name);
+    void set_topic_prefix(const std::string &prefix);
+    /* HA JSON schema: one state and one command topic per light, carrying
+     * state, brightness and color temp together */
+    void set_json_schema(bool json) { json_schema_ = json; }
+    bool json_schema() const { return json_schema_; }
+    /* fn(topic, payload, retain) returns false when the MQTT client did not
+     * accept the message */
+    void set_publish_fn(std::function<bool(const char *, const char *, bool)> fn) {
         publish_fn_ = std::move(fn);
     }
 
-    void publish_light(uint16_t avion_id, const std::string &name,
+    /* False when the client refused the config (outbox full, disconnected).
+     * A config whose hash matches the last one published for the entity is
+     * skipped (the broker still holds it retained) unless forced. */
+    bool publish_light(uint16_t avion_id, const std::string &name,
                        bool has_brightness, bool has_color_temp,
-                       const std::string &product_name = "");
+                       const std::string &product_name = "", bool force = false);
+    ConfigHashes &config_hashes() { return config_hashes_; }
+
+    /* HA device-based discovery: the lights become components of one gateway
+     * device, published as a few chunked configs under
+     * homeassistant/device/<node_name>_lights_<n>/config. publish_light and
+     * remove_light only update the component map; flush_device_configs()
+     * publishes the chunks that changed. */
+    static constexpr size_t DEFAULT_CHUNK_BYTES = 4096;
+    void set_device_discovery(bool device) { device_discovery_ = device; }
+    bool device_discovery() const { return device_discovery_; }
+    void set_chunk_bytes(size_t bytes) { chunk_bytes_ = bytes; }
+    /* False when the client refused a chunk; the rest stay pending */
+    bool flush_device_configs();
+    bool device_configs_pending() const;
+    /* Republish every chunk on the next flush, even if unchanged */
+    void invalidate_device_configs();
+    /* Clear retained configs of the mode not in use (after switching modes) */
+    void retire_device_configs();
+    size_t device_chunks() const { return chunks_.size(); }
+    std::string device_config_topic(size_t chunk) const;
+    uint32_t configs_published() const { return configs_published_; }
+    uint32_t configs_skipped() const { return configs_skipped_; }
+    uint32_t config_bytes() const { return config_bytes_; }
 
     void remove_light(uint16_t avion_id);
 
-    void publish_on_off_state(uint16_t avion_id, bool on);
-    void publish_brightness_state(uint16_t avion_id, uint8_t brightness);
-    void publish_color_temp_state(uint16_t avion_id, uint16_t kelvin);
+    /* Retained state publishes are skipped when the value equals the last one
+     * published for the entity, unless forced (HA restart, newly exposed).
+     * A value the client refused is not remembered, so the next report (or
+     * the republish on MQTT reconnect) sends it again. */
+    void publish_on_off_state(uint16_t avion_id, bool on, bool force = false);
+    void publish_brightness_state(uint16_t avion_id, uint8_t brightness, bool force = false);
+    void publish_color_temp_state(uint16_t avion_id, uint16_t kelvin, bool force = false);
+    /* JSON schema state; color_temp is only included when has_ct */
+    void publish_json_state(uint16_t avion_id, uint8_t brightness, bool has_ct, uint16_t kelvin,
+                            bool force = false);
+    void forget_state(uint16_t avion_id) { last_state_.erase(avion_id); }
+    uint32_t states_published() const { return states_published_; }
+    uint32_t states_suppressed() const { return states_suppressed_; }
+    uint32_t states_failed() const { return states_failed_; }
 
-    std::string state_topic(uint16_t avion_id) const;
-    std::string command_topic(uint16_t avion_id) const;
-    std::string brightness_state_topic(uint16_t avion_id) const;
-    std::string brightness_command_topic(uint16_t avion_id) const;
-    std::string color_temp_state_topic(uint16_t avion_id) const;
-    std::string color_temp_command_topic(uint16_t avion_id) const;
+    /* The three state topics of a light, the only ones published per state
+     * change, formatted once when the light is exposed (or first used) and
+     * kept until the prefix or node name changes. They share one allocation:
+     * "<base>/state\0<base>/brightness/state\0<base>/color_temp/state", with
+     * offsets fixed by the length of <base> = <prefix>/light/<id>. */
+    struct LightTopics {
+        std::string arena;
+        uint16_t base_len{0};
+        const char *state() const { return arena.c_str(); }
+        const char *brightness_state() const { return arena.c_str() + base_len + 7; }
+        const char *color_temp_state() const { return arena.c_str() + 2 * base_len + 25; }
+    };
+    const LightTopics &topics(uint16_t avion_id) const;
+    size_t topic_table_size() const { return topics_.size(); }
+    /* Heap held by the table: map nodes plus arenas */
+    size_t topic_table_bytes() const;
+
+    const char *state_topic(uint16_t avion_id) const { return topics(avion_id).state(); }
+    const char *brightness_state_topic(uint16_t avion_id) const { return topics(avion_id).brightness_state(); }
+    const char *color_temp_state_topic(uint16_t avion_id) const { return topics(avion_id).color_temp_state(); }
+    /* Used only when building configs and filters; formatted on demand */
+    std::string light_topic_base(uint16_t avion_id) const;
+    std::string command_topic(uint16_t avion_id) const { return light_topic_base(avion_id) + "/set"; }
+    std::string brightness_command_topic(uint16_t avion_id) const {
+        return light_topic_base(avion_id) + "/brightness/set";
+    }
+    std::string color_temp_command_topic(uint16_t avion_id) const {
+        return light_topic_base(avion_id) + "/color_temp/set";
+    }
     std::string discovery_topic(uint16_t avion_id) const;
-    std::string management_command_topic() const;
-    std::string management_response_topic() const;
+    const std::string &management_command_topic() const { return management_command_topic_; }
+    const std::string &management_response_topic() const { return management_response_topic_; }
+    const std::string &airtime_topic() const { return airtime_topic_; }
+
+    /* Two wildcard filters cover the command topics of every light:
+     * <prefix>/light/+/set and <prefix>/light/+/+/set */
+    const std::string &switch_command_filter() const { return switch_command_filter_; }
+    const std::string &attr_command_filter() const { return attr_command_filter_; }
+    /* Split a light command topic into ID and attribute, without allocating.
+     * False for anything else (state topics, other prefixes, bad IDs). */
+    bool parse_command_topic(const std::string &topic, uint16_t &avion_id, LightCommand &cmd) const;
 
  protected:
     std::string node_name_;
     std::string topic_prefix_;
-    std::function<void(const std::string &, const std::string &, bool)> publish_fn_;
+    bool json_schema_{false};
+    /* std::map: references handed out stay valid as lights are added */
+    mutable std::map<uint16_t, LightTopics> topics_;
+    std::string management_command_topic_;
+    std::string management_response_topic_;
+    std::string airtime_topic_;
+    std::string light_topic_base_;
+    std::string switch_command_filter_;
+    std::string attr_command_filter_;
+    std::function<bool(const char *, const char *, bool)> publish_fn_;
+
+    /* Last published state payloads per entity; -1 = nothing published yet */
+    struct LastState {
+        int8_t on{-1};
+        int16_t brightness{-1};
+        int32_t mireds{-1};
+    };
+    std::map<uint16_t, LastState> last_state_;
+    ConfigHashes config_hashes_;
+
+    struct DeviceChunk {
+        std::map<uint16_t, std::string> components;  // avion_id -> "uid":{...}
+        std::vector<std::string> removed;             // "uid":{"p":"light"}, sent once
+        bool dirty{false};
+        bool force{false};
+    };
+    bool device_discovery_{false};
+    size_t chunk_bytes_{DEFAULT_CHUNK_BYTES};
+    std::vector<DeviceChunk> chunks_;
+    std::map<uint16_t, size_t> chunk_of_;
+    uint32_t configs_published_{0};
+    uint32_t configs_skipped_{0};
+    uint32_t config_bytes_{0};
+    uint32_t states_published_{0};
+    uint32_t states_suppressed_{0};
+    uint32_t states_failed_{0};
 
-    void publish_(const std::string &topic, const std::string &payload, bool retain = false);
+    template<typename T> bool state_unchanged_(T last, T value, bool force) {
+        if (force || last != value)
+            return false;
+        states_suppressed_++;
+        return true;
+    }
+    bool publish_state_(const char *topic, const char *payload);
+
+    void rebuild_topics_();
+    std::string device_component_(uint16_t avion_id, const std::string &uid, const std::string &name,
+                                  bool has_brightness, bool has_color_temp);
+    std::string device_header_() const;
+    std::string device_payload_(const DeviceChunk &chunk) const;
+    static size_t chunk_size_(const DeviceChunk &chunk);
+    void add_component_(uint16_t avion_id, std::string entry);
+    void remove_component_(uint16_t avion_id, bool tombstone = true);
+    bool publish_(const char *topic, const char *payload, bool retain = false);
+    bool publish_(const std::string &topic, const std::string &payload, bool retain = false) {
+        return publish_(topic.c_str(), payload.c_str(), retain);
+    }
 };
 
 }  // namespace avionmesh
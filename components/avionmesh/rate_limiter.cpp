@@ -0,0 +1,129 @@
+#include "rate_limiter.h"
+
+#include "esphome/core/log.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace avionmesh {
+
+static const char *TAG = "avionmesh.ratelimit";
+
+/* Log an overloaded target again only after it was quiet this long */
+static constexpr uint32_t OVERLOAD_LOG_QUIET_MS = 60000;
+
+bool RateLimiter::has_token_(Bucket &b, const Rate &rate, uint32_t now) {
+    if (rate.per_s <= 0.0f)
+        return true;
+    if (b.tokens < 0.0f) {
+        b.tokens = rate.burst;
+    } else {
+        b.tokens = std::min(rate.burst, b.tokens + (now - b.updated_ms) * rate.per_s / 1000.0f);
+    }
+    b.updated_ms = now;
+    return b.tokens >= 1.0f;
+}
+
+void RateLimiter::take_(Bucket &b, const Rate &rate) {
+    if (rate.per_s > 0.0f)
+        b.tokens -= 1.0f;
+}
+
+RateLimiter::Bucket *RateLimiter::ingress_bucket_(TxSource source) {
+    if (source == TxSource::Internal)
+        return nullptr;
+    return &sources_[static_cast<size_t>(source)].bucket;
+}
+
+bool RateLimiter::available_(uint16_t target, TxSource source, uint32_t now) {
+    // Refill both, so neither bucket's clock falls behind
+    bool target_ok = has_token_(targets_[target].bucket, target_rate_, now);
+    auto *ingress = ingress_bucket_(source);
+    bool ingress_ok = !ingress || has_token_(*ingress, ingress_rate_, now);
+    return target_ok && ingress_ok;
+}
+
+void RateLimiter::take_tokens_(uint16_t target, TxSource source) {
+    take_(targets_[target].bucket, target_rate_);
+    if (auto *ingress = ingress_bucket_(source))
+        take_(*ingress, ingress_rate_);
+    sources_[static_cast<size_t>(source)].sent++;
+}
+
+bool RateLimiter::admit(uint16_t target, AckAttr attr, uint16_t value, TxSource source, uint32_t now) {
+    uint32_t key = key_(target, attr);
+    // A write already waiting keeps its place; the new value just replaces it
+    if (!pending_.count(key) && available_(target, source, now)) {
+        take_tokens_(target, source);
+        return true;
+    }
+
+    auto &t = targets_[target];
+    if (t.absorbed == 0 || now - t.last_absorbed_ms >= OVERLOAD_LOG_QUIET_MS)
+        ESP_LOGW(TAG, "Rate limiting writes to %u (via %s)", target, MeshTxScheduler::source_name(source));
+    t.absorbed++;
+    t.last_absorbed_ms = now;
+    sources_[static_cast<size_t>(source)].absorbed++;
+    absorbed_total_++;
+    pending_[key] = {value, source};
+    return false;
+}
+
+void RateLimiter::poll(uint32_t now) {
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        uint16_t target = static_cast<uint16_t>(it->first >> 8);
+        Pending p = it->second;
+        if (!available_(target, p.source, now)) {
+            ++it;
+            continue;
+        }
+        take_tokens_(target, p.source);
+        auto attr = static_cast<AckAttr>(it->first & 0xFF);
+        it = pending_.erase(it);
+        if (send_fn_)
+            send_fn_(target, attr, p.value, p.source);
+    }
+}
+
+uint32_t RateLimiter::absorbed(uint16_t target) const {
+    auto it = targets_.find(target);
+    return it != targets_.end() ? it->second.absorbed : 0;
+}
+
+std::string RateLimiter::stats_json() const {
+    char buf[192];
+    snprintf(buf, sizeof(buf),
+             "{\"target_rate\":%.1f,\"target_burst\":%.0f,\"ingress_rate\":%.1f,\"ingress_burst\":%.0f,"
+             "\"pending\":%u,\"absorbed\":%u,\"sources\":{",
+             target_rate_.per_s, target_rate_.burst, ingress_rate_.per_s, ingress_rate_.burst,
+             static_cast<unsigned>(pending_.size()), absorbed_total_);
+    std::string json = buf;
+    for (size_t i = 0; i < TX_SOURCE_COUNT; i++) {
+        snprintf(buf, sizeof(buf), "%s\"%s\":{\"sent\":%u,\"absorbed\":%u}", i > 0 ? "," : "",
+                 MeshTxScheduler::source_name(static_cast<TxSource>(i)), sources_[i].sent,
+                 sources_[i].absorbed);
+        json += buf;
+    }
+
+    /* Worst offenders, so a runaway automation can be traced to its light */
+    std::vector<std::pair<uint16_t, const TargetEntry *>> offenders;
+    for (auto &kv : targets_)
+        if (kv.second.absorbed > 0)
+            offenders.emplace_back(kv.first, &kv.second);
+    std::sort(offenders.begin(), offenders.end(),
+              [](const auto &a, const auto &b) { return a.second->absorbed > b.second->absorbed; });
+    if (offenders.size() > MAX_REPORTED)
+        offenders.resize(MAX_REPORTED);
+
+    json += "},\"overloaded\":[";
+    for (size_t i = 0; i < offenders.size(); i++) {
+        snprintf(buf, sizeof(buf), "%s{\"target\":%u,\"absorbed\":%u,\"last_ms\":%u}", i > 0 ? "," : "",
+                 offenders[i].first, offenders[i].second->absorbed, offenders[i].second->last_absorbed_ms);
+        json += buf;
+    }
+    json += "]}";
+    return json;
+}
+
+}  // namespace avionmesh
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "ack_tracker.h"
+#include "mesh_tx.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+
+namespace avionmesh {
+
+/* Token buckets for light writes, one per target and one per ingress (MQTT
+ * light topics, web, management). A write goes out only when both its
+ * target's and its ingress' bucket hold a token; otherwise it becomes the
+ * pending value for (target, attribute), replacing any older one, and is
+ * sent from poll() once tokens are back. Hub-initiated writes only draw
+ * from the target bucket. */
+class RateLimiter {
+ public:
+    using SendFn = std::function<void(uint16_t target, AckAttr attr, uint16_t value, TxSource source)>;
+
+    void set_send_fn(SendFn fn) { send_fn_ = std::move(fn); }
+    /* Writes per second and burst size; a rate of 0 disables the bucket */
+    void set_target_rate(float per_s, float burst) { target_rate_ = {per_s, burst}; }
+    void set_ingress_rate(float per_s, float burst) { ingress_rate_ = {per_s, burst}; }
+
+    /* True if the write may be sent now (tokens taken). False if it was
+     * absorbed into the pending value for (target, attr). */
+    bool admit(uint16_t target, AckAttr attr, uint16_t value, TxSource source, uint32_t now);
+    /* Drop a pending value, e.g. when the caller sends a superseding write */
+    void cancel(uint16_t target, AckAttr attr) { pending_.erase(key_(target, attr)); }
+    void poll(uint32_t now);
+
+    size_t pending() const { return pending_.size(); }
+    bool is_pending(uint16_t target, AckAttr attr) const { return pending_.count(key_(target, attr)) > 0; }
+    uint32_t absorbed(uint16_t target) const;
+    std::string stats_json() const;
+
+    static constexpr float DEFAULT_TARGET_RATE = 5.0f;
+    static constexpr float DEFAULT_TARGET_BURST = 10.0f;
+    static constexpr float DEFAULT_INGRESS_RATE = 20.0f;
+    static constexpr float DEFAULT_INGRESS_BURST = 40.0f;
+    /* Targets listed under "overloaded" in stats, most absorbed first */
+    static constexpr size_t MAX_REPORTED = 5;
+
+ protected:
+    struct Rate {
+        float per_s;
+        float burst;
+    };
+    struct Bucket {
+        float tokens{-1.0f};  // < 0: not used yet, starts full
+        uint32_t updated_ms{0};
+    };
+    struct TargetEntry {
+        Bucket bucket;
+        uint32_t absorbed{0};
+        uint32_t last_absorbed_ms{0};
+    };
+    struct SourceCounters {
+        Bucket bucket;
+        uint32_t sent{0};
+        uint32_t absorbed{0};
+    };
+    struct Pending {
+        uint16_t value;
+        TxSource source;
+    };
+
+    SendFn send_fn_;
+    Rate target_rate_{DEFAULT_TARGET_RATE, DEFAULT_TARGET_BURST};
+    Rate ingress_rate_{DEFAULT_INGRESS_RATE, DEFAULT_INGRESS_BURST};
+    std::map<uint16_t, TargetEntry> targets_;
+    std::array<SourceCounters, TX_SOURCE_COUNT> sources_{};
+    std::map<uint32_t, Pending> pending_;
+    uint32_t absorbed_total_{0};
+
+    static uint32_t key_(uint16_t target, AckAttr attr) {
+        return (static_cast<uint32_t>(target) << 8) | static_cast<uint8_t>(attr);
+    }
+    static bool has_token_(Bucket &b, const Rate &rate, uint32_t now);
+    static void take_(Bucket &b, const Rate &rate);
+    Bucket *ingress_bucket_(TxSource source);
+    bool available_(uint16_t target, TxSource source, uint32_t now);
+    void take_tokens_(uint16_t target, TxSource source);
+};
+
+}  // namespace avionmesh
@@ -0,0 +1,52 @@
+#include "rx_dedupe.h"
+
+#include <cstdio>
+
+namespace avionmesh {
+
+uint32_t RxDedupe::hash(uint16_t mcp_source, uint16_t crypto_source, uint8_t opcode,
+                        const uint8_t *payload, size_t payload_len) {
+    /* FNV-1a over the decrypted packet */
+    uint32_t h = 2166136261u;
+    auto mix = [&h](uint8_t b) { h = (h ^ b) * 16777619u; };
+    mix(mcp_source >> 8); mix(mcp_source & 0xFF);
+    mix(crypto_source >> 8); mix(crypto_source & 0xFF);
+    mix(opcode);
+    for (size_t i = 0; i < payload_len; i++)
+        mix(payload[i]);
+    return h;
+}
+
+bool RxDedupe::accept(uint8_t bridge, uint16_t mcp_source, uint16_t crypto_source, uint8_t opcode,
+                      const uint8_t *payload, size_t payload_len, uint32_t now) {
+    received_++;
+    uint32_t h = hash(mcp_source, crypto_source, opcode, payload, payload_len);
+    for (auto &slot : slots_) {
+        if (!slot.used || slot.hash != h)
+            continue;
+        // Age is measured from the first copy, so periodic resends still get through
+        uint32_t age = now - slot.ms;
+        if (slot.bridge == bridge && age < SAME_LINK_WINDOW_MS) {
+            same_link_++;
+            return false;
+        }
+        if (slot.bridge != bridge && age < CROSS_LINK_WINDOW_MS) {
+            cross_link_++;
+            return false;
+        }
+    }
+    slots_[next_] = {h, now, bridge, true};
+    next_ = (next_ + 1) % SLOTS;
+    return true;
+}
+
+std::string RxDedupe::stats_json() const {
+    char buf[160];
+    snprintf(buf, sizeof(buf),
+             "{\"received\":%u,\"duplicates\":%u,\"same_link\":%u,\"cross_link\":%u,\"dup_pct\":%.1f}",
+             received_, duplicates(), same_link_, cross_link_,
+             received_ ? 100.0f * duplicates() / received_ : 0.0f);
+    return buf;
+}
+
+}  // namespace avionmesh
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace avionmesh {
+
+/* Recently received mesh packets, keyed by source, opcode and a payload hash.
+ * Relays deliver the same status report several times, on the LOW and HIGH
+ * characteristics of one link and through every other bridge; copies are
+ * dropped before any state, MQTT or SSE work. Entries expire quickly, since a
+ * device may legitimately send the same report again. */
+class RxDedupe {
+ public:
+    static constexpr size_t SLOTS = 32;
+    /* Copies on the link that delivered the packet first */
+    static constexpr uint32_t SAME_LINK_WINDOW_MS = 200;
+    /* Copies relayed by another bridge, which may trail by a connection interval or two */
+    static constexpr uint32_t CROSS_LINK_WINDOW_MS = 500;
+
+    /* True for a new packet (remembered), false for a copy (counted) */
+    bool accept(uint8_t bridge, uint16_t mcp_source, uint16_t crypto_source, uint8_t opcode,
+                const uint8_t *payload, size_t payload_len, uint32_t now);
+    void clear() { slots_ = {}; }
+
+    uint32_t duplicates() const { return same_link_ + cross_link_; }
+    std::string stats_json() const;
+
+    static uint32_t hash(uint16_t mcp_source, uint16_t crypto_source, uint8_t opcode,
+                         const uint8_t *payload, size_t payload_len);
+
+ protected:
+    struct Slot {
+        uint32_t hash;
+        uint32_t ms;
+        uint8_t bridge;
+        bool used;
+    };
+
+    std::array<Slot, SLOTS> slots_{};
+    size_t next_{0};
+    uint32_t received_{0};
+    uint32_t same_link_{0};
+    uint32_t cross_link_{0};
+};
+
+}  // namespace avionmesh
@@ -0,0 +1,166 @@
+#include "state_refresh.h"
+
+#include "esphome/core/log.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace avionmesh {
+
+static const char *TAG = "avionmesh.refresh";
+
+void StateRefresher::start(uint32_t now) {
+    running_ = true;
+    sweep_start_ms_ = now;
+    next_read_ms_ = now;
+}
+
+void StateRefresher::stop(uint32_t now) {
+    if (!running_)
+        return;
+    running_ = false;
+    end_sweep_(now);
+}
+
+void StateRefresher::expire_all() {
+    for (auto &kv : entries_)
+        kv.second.expired = true;
+}
+
+void StateRefresher::on_report(uint16_t avid, uint32_t now) {
+    auto &e = entries_[avid];
+    e.known = true;
+    e.expired = false;
+    e.confirmed_ms = now;
+    if (e.read_sweep == sweeps_ + 1) {
+        sweep_received_++;
+    } else if (e.read_sweep != 0 && e.read_sweep == sweeps_) {
+        // Answer to a read sent just before the previous sweep closed
+        last_received_++;
+        total_received_++;
+    }
+    e.read_sweep = 0;
+}
+
+void StateRefresher::poll(const DeviceDB &db, uint32_t now) {
+    if (!running_)
+        return;
+    if (now - sweep_start_ms_ >= interval_ms_)
+        end_sweep_(now);
+    if (static_cast<int32_t>(now - next_read_ms_) < 0)
+        return;
+
+    /* Longest-waiting device first; never-confirmed ones before all others.
+     * A device already read this sweep waits for the next one if silent. */
+    const DeviceEntry *pick = nullptr;
+    const Entry *pick_e = nullptr;
+    uint32_t due = 0;
+    bool catching_up = false;
+    for (auto &dev : db.devices()) {
+        if (!has_dimming(dev.product_type))
+            continue;
+        auto &e = entries_[dev.avion_id];
+        if (!is_due_(e, now) || e.read_sweep == sweeps_ + 1)
+            continue;
+        due++;
+        if (!e.known || e.expired)
+            catching_up = true;
+        bool older = !pick_e ||
+                     (pick_e->known && (!e.known || now - e.confirmed_ms > now - pick_e->confirmed_ms));
+        if (older) {
+            pick = &dev;
+            pick_e = &e;
+        }
+    }
+    due_ = due;
+    if (!pick)
+        return;
+
+    uint32_t packets = 0;
+    bool read_group = false;
+    for (auto &grp : db.groups()) {
+        const SlotBitset &members = db.members(grp);
+        if (!members.test(pick->slot))
+            continue;
+        size_t member_count = members.count();
+        if (member_count < 2 || member_count > GROUP_READ_MAX)
+            continue;
+        bool all_due = true;
+        bool color = false;
+        for (auto mid : grp.member_ids) {
+            auto it = entries_.find(mid);
+            if (it == entries_.end() || !is_due_(it->second, now) ||
+                it->second.read_sweep == sweeps_ + 1) {
+                all_due = false;
+                break;
+            }
+        }
+        if (!all_due)
+            continue;
+        for (auto &dev : db.devices()) {
+            if (!members.test(dev.slot))
+                continue;
+            color = color || has_color_temp(dev.product_type);
+            entries_[dev.avion_id].read_sweep = sweeps_ + 1;
+            sweep_expected_++;
+        }
+        ESP_LOGD(TAG, "Reading group %u (%zu members due)", grp.group_id, member_count);
+        read_(grp.group_id, color);
+        group_reads_++;
+        packets = color ? 2 : 1;
+        read_group = true;
+        break;
+    }
+    if (!read_group) {
+        bool color = has_color_temp(pick->product_type);
+        entries_[pick->avion_id].read_sweep = sweeps_ + 1;
+        sweep_expected_++;
+        read_(pick->avion_id, color);
+        packets = color ? 2 : 1;
+    }
+
+    /* Catch up at the budget; otherwise spread a full pass over the interval */
+    uint32_t gap = budget_gap_ms_;
+    if (!catching_up && !db.devices().empty())
+        gap = std::max(gap, interval_ms_ / static_cast<uint32_t>(db.devices().size()));
+    next_read_ms_ = now + gap * packets;
+}
+
+void StateRefresher::read_(uint16_t target, bool color) {
+    if (!send_fn_)
+        return;
+    Command cmd;
+    cmd_read_dimming(target, cmd);
+    send_fn_(cmd);
+    if (color) {
+        cmd_read_color(target, cmd);
+        send_fn_(cmd);
+    }
+}
+
+void StateRefresher::end_sweep_(uint32_t now) {
+    if (sweep_expected_ > 0) {
+        sweeps_++;
+        last_expected_ = sweep_expected_;
+        last_received_ = sweep_received_;
+        total_expected_ += sweep_expected_;
+        total_received_ += sweep_received_;
+        ESP_LOGD(TAG, "Refresh sweep %u: %u/%u replies", sweeps_, sweep_received_, sweep_expected_);
+    }
+    sweep_expected_ = 0;
+    sweep_received_ = 0;
+    sweep_start_ms_ = now;
+}
+
+std::string StateRefresher::stats_json() const {
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+             "{\"interval_ms\":%u,\"read_gap_ms\":%u,\"due\":%u,\"sweeps\":%u,"
+             "\"last_expected\":%u,\"last_received\":%u,\"expected\":%u,\"received\":%u,"
+             "\"group_reads\":%u}",
+             interval_ms_, budget_gap_ms_, due_, sweeps_, last_expected_, last_received_,
+             total_expected_, total_received_, group_reads_);
+    return buf;
+}
+
+}  // namespace avionmesh
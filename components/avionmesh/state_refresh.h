@@ -0,0 +1,83 @@
+#pragma once
+
+#include "device_db.h"
+
+#include <avionmesh/avionmesh.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+
+namespace avionmesh {
+
+/* Background state refresh. Instead of a broadcast read that makes every
+ * device answer at once, reads go out one target at a time: devices whose
+ * state was never confirmed first, then the longest unconfirmed. Steady-state
+ * reads are spread over the refresh interval; catching up never exceeds the
+ * read budget. A group is read in one packet when all of its members are
+ * due. Any status report counts as a confirmation, solicited or not. */
+class StateRefresher {
+ public:
+    void set_send_fn(std::function<void(const Command &)> fn) { send_fn_ = std::move(fn); }
+    void set_interval(uint32_t interval_ms) { interval_ms_ = interval_ms; }
+    /* Reads per second while catching up */
+    void set_budget(float reads_per_s) { budget_gap_ms_ = static_cast<uint32_t>(1000.0f / reads_per_s); }
+    uint32_t interval_ms() const { return interval_ms_; }
+
+    void start(uint32_t now);
+    void stop(uint32_t now);
+    bool running() const { return running_; }
+    /* Read everything again soon, oldest first, keeping what is known */
+    void expire_all();
+    /* Forget every confirmation, e.g. while the mesh was unreachable */
+    void forget_all() { entries_.clear(); }
+    /* Stop reading a removed device */
+    void forget(uint16_t avid) { entries_.erase(avid); }
+    bool tracks(uint16_t avid) const { return entries_.count(avid) > 0; }
+
+    void on_report(uint16_t avid, uint32_t now);
+    void poll(const DeviceDB &db, uint32_t now);
+
+    std::string stats_json() const;
+
+    static constexpr uint32_t DEFAULT_INTERVAL_MS = 60000;
+    /* Groups up to this size may be read with one packet */
+    static constexpr size_t GROUP_READ_MAX = 8;
+
+ protected:
+    struct Entry {
+        uint32_t confirmed_ms{0};
+        bool known{false};
+        bool expired{false};
+        uint32_t read_sweep{0};  // sweep number + 1 of an unanswered read, 0 if none
+    };
+
+    std::function<void(const Command &)> send_fn_;
+    std::map<uint16_t, Entry> entries_;
+    uint32_t interval_ms_{DEFAULT_INTERVAL_MS};
+    uint32_t budget_gap_ms_{500};
+    bool running_{false};
+    uint32_t next_read_ms_{0};
+
+    /* Sweep accounting: one sweep per interval in which reads were sent */
+    uint32_t sweep_start_ms_{0};
+    uint32_t sweeps_{0};
+    uint32_t sweep_expected_{0};
+    uint32_t sweep_received_{0};
+    uint32_t last_expected_{0};
+    uint32_t last_received_{0};
+    uint32_t total_expected_{0};
+    uint32_t total_received_{0};
+    uint32_t group_reads_{0};
+    uint32_t due_{0};  // devices due at the last poll that read
+
+    bool is_due_(const Entry &e, uint32_t now) const {
+        return !e.known || e.expired || now - e.confirmed_ms >= interval_ms_;
+    }
+    void end_sweep_(uint32_t now);
+    void read_(uint16_t target, bool color);
+};
+
+}  // namespace avionmesh
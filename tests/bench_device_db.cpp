@@ -0,0 +1,75 @@
+// Benchmark: DeviceDB lookups done for one received status report (device,
+// its groups for the state latch, then the device again when publishing),
+// linear scan as before versus the ID index, at 50 / 500 / 2000 devices.
+// Not a test; run by hand:
+//   ./_gate_build/avionmesh_bench_device_db
+
+#include "device_db.h"
+
+#include <chrono>
+#include <cstdio>
+
+using namespace avionmesh;
+
+static constexpr int RX_PER_SIZE = 200000;
+static constexpr uint16_t FIRST_ID = 32896;
+static constexpr uint16_t GROUPS = 64;
+
+/* The old find_device / find_group */
+template<typename T, typename Key> static const T *linear_find(const std::vector<T> &v, uint16_t id, Key key) {
+    for (auto &e : v)
+        if (key(e) == id)
+            return &e;
+    return nullptr;
+}
+
+template<typename F> static double ns_per_rx(size_t devices, F &&lookup) {
+    uintptr_t sink = 0;
+    uint32_t rng = 12345;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < RX_PER_SIZE; i++) {
+        rng = rng * 1664525u + 1013904223u;
+        sink += lookup(static_cast<uint16_t>(FIRST_ID + (rng >> 8) % devices));
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    if (sink == 1)
+        printf("\n");  // keep the loop from being optimised away
+    return static_cast<double>(ns) / RX_PER_SIZE;
+}
+
+int main() {
+    printf("%8s %14s %14s\n", "devices", "linear ns/rx", "index ns/rx");
+    for (size_t n : {50, 500, 2000}) {
+        DeviceDB db;
+        for (uint16_t g = 1; g <= GROUPS; g++)
+            db.add_group(g, "Group");
+        for (size_t i = 0; i < n; i++) {
+            auto id = static_cast<uint16_t>(FIRST_ID + i);
+            db.add_device(id, 93, "Light");
+            // Every light in two groups, as in a typical room / floor layout
+            db.add_device_to_group(id, static_cast<uint16_t>(1 + i % GROUPS));
+            db.add_device_to_group(id, static_cast<uint16_t>(1 + (i / GROUPS) % GROUPS));
+        }
+
+        auto dev_key = [](const DeviceEntry &d) { return d.avion_id; };
+        auto grp_key = [](const GroupEntry &g) { return g.group_id; };
+        double linear = ns_per_rx(n, [&](uint16_t id) {
+            uintptr_t acc = 0;
+            auto *dev = linear_find(db.devices(), id, dev_key);
+            for (uint16_t gid : dev->groups)
+                acc += reinterpret_cast<uintptr_t>(linear_find(db.groups(), gid, grp_key));
+            acc += reinterpret_cast<uintptr_t>(linear_find(db.devices(), id, dev_key));
+            return acc;
+        });
+        double indexed = ns_per_rx(n, [&](uint16_t id) {
+            uintptr_t acc = 0;
+            auto *dev = db.find_device(id);
+            for (uint16_t gid : dev->groups)
+                acc += reinterpret_cast<uintptr_t>(db.find_group(gid));
+            acc += reinterpret_cast<uintptr_t>(db.find_device(id));
+            return acc;
+        });
+        printf("%8zu %14.1f %14.1f\n", n, linear, indexed);
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+// Benchmark: group state latch decision per brightness report, the old
+// per-report search (candidates, exclusive witnesses, fixed-point subset
+// expansion over member lists) versus GroupLatch's precomputed plans, at
+// 50 / 500 / 2000 devices. Not a test; run by hand:
+//   ./_gate_build/avionmesh_bench_group_latch
+
+#include "group_latch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <set>
+
+using namespace avionmesh;
+
+static constexpr int RX_PER_SIZE = 20000;
+static constexpr uint16_t FIRST_ID = 32896;
+static constexpr uint16_t ROOMS = 64;
+static constexpr uint16_t ROOMS_PER_FLOOR = 8;
+
+static bool member(const GroupEntry &grp, uint16_t mid) {
+    return std::find(grp.member_ids.begin(), grp.member_ids.end(), mid) != grp.member_ids.end();
+}
+
+/* The old check_group_state_latch, returning the number of groups latched */
+static size_t old_latch(DeviceDB &db, const std::map<uint16_t, int> &levels, uint16_t avid, int level) {
+    std::vector<uint16_t> candidate_ids;
+    for (auto &grp : db.groups())
+        if (member(grp, avid))
+            candidate_ids.push_back(grp.group_id);
+    std::set<uint16_t> triggered;
+    for (uint16_t gid : candidate_ids) {
+        auto *grp = db.find_group(gid);
+        for (auto mid : grp->member_ids) {
+            bool exclusive = true;
+            for (uint16_t other : candidate_ids)
+                if (other != gid && member(*db.find_group(other), mid)) { exclusive = false; break; }
+            auto it = levels.find(mid);
+            if (exclusive && it != levels.end() && it->second == level) {
+                triggered.insert(gid);
+                break;
+            }
+        }
+    }
+    bool changed = !triggered.empty();
+    while (changed) {
+        changed = false;
+        for (auto &h : db.groups()) {
+            if (triggered.count(h.group_id) || h.member_ids.empty())
+                continue;
+            for (uint16_t tgid : triggered) {
+                auto *tg = db.find_group(tgid);
+                bool subset = true;
+                for (auto hmid : h.member_ids)
+                    if (!member(*tg, hmid)) { subset = false; break; }
+                if (subset) { triggered.insert(h.group_id); changed = true; break; }
+            }
+        }
+    }
+    return triggered.size();
+}
+
+template<typename F> static double ns_per_rx(size_t devices, F &&report) {
+    size_t sink = 0;
+    uint32_t rng = 12345;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < RX_PER_SIZE; i++) {
+        rng = rng * 1664525u + 1013904223u;
+        sink += report(static_cast<uint16_t>(FIRST_ID + (rng >> 8) % devices), static_cast<int>(rng >> 28) * 16);
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    if (sink == 1)
+        printf("\n");  // keep the loop from being optimised away
+    return static_cast<double>(ns) / RX_PER_SIZE;
+}
+
+int main() {
+    printf("%8s %14s %14s\n", "devices", "search ns/rx", "plans ns/rx");
+    for (size_t n : {50, 500, 2000}) {
+        DeviceDB db;
+        for (uint16_t g = 1; g <= ROOMS + ROOMS / ROOMS_PER_FLOOR; g++)
+            db.add_group(g, "Group");
+        for (size_t i = 0; i < n; i++) {
+            auto id = static_cast<uint16_t>(FIRST_ID + i);
+            db.add_device(id, 93, "Light");
+            // Every light in a room group, and rooms nested in floor groups
+            size_t room = i % ROOMS;
+            db.add_device_to_group(id, static_cast<uint16_t>(1 + room));
+            db.add_device_to_group(id, static_cast<uint16_t>(1 + ROOMS + room / ROOMS_PER_FLOOR));
+        }
+
+        std::map<uint16_t, int> levels;
+        double search = ns_per_rx(n, [&](uint16_t id, int level) {
+            levels[id] = level;
+            return old_latch(db, levels, id, level);
+        });
+
+        levels.clear();
+        GroupLatch latch;
+        latch.set_level_fn([&](uint16_t id) {
+            auto it = levels.find(id);
+            return it != levels.end() ? it->second : -1;
+        });
+        SlotBitset out;
+        double plans = ns_per_rx(n, [&](uint16_t id, int level) {
+            levels[id] = level;
+            latch.on_level(db, id);
+            latch.decide(db, id, static_cast<uint8_t>(level), out);
+            return out.count();
+        });
+        printf("%8zu %14.1f %14.1f\n", n, search, plans);
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+// Benchmark: heap allocations and time per state publish, formatting topics
+// with snprintf on every publish (as before) versus the precomputed topic
+// table in MqttDiscovery, and the heap the table holds per light. Not a
+// test; run by hand:
+//   ./_gate_build/avionmesh_bench_topics
+
+#include "mqtt_discovery.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+
+static size_t g_allocs = 0;
+
+void *operator new(size_t size) {
+    g_allocs++;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+using namespace avionmesh;
+
+static constexpr uint16_t LIGHTS = 64;
+static constexpr int ROUNDS = 1000;
+static size_t g_bytes = 0;
+
+static bool sink(const char *topic, const char *payload, bool) {
+    g_bytes += strlen(topic) + strlen(payload);
+    return true;
+}
+
+/* The old per-publish path: topic formatted into a fresh std::string */
+static std::string format_topic(const std::string &prefix, uint16_t id, const char *suffix) {
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s/light/%u%s", prefix.c_str(), id, suffix);
+    return buf;
+}
+
+static void publish_formatted(const std::string &prefix, uint16_t id, uint8_t brightness) {
+    char payload[8];
+    sink(format_topic(prefix, id, "/state").c_str(), brightness ? "ON" : "OFF", true);
+    snprintf(payload, sizeof(payload), "%u", brightness);
+    sink(format_topic(prefix, id, "/brightness/state").c_str(), payload, true);
+    snprintf(payload, sizeof(payload), "%u", 1000000u / 2700);
+    sink(format_topic(prefix, id, "/color_temp/state").c_str(), payload, true);
+}
+
+template<typename F> static void run(const char *name, F &&publish) {
+    size_t allocs = g_allocs;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++)
+        for (uint16_t id = 0; id < LIGHTS; id++)
+            publish(static_cast<uint16_t>(32896 + id), static_cast<uint8_t>(r & 0xFF));
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    double publishes = 3.0 * ROUNDS * LIGHTS;
+    printf("%-12s %8.2f allocs/publish %8.1f ns/publish\n", name, (g_allocs - allocs) / publishes,
+           ns / publishes);
+}
+
+int main() {
+    const std::string prefix = "avionmesh-bridge";
+    run("snprintf", [&](uint16_t id, uint8_t b) { publish_formatted(prefix, id, b); });
+
+    MqttDiscovery discovery;
+    discovery.set_node_name("avionmesh-bridge");
+    discovery.set_topic_prefix(prefix);
+    discovery.set_publish_fn(sink);
+    for (uint16_t id = 0; id < LIGHTS; id++) {
+        discovery.publish_light(static_cast<uint16_t>(32896 + id), "Light", true, true, "");
+        // Populate the state cache, so the forced publishes below do not insert
+        discovery.publish_on_off_state(static_cast<uint16_t>(32896 + id), false);
+    }
+    run("topic table", [&](uint16_t id, uint8_t b) {
+        discovery.publish_on_off_state(id, b > 0, true);
+        discovery.publish_brightness_state(id, b, true);
+        discovery.publish_color_temp_state(id, 2700, true);
+    });
+    printf("(%zu bytes published)\n", g_bytes);
+    printf("topic table: %zu lights, %zu bytes (%.0f per light)\n", discovery.topic_table_size(),
+           discovery.topic_table_bytes(), static_cast<double>(discovery.topic_table_bytes()) / LIGHTS);
+    return 0;
+}
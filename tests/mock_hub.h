@@ -2,6 +2,7 @@
 
 #include "../components/avionmesh/avionmesh_hub.h"
 
+#include <cstring>
 #include <map>
 #include <string>
 #include <tuple>
@@ -15,24 +16,124 @@ public:
     std::vector<std::tuple<std::string, std::string, bool>> mqtt_publishes;
     std::map<std::string, std::function<void(const std::string &, const std::string &)>> mqtt_subs;
     std::vector<std::pair<std::string, std::string>> sse_events;
+    // Clear to make do_mqtt_publish refuse messages, as a full client outbox does
+    bool mqtt_accepting = true;
+    // The hub holds its TX queues while no bridge is Ready. Most tests run
+    // without a link and read mesh_sends directly; clear this to get the
+    // real hold.
+    bool send_without_link = true;
 
     // Call after populating db_ and setting mqtt_exposed flags.
     // Wires discovery_ publish function and subscribes all MQTT command topics.
     void test_setup() {
         discovery_.set_node_name("test");
         discovery_.set_topic_prefix("avionmesh");
-        discovery_.set_publish_fn([this](const std::string &t, const std::string &p, bool r) {
-            do_mqtt_publish(t, p, r);
+        discovery_.set_publish_fn([this](const char *t, const char *p, bool r) {
+            return do_mqtt_publish(t, p, r);
         });
         subscribe_all_commands();
         clear_captures();
     }
 
+    // Common fixture: clock at 1000 ms, one MQTT-exposed light, command
+    // topics subscribed and, unless link is false, bridge 0 up.
+    void setup_light(uint16_t id, uint8_t product = 93, const std::string &name = "Light",
+                     bool link = true) {
+        esphome::set_test_millis(1000);
+        db_.add_device(id, product, name);
+        db_.find_device(id)->mqtt_exposed = true;
+        test_setup();
+        if (link)
+            bring_up_bridge(0, 1);
+    }
+
+    // Bring bridge slot straight to Ready, as if scan, open and service
+    // discovery had completed. The fake address is 02:00:00:00:00:<slot>.
+    BridgeConnection &bring_up_bridge(uint8_t slot, uint16_t conn_id,
+                                      uint16_t low = 0x0013, uint16_t high = 0x0014) {
+        auto &br = bridges_[slot];
+        uint8_t bda[6] = {0x02, 0x00, 0x00, 0x00, 0x00, slot};
+        br.begin_connect(bda, -60, esphome::millis());
+        br.on_open(0, conn_id);
+        br.set_handles(low, high);
+        on_bridge_ready(br);
+        return br;
+    }
+
+    // Bridge link events as delivered by esp32_ble
+    void disconnect(uint16_t conn_id) {
+        esp_ble_gattc_cb_param_t p{};
+        p.disconnect.conn_id = conn_id;
+        gattc_event_handler(ESP_GATTC_DISCONNECT_EVT, 0, &p);
+    }
+
+    // Controller reports for bridge slot's link
+    void conn_params_updated(uint8_t slot, uint16_t conn_int) {
+        esp_ble_gap_cb_param_t p{};
+        p.update_conn_params.status = ESP_BT_STATUS_SUCCESS;
+        p.update_conn_params.conn_int = conn_int;
+        std::memcpy(p.update_conn_params.bda, bridges_[slot].bda(), sizeof(p.update_conn_params.bda));
+        gap_event_handler(ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT, &p);
+    }
+
+    void rssi_report(uint8_t slot, int8_t rssi) {
+        esp_ble_gap_cb_param_t p{};
+        p.read_rssi_cmpl.status = ESP_BT_STATUS_SUCCESS;
+        p.read_rssi_cmpl.rssi = rssi;
+        std::memcpy(p.read_rssi_cmpl.remote_addr, bridges_[slot].bda(), 6);
+        gap_event_handler(ESP_GAP_BLE_READ_RSSI_COMPLETE_EVT, &p);
+    }
+
+    void register_gattc() {
+        esp_ble_gattc_cb_param_t reg{};
+        reg.reg.status = ESP_GATT_OK;
+        gattc_event_handler(ESP_GATTC_REG_EVT, 4, &reg);
+    }
+
+    // One scan window: bridge i advertises the CSRMesh service from
+    // address ..:A<i> at rssis[i].
+    void scan(const std::vector<int> &rssis) {
+        for (size_t i = 0; i < rssis.size(); i++) {
+            esphome::esp32_ble::BLEScanResult res;
+            res.search_evt = ESP_GAP_SEARCH_INQ_RES_EVT;
+            res.bda[5] = static_cast<uint8_t>(0xA0 + i);
+            res.rssi = rssis[i];
+            const uint8_t adv[] = {0x03, 0x03, 0xF1, 0xFE};
+            std::memcpy(res.ble_adv, adv, sizeof(adv));
+            res.adv_data_len = sizeof(adv);
+            gap_scan_event_handler(res);
+        }
+        esphome::esp32_ble::BLEScanResult done;
+        done.search_evt = ESP_GAP_SEARCH_INQ_CMPL_EVT;
+        gap_scan_event_handler(done);
+    }
+
+    // Complete the pending gattc_open and service discovery as conn_id.
+    void open_last(uint16_t conn_id) {
+        esp_ble_gattc_cb_param_t open{};
+        open.open.status = ESP_GATT_OK;
+        open.open.conn_id = conn_id;
+        std::memcpy(open.open.remote_bda, test_gattc_opens().back().bda, 6);
+        gattc_event_handler(ESP_GATTC_OPEN_EVT, 4, &open);
+
+        esp_ble_gattc_cb_param_t search{};
+        search.search_cmpl.conn_id = conn_id;
+        gattc_event_handler(ESP_GATTC_SEARCH_CMPL_EVT, 4, &search);
+    }
+
+    void fail_last_open() {
+        esp_ble_gattc_cb_param_t open{};
+        open.open.status = 133;
+        std::memcpy(open.open.remote_bda, test_gattc_opens().back().bda, 6);
+        gattc_event_handler(ESP_GATTC_OPEN_EVT, 4, &open);
+    }
+
     // Simulate a brightness status arriving over BLE.
     // Verb=Write(0), Noun=Dimming(0x0A), value_bytes[1]=brightness
     void inject_brightness(uint16_t device_id, uint8_t brightness) {
         uint8_t payload[] = {0x00, 0x0A, 0x00, 0x00, 0x00, brightness, 0x00, 0x00, 0x00, 0x00};
         on_mesh_rx(device_id, device_id, 0x73, payload, sizeof(payload));
+        flush_dirty_states();
     }
 
     // Simulate a color-temp status arriving over BLE.
@@ -45,15 +146,70 @@ public:
             0x00, 0x00, 0x00,
         };
         on_mesh_rx(device_id, device_id, 0x73, payload, sizeof(payload));
+        flush_dirty_states();
     }
 
-    // Deliver an MQTT message to the matching subscribed callback.
+    // State publishes go out once per loop() tick; the inject helpers below
+    // end with a flush, as the next tick would.
+    void flush() { flush_dirty_states(); }
+
+    // MQTT topic filter match, with + and # wildcards
+    static bool topic_matches(const std::string &filter, const std::string &topic) {
+        size_t f = 0, t = 0;
+        while (f < filter.size()) {
+            if (filter[f] == '#')
+                return true;
+            if (filter[f] == '+') {
+                while (t < topic.size() && topic[t] != '/')
+                    t++;
+                f++;
+                continue;
+            }
+            if (t >= topic.size() || filter[f] != topic[t])
+                return false;
+            f++;
+            t++;
+        }
+        return t == topic.size();
+    }
+
+    // Deliver an MQTT message to every subscribed callback whose filter matches.
     void inject_mqtt(const std::string &topic, const std::string &payload) {
-        auto it = mqtt_subs.find(topic);
-        if (it != mqtt_subs.end())
-            it->second(topic, payload);
+        for (auto &[filter, cb] : mqtt_subs)
+            if (topic_matches(filter, topic))
+                cb(topic, payload);
+        flush_dirty_states();
+    }
+
+    // Management command as received on the MQTT command topic
+    void command(const std::string &json) { on_mqtt_command(json); }
+
+    // Status report from a mesh device, as relayed by the bridge link
+    // (rx) or by a given bridge slot (bridge_rx, which runs RX dedupe).
+    // Neither flushes: the publish happens on the next tick.
+    void rx(uint16_t id, const uint8_t *payload, size_t len) { on_mesh_rx(id, id, 0x73, payload, len); }
+    void bridge_rx(uint8_t bridge, uint16_t id, const uint8_t *payload, size_t len) {
+        on_bridge_rx(bridge, id, id, 0x73, payload, len);
     }
 
+    // Queue a command through the TX scheduler
+    void queue(const Command &cmd, TxClass cls) { mesh_send(cmd, cls); }
+
+    // MQTT client (re)connected / HA birth message, flushed as by the next tick
+    void mqtt_connected() {
+        on_mqtt_connected();
+        flush_dirty_states();
+    }
+    void republish_states() {
+        republish_all_states();
+        flush_dirty_states();
+    }
+
+    // HA discovery: queue every config, then pump the paced publisher
+    void announce(bool force = false) { publish_all_discovery(force); }
+    void pump(uint32_t now) { pump_discovery(now); }
+    bool discovery_pending() const { return !discovery_queue_.empty(); }
+
     // Push a deferred action and drain it immediately (simulating loop()).
     void push_action(DeferredAction act) {
         {
@@ -61,10 +217,25 @@ public:
             pending_actions_.push_back(std::move(act));
         }
         process_deferred_actions();
+        flush_dirty_states();
     }
 
+    BridgeConnection &bridge(uint8_t slot) { return bridges_[slot]; }
+    BleState ble_state() const { return ble_state_; }
+    std::string stats() { return stats_json(); }
     DeviceDB &db() { return db_; }
     std::map<uint16_t, DeviceState> &states() { return device_states_; }
+    MqttDiscovery &discovery() { return discovery_; }
+    AckTracker &acks() { return acks_; }
+    RateLimiter &limiter() { return limiter_; }
+    bool dimming(uint16_t id) const { return brightness_windows_.count(id) > 0; }
+    StateRefresher &refresh() { return refresh_; }
+    AirtimeMeter &airtime() { return airtime_; }
+    size_t dirty() const { return dirty_states_.size(); }
+
+    using AvionMeshHub::DISCOVERY_BACKOFF_MS;
+    using AvionMeshHub::DISCOVERY_PER_TICK;
+    using AvionMeshHub::STATE_FLUSH_MAX;
 
     void clear_captures() {
         mesh_sends.clear();
@@ -77,8 +248,17 @@ protected:
         mesh_sends.push_back(cmd);
     }
 
-    void do_mqtt_publish(const std::string &topic, const std::string &payload, bool retain) override {
+    bool do_mesh_accepting() const override {
+        if (send_without_link && ready_bridges() == 0)
+            return true;
+        return AvionMeshHub::do_mesh_accepting();
+    }
+
+    bool do_mqtt_publish(const char *topic, const char *payload, bool retain) override {
+        if (!mqtt_accepting)
+            return false;
         mqtt_publishes.emplace_back(topic, payload, retain);
+        return true;
     }
 
     void do_mqtt_subscribe(const std::string &topic,
@@ -1,5 +1,8 @@
 #pragma once
 #include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
 
 // ---- Minimal ESP-IDF BLE type stubs ----
 
@@ -9,6 +12,8 @@ typedef uint8_t esp_gatt_if_t;
 enum esp_gap_ble_cb_event_t {
     ESP_GAP_BLE_SCAN_PARAM_SET_COMPLETE_EVT = 0,
     ESP_GAP_BLE_SCAN_RESULT_EVT,
+    ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT,
+    ESP_GAP_BLE_READ_RSSI_COMPLETE_EVT,
 };
 
 enum esp_gattc_cb_event_t {
@@ -18,9 +23,13 @@ enum esp_gattc_cb_event_t {
     ESP_GATTC_REG_FOR_NOTIFY_EVT,
     ESP_GATTC_NOTIFY_EVT,
     ESP_GATTC_DISCONNECT_EVT,
+    ESP_GATTC_CONNECT_EVT,
+    ESP_GATTC_WRITE_CHAR_EVT,
+    ESP_GATTC_CONGEST_EVT,
+    ESP_GATTC_WRITE_DESCR_EVT,
 };
 
-enum esp_gatt_status_t { ESP_GATT_OK = 0 };
+enum esp_gatt_status_t { ESP_GATT_OK = 0, ESP_GATT_INVALID_HANDLE = 0x01 };
 enum esp_bt_status_t   { ESP_BT_STATUS_SUCCESS = 0 };
 enum esp_gatt_write_type_t { ESP_GATT_WRITE_TYPE_RSP = 0, ESP_GATT_WRITE_TYPE_NO_RSP };
 enum esp_gatt_auth_req_t   { ESP_GATT_AUTH_REQ_NONE = 0 };
@@ -40,6 +49,11 @@ union esp_ble_gap_cb_param_t {
     struct { int status; } scan_param_cmpl;
     struct { int status; uint16_t conn_id; } open;
     struct { int reason; } disconnect;
+    struct {
+        esp_bt_status_t status; esp_bd_addr_t bda; uint16_t min_int; uint16_t max_int;
+        uint16_t latency; uint16_t conn_int; uint16_t timeout;
+    } update_conn_params;
+    struct { esp_bt_status_t status; int8_t rssi; esp_bd_addr_t remote_addr; } read_rssi_cmpl;
 };
 
 union esp_bt_uuid_t_u { uint16_t uuid16; uint8_t uuid128[16]; };
@@ -49,10 +63,17 @@ struct esp_gattc_descr_elem_t { uint16_t handle; };
 
 union esp_ble_gattc_cb_param_t {
     struct { int status; int app_id; }    reg;
-    struct { int status; uint16_t conn_id; } open;
+    struct { int status; uint16_t conn_id; esp_bd_addr_t remote_bda; } open;
+    struct { int status; uint16_t conn_id; } search_cmpl;
     struct { uint16_t handle; int status; } reg_for_notify;
-    struct { uint16_t handle; uint16_t value_len; uint8_t *value; } notify;
-    struct { int reason; } disconnect;
+    struct { uint16_t conn_id; uint16_t handle; uint16_t value_len; uint8_t *value; } notify;
+    struct { uint16_t conn_id; int reason; } disconnect;
+    struct {
+        uint16_t conn_id; esp_bd_addr_t remote_bda;
+        struct { uint16_t interval; uint16_t latency; uint16_t timeout; } conn_params;
+    } connect;
+    struct { esp_gatt_status_t status; uint16_t conn_id; uint16_t handle; uint16_t offset; } write;
+    struct { uint16_t conn_id; bool congested; } congest;
 };
 
 struct esp_ble_scan_params_t {
@@ -65,23 +86,110 @@ struct esp_ble_scan_params_t {
 };
 
 inline int esp_ble_gap_set_scan_params(esp_ble_scan_params_t *) { return 0; }
-inline int esp_ble_gap_start_scanning(uint32_t) { return 0; }
+
+struct esp_ble_conn_update_params_t {
+    esp_bd_addr_t bda;
+    uint16_t min_int;
+    uint16_t max_int;
+    uint16_t latency;
+    uint16_t timeout;
+};
+// Connection parameter update requests, recorded for tests.
+inline std::vector<esp_ble_conn_update_params_t> &test_conn_updates() {
+    static std::vector<esp_ble_conn_update_params_t> updates;
+    return updates;
+}
+inline int esp_ble_gap_update_conn_params(esp_ble_conn_update_params_t *params) {
+    test_conn_updates().push_back(*params);
+    return 0;
+}
+// RSSI reads (last address byte), recorded for tests.
+inline std::vector<uint8_t> &test_rssi_reads() {
+    static std::vector<uint8_t> reads;
+    return reads;
+}
+inline int esp_ble_gap_read_rssi(esp_bd_addr_t bda) {
+    test_rssi_reads().push_back(bda[5]);
+    return 0;
+}
+// Scan durations (seconds), recorded for tests.
+inline std::vector<uint32_t> &test_scan_starts() {
+    static std::vector<uint32_t> starts;
+    return starts;
+}
+inline int esp_ble_gap_start_scanning(uint32_t duration) {
+    test_scan_starts().push_back(duration);
+    return 0;
+}
 inline int esp_ble_gattc_app_register(uint16_t) { return 0; }
-inline int esp_ble_gattc_open(esp_gatt_if_t, esp_bd_addr_t, ble_addr_type_t, bool) { return 0; }
-inline int esp_ble_gattc_search_service(esp_gatt_if_t, uint16_t, void *) { return 0; }
+// Connection attempts, recorded for tests.
+struct TestGattcOpen {
+    uint8_t bda[6];
+};
+inline std::vector<TestGattcOpen> &test_gattc_opens() {
+    static std::vector<TestGattcOpen> opens;
+    return opens;
+}
+inline int esp_ble_gattc_open(esp_gatt_if_t, esp_bd_addr_t bda, ble_addr_type_t, bool) {
+    TestGattcOpen o;
+    std::memcpy(o.bda, bda, sizeof(o.bda));
+    test_gattc_opens().push_back(o);
+    return 0;
+}
+// Service discovery requests (by conn_id), recorded for tests.
+inline std::vector<uint16_t> &test_gattc_searches() {
+    static std::vector<uint16_t> searches;
+    return searches;
+}
+inline int esp_ble_gattc_search_service(esp_gatt_if_t, uint16_t conn_id, void *) {
+    test_gattc_searches().push_back(conn_id);
+    return 0;
+}
+// Every bridge exposes the CSRMesh characteristics at 0x0013 (low) / 0x0014 (high)
 inline int esp_ble_gattc_get_char_by_uuid(esp_gatt_if_t, uint16_t, uint16_t, uint16_t,
-                                           esp_bt_uuid_t, esp_gattc_char_elem_t *, uint16_t *) { return 1; }
+                                           esp_bt_uuid_t uuid, esp_gattc_char_elem_t *result,
+                                           uint16_t *count) {
+    result->char_handle = 0x10 + uuid.uuid.uuid128[6];
+    *count = 1;
+    return ESP_OK;
+}
 inline int esp_ble_gattc_register_for_notify(esp_gatt_if_t, esp_bd_addr_t, uint16_t) { return 0; }
-inline int esp_ble_gattc_get_descr_by_char_handle(esp_gatt_if_t, uint16_t, uint16_t,
-                                                    esp_bt_uuid_t, esp_gattc_descr_elem_t *,
-                                                    uint16_t *) { return 1; }
-inline int esp_ble_gattc_write_char_descr(esp_gatt_if_t, uint16_t, uint16_t, uint16_t,
+// The CCCD sits right after its characteristic value
+inline int esp_ble_gattc_get_descr_by_char_handle(esp_gatt_if_t, uint16_t, uint16_t char_handle,
+                                                    esp_bt_uuid_t, esp_gattc_descr_elem_t *result,
+                                                    uint16_t *count) {
+    result->handle = char_handle + 1;
+    *count = 1;
+    return ESP_OK;
+}
+// Descriptor writes (conn_id, handle), recorded for tests.
+inline std::vector<std::pair<uint16_t, uint16_t>> &test_gattc_descr_writes() {
+    static std::vector<std::pair<uint16_t, uint16_t>> writes;
+    return writes;
+}
+inline int esp_ble_gattc_write_char_descr(esp_gatt_if_t, uint16_t conn_id, uint16_t handle, uint16_t,
                                            uint8_t *, esp_gatt_write_type_t,
-                                           esp_gatt_auth_req_t) { return 0; }
+                                           esp_gatt_auth_req_t) {
+    test_gattc_descr_writes().emplace_back(conn_id, handle);
+    return 0;
+}
 inline int esp_ble_gattc_close(esp_gatt_if_t, uint16_t) { return 0; }
-inline int esp_ble_gattc_write_char(esp_gatt_if_t, uint16_t, uint16_t, uint16_t,
-                                     uint8_t *, esp_gatt_write_type_t,
-                                     esp_gatt_auth_req_t) { return 0; }
+
+// Every characteristic write is recorded so tests can inspect what went on air.
+struct TestGattcWrite {
+    uint16_t handle;
+    std::vector<uint8_t> data;
+};
+inline std::vector<TestGattcWrite> &test_gattc_writes() {
+    static std::vector<TestGattcWrite> writes;
+    return writes;
+}
+inline int esp_ble_gattc_write_char(esp_gatt_if_t, uint16_t, uint16_t handle, uint16_t len,
+                                     uint8_t *value, esp_gatt_write_type_t,
+                                     esp_gatt_auth_req_t) {
+    test_gattc_writes().push_back({handle, std::vector<uint8_t>(value, value + len)});
+    return 0;
+}
 
 namespace esphome {
 namespace esp32_ble {
@@ -11,6 +11,7 @@ public:
     std::string get_topic_prefix() { return "avionmesh"; }
     void subscribe(const std::string &, std::function<void(const std::string &, const std::string &)>, int) {}
     void publish(const std::string &, const std::string &, int, bool) {}
+    bool publish(const char *, const char *, size_t, int, bool) { return false; }
 };
 
 extern MQTTClientComponent *global_mqtt_client;
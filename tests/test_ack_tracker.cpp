@@ -0,0 +1,224 @@
+// Tests: AckTracker confirmation matching, retry backoff, and group acks
+// wired through the hub's MQTT command and status paths, and dropped on unclaim.
+
+#include "mock_hub.h"
+#include "ack_tracker.h"
+#include "esphome/core/component.h"
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+using namespace avionmesh;
+
+static constexpr uint16_t DEV = 32900;
+static constexpr uint16_t DEV2 = 32901;
+static constexpr uint16_t GRP = 1024;
+static const std::string PREFIX = "avionmesh";
+
+class AckTrackerTest : public ::testing::Test {
+protected:
+    AckTracker acks;
+    std::vector<Command> resent;
+
+    void SetUp() override {
+        acks.set_send_fn([this](const Command &cmd) { resent.push_back(cmd); });
+    }
+
+    Command brightness(uint16_t dest, uint8_t value) {
+        Command cmd;
+        cmd_brightness(dest, value, cmd);
+        return cmd;
+    }
+};
+
+TEST_F(AckTrackerTest, MatchingReportConfirms) {
+    acks.track(DEV, AckAttr::Brightness, 100, brightness(DEV, 100), {}, 1000);
+    acks.on_report(DEV, AckAttr::Brightness, 100, 1150);
+
+    EXPECT_EQ(acks.pending(), 0u);
+    EXPECT_EQ(acks.stats().acked, 1u);
+    EXPECT_EQ(acks.stats().max_latency_ms, 150u);
+}
+
+TEST_F(AckTrackerTest, MismatchedValueOrAttributeDoesNotConfirm) {
+    acks.track(DEV, AckAttr::Brightness, 100, brightness(DEV, 100), {}, 1000);
+    acks.on_report(DEV, AckAttr::Brightness, 80, 1100);
+    acks.on_report(DEV, AckAttr::ColorTemp, 100, 1100);
+    acks.on_report(DEV2, AckAttr::Brightness, 100, 1100);
+
+    EXPECT_TRUE(acks.is_pending(DEV, AckAttr::Brightness));
+}
+
+TEST_F(AckTrackerTest, RetriesWithBackoffThenGivesUp) {
+    acks.set_max_retries(2);
+    acks.track(DEV, AckAttr::Brightness, 100, brightness(DEV, 100), {}, 1000);
+
+    acks.poll(1000 + AckTracker::ACK_TIMEOUT_MS - 1);
+    EXPECT_TRUE(resent.empty());
+
+    acks.poll(1000 + AckTracker::ACK_TIMEOUT_MS);
+    ASSERT_EQ(resent.size(), 1u);
+    EXPECT_EQ(resent[0].dest_id, DEV);
+
+    // Second retry waits twice as long
+    uint32_t t = 1000 + AckTracker::ACK_TIMEOUT_MS;
+    acks.poll(t + 2 * AckTracker::ACK_TIMEOUT_MS - 1);
+    EXPECT_EQ(resent.size(), 1u);
+    t += 2 * AckTracker::ACK_TIMEOUT_MS;
+    acks.poll(t);
+    EXPECT_EQ(resent.size(), 2u);
+
+    acks.poll(t + 4 * AckTracker::ACK_TIMEOUT_MS);
+    EXPECT_EQ(resent.size(), 2u);
+    EXPECT_EQ(acks.pending(), 0u);
+    EXPECT_EQ(acks.stats().retries, 2u);
+    EXPECT_EQ(acks.stats().failed, 1u);
+}
+
+TEST_F(AckTrackerTest, JitterDelaysRetry) {
+    acks.set_random_fn([]() { return 100u; });
+    acks.track(DEV, AckAttr::Brightness, 100, brightness(DEV, 100), {}, 1000);
+
+    acks.poll(1000 + AckTracker::ACK_TIMEOUT_MS);
+    EXPECT_TRUE(resent.empty());
+    acks.poll(1000 + AckTracker::ACK_TIMEOUT_MS + 100);
+    EXPECT_EQ(resent.size(), 1u);
+}
+
+TEST_F(AckTrackerTest, NewerCommandSupersedes) {
+    acks.track(DEV, AckAttr::Brightness, 100, brightness(DEV, 100), {}, 1000);
+    acks.track(DEV, AckAttr::Brightness, 50, brightness(DEV, 50), {}, 1100);
+    acks.on_report(DEV, AckAttr::Brightness, 100, 1200);
+
+    EXPECT_TRUE(acks.is_pending(DEV, AckAttr::Brightness));
+    EXPECT_EQ(acks.stats().superseded, 1u);
+    acks.on_report(DEV, AckAttr::Brightness, 50, 1200);
+    EXPECT_EQ(acks.pending(), 0u);
+}
+
+TEST_F(AckTrackerTest, GroupNeedsEveryMember) {
+    acks.track(GRP, AckAttr::Brightness, 100, brightness(GRP, 100), {DEV, DEV2}, 1000);
+    acks.on_report(DEV, AckAttr::Brightness, 100, 1100);
+    EXPECT_TRUE(acks.is_pending(GRP, AckAttr::Brightness));
+
+    acks.on_report(DEV2, AckAttr::Brightness, 100, 1300);
+    EXPECT_EQ(acks.pending(), 0u);
+    EXPECT_EQ(acks.stats().max_latency_ms, 300u);
+}
+
+TEST_F(AckTrackerTest, ForgetDropsDeviceAndItsGroupWaits) {
+    acks.track(DEV, AckAttr::Brightness, 100, brightness(DEV, 100), {}, 1000);
+    acks.track(DEV2, AckAttr::Brightness, 50, brightness(DEV2, 50), {}, 1000);
+    acks.track(GRP, AckAttr::ColorTemp, 3000, brightness(GRP, 0), {DEV, DEV2}, 1000);
+    acks.on_report(DEV2, AckAttr::ColorTemp, 3000, 1100);
+
+    acks.forget(DEV);
+    EXPECT_FALSE(acks.is_pending(DEV, AckAttr::Brightness));
+    EXPECT_TRUE(acks.is_pending(DEV2, AckAttr::Brightness));
+    EXPECT_FALSE(acks.is_pending(GRP, AckAttr::ColorTemp)) << "only the removed member was left";
+
+    acks.poll(10000);
+    EXPECT_EQ(resent.size(), 1u);
+    EXPECT_EQ(resent[0].dest_id, DEV2);
+}
+
+// --- Hub wiring ---
+
+class AckHubTest : public ::testing::Test {
+protected:
+    TestHub hub;
+
+    void SetUp() override {
+        hub.setup_light(DEV, 93, "Light 1");
+        hub.db().add_device(DEV2, 93, "Light 2");
+        hub.db().add_group(GRP, "Room");
+        hub.db().add_device_to_group(DEV, GRP);
+        hub.db().add_device_to_group(DEV2, GRP);
+        hub.db().find_group(GRP)->mqtt_exposed = true;
+        hub.test_setup();  // subscribe the group's command topics too
+    }
+
+    void tick_until(uint32_t end) {
+        for (uint32_t t = esphome::millis(); t <= end; t += 10) {
+            esphome::set_test_millis(t);
+            hub.loop();
+        }
+    }
+};
+
+TEST_F(AckHubTest, LostCommandIsRetried) {
+    hub.inject_mqtt(PREFIX + "/light/" + std::to_string(DEV) + "/set", "OFF");
+    ASSERT_EQ(hub.mesh_sends.size(), 1u);
+
+    tick_until(1000 + 3 * AckTracker::ACK_TIMEOUT_MS);
+    ASSERT_GE(hub.mesh_sends.size(), 2u);
+    EXPECT_EQ(hub.mesh_sends[1].dest_id, DEV);
+    EXPECT_EQ(hub.mesh_sends[1].payload[5], 0);
+}
+
+TEST_F(AckHubTest, StatusReportStopsRetries) {
+    hub.inject_mqtt(PREFIX + "/light/" + std::to_string(DEV) + "/set", "OFF");
+    esphome::set_test_millis(1200);
+    hub.inject_brightness(DEV, 0);
+
+    tick_until(10000);
+    EXPECT_EQ(hub.mesh_sends.size(), 1u);
+    EXPECT_EQ(hub.acks().stats().acked, 1u);
+    EXPECT_EQ(hub.acks().stats().max_latency_ms, 200u);
+}
+
+TEST_F(AckHubTest, GroupRetriedUntilAllMembersConfirm) {
+    hub.inject_mqtt(PREFIX + "/light/" + std::to_string(GRP) + "/color_temp/set", "250");
+    ASSERT_EQ(hub.mesh_sends.size(), 1u);
+    hub.inject_color_temp(DEV, 4000);
+
+    tick_until(1000 + AckTracker::ACK_TIMEOUT_MS * 3 / 2 + 10);
+    ASSERT_EQ(hub.mesh_sends.size(), 2u) << "one member silent — group write re-sent";
+    EXPECT_EQ(hub.mesh_sends[1].dest_id, GRP);
+
+    hub.inject_color_temp(DEV2, 4000);
+    tick_until(20000);
+    EXPECT_EQ(hub.mesh_sends.size(), 2u);
+    EXPECT_EQ(hub.acks().pending(), 0u);
+}
+
+TEST_F(AckHubTest, UnclaimClearsDeviceState) {
+    const std::string topic = PREFIX + "/light/" + std::to_string(DEV);
+    hub.inject_mqtt(topic + "/brightness/set", "40");
+    for (int k = 2700; k < 2700 + 12 * 10; k += 10)
+        hub.inject_mqtt(topic + "/color_temp/set", std::to_string(1000000 / k));
+    hub.inject_mqtt(PREFIX + "/light/" + std::to_string(GRP) + "/set", "OFF");
+    uint8_t dim[] = {0x00, 0x0A, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x00};
+    hub.rx(DEV, dim, sizeof(dim));
+    ASSERT_TRUE(hub.acks().is_pending(DEV, AckAttr::Brightness));
+    ASSERT_TRUE(hub.acks().is_pending(GRP, AckAttr::Brightness));
+    ASSERT_TRUE(hub.limiter().is_pending(DEV, AckAttr::ColorTemp));
+    ASSERT_TRUE(hub.dimming(DEV));
+    ASSERT_TRUE(hub.refresh().tracks(DEV));
+    ASSERT_TRUE(hub.states()[DEV].dirty);
+    size_t dirty = hub.dirty();
+    hub.clear_captures();
+
+    hub.command("{\"action\":\"unclaim_device\",\"avion_id\":" + std::to_string(DEV) + "}");
+    EXPECT_FALSE(hub.acks().is_pending(DEV, AckAttr::Brightness));
+    EXPECT_TRUE(hub.acks().is_pending(GRP, AckAttr::Brightness)) << "DEV2 has not confirmed";
+    EXPECT_FALSE(hub.limiter().is_pending(DEV, AckAttr::ColorTemp));
+    EXPECT_FALSE(hub.dimming(DEV));
+    EXPECT_FALSE(hub.refresh().tracks(DEV));
+    EXPECT_EQ(hub.states().count(DEV), 0u);
+    EXPECT_EQ(hub.dirty(), dirty - 1);
+
+    // The disassociate waits in the provisioning queue like any group edit
+    EXPECT_TRUE(hub.mesh_sends.empty());
+    tick_until(1300);
+    auto disassoc = std::find_if(hub.mesh_sends.begin(), hub.mesh_sends.end(),
+                                 [](const Command &c) { return c.dest_id == DEV && c.payload_len == 0; });
+    EXPECT_NE(disassoc, hub.mesh_sends.end());
+}
+
+TEST_F(AckHubTest, NotTrackedWithoutLink) {
+    TestHub offline;
+    offline.setup_light(DEV, 93, "Light 1", false);
+    offline.inject_mqtt(PREFIX + "/light/" + std::to_string(DEV) + "/set", "OFF");
+    EXPECT_EQ(offline.acks().pending(), 0u);
+}
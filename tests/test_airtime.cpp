@@ -0,0 +1,131 @@
+// Tests: mesh airtime accounting — packet classes, the rolling window, the
+// background budget in the scheduler, and per-source attribution and raw RX
+// counting in the hub.
+
+#include "mock_hub.h"
+#include "airtime.h"
+#include "esphome/core/component.h"
+#include <gtest/gtest.h>
+
+using namespace avionmesh;
+
+static constexpr uint16_t DEV = 32900;
+
+static AirClass class_of(const Command &cmd) {
+    return AirtimeMeter::classify(cmd.payload, cmd.payload_len);
+}
+
+TEST(AirtimeClassifyTest, VerbAndNounClasses) {
+    Command cmd;
+    cmd_brightness(DEV, 10, cmd);
+    EXPECT_EQ(class_of(cmd), AirClass::Control);
+    cmd_color_temp(DEV, 3000, cmd);
+    EXPECT_EQ(class_of(cmd), AirClass::Control);
+    cmd_read_dimming(DEV, cmd);
+    EXPECT_EQ(class_of(cmd), AirClass::Read);
+    cmd_ping(DEV, cmd);
+    EXPECT_EQ(class_of(cmd), AirClass::Ping);
+    cmd_insert_group(DEV, 256, cmd);
+    EXPECT_EQ(class_of(cmd), AirClass::GroupEdit);
+    cmd_delete_group(DEV, 256, cmd);
+    EXPECT_EQ(class_of(cmd), AirClass::GroupEdit);
+    cmd_set_date(2026, 10, 16, cmd);
+    EXPECT_EQ(class_of(cmd), AirClass::Time);
+    cmd_set_time(12, 0, 0, cmd);
+    EXPECT_EQ(class_of(cmd), AirClass::Time);
+    EXPECT_EQ(AirtimeMeter::classify(cmd.payload, 1), AirClass::Other);
+}
+
+TEST(AirtimeMeterTest, WindowRatesAndExpiry) {
+    AirtimeMeter meter;
+    Command cmd;
+    cmd_brightness(DEV, 10, cmd);
+    for (int i = 0; i < 20; i++)
+        meter.on_tx(cmd, TxSource::Mqtt, 1000 + i * 100);
+    EXPECT_FLOAT_EQ(meter.packets_per_s(3000), 2.0f);
+
+    std::string stats = meter.stats_json(3000);
+    EXPECT_NE(stats.find("\"tx_total\":20"), std::string::npos) << stats;
+    EXPECT_NE(stats.find("\"control\":{\"tx_pps\":2.0"), std::string::npos) << stats;
+    EXPECT_NE(stats.find("\"mqtt\":{\"tx_pps\":2.0"), std::string::npos) << stats;
+
+    // Buckets for seconds 1 and 2 fall out of the window at 11 s and 12 s
+    EXPECT_FLOAT_EQ(meter.packets_per_s(11000), 1.0f);
+    EXPECT_FLOAT_EQ(meter.packets_per_s(12000), 0.0f);
+}
+
+TEST(AirtimeMeterTest, RxCountsTowardsBudget) {
+    AirtimeMeter meter;
+    meter.set_budget(1.0f);
+    uint8_t report[] = {0x00, 0x0A, 0x00, 0x00, 0x00, 50, 0x00, 0x00, 0x00, 0x00};
+    for (int i = 0; i < 9; i++)
+        meter.on_rx(report, sizeof(report), 1000);
+    EXPECT_TRUE(meter.background_allowed(1000));
+    meter.on_rx(report, sizeof(report), 1000);
+    EXPECT_FALSE(meter.background_allowed(1000));
+    EXPECT_FALSE(meter.background_allowed(1500));
+    EXPECT_TRUE(meter.background_allowed(11000));
+    EXPECT_NE(meter.stats_json(11000).find("\"throttled\":1"), std::string::npos);
+}
+
+TEST(AirtimeSchedulerTest, BudgetHoldsBackgroundOnly) {
+    MeshTxScheduler tx;
+    std::vector<Command> sent;
+    bool allowed = false;
+    tx.set_send_fn([&](const Command &cmd) { sent.push_back(cmd); });
+    tx.set_budget_fn([&]() { return allowed; });
+
+    Command read;
+    cmd_read_dimming(DEV, read);
+    tx.enqueue(read, TxClass::StateRead, 1000);
+    tx.poll(1000);
+    EXPECT_TRUE(sent.empty());
+
+    Command on;
+    cmd_brightness(DEV, 255, on);
+    tx.enqueue(on, TxClass::Interactive, 1000, TxSource::Mqtt);
+    ASSERT_EQ(sent.size(), 1u);
+
+    allowed = true;
+    tx.poll(2000);
+    ASSERT_EQ(sent.size(), 2u);
+    EXPECT_EQ(sent[1].payload[0], static_cast<uint8_t>(Verb::Read));
+}
+
+// --- Hub wiring ---
+
+TEST(AirtimeHubTest, SourcesAttributedPerIngress) {
+    TestHub hub;
+    hub.setup_light(DEV, 1, "A");
+
+    hub.inject_mqtt("avionmesh/light/" + std::to_string(DEV) + "/set", "OFF");
+    const uint8_t off[] = {0x00, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    hub.bridge_rx(0, DEV, off, sizeof(off));  // confirms the write, so no retry
+    hub.command("{\"action\":\"read_all\"}");
+    esphome::set_test_millis(2000);
+    hub.loop();
+    ASSERT_EQ(hub.mesh_sends.size(), 2u);
+
+    std::string stats = hub.airtime().stats_json(2000);
+    EXPECT_NE(stats.find("\"mqtt\":{\"tx_pps\":0.1"), std::string::npos) << stats;
+    EXPECT_NE(stats.find("\"management\":{\"tx_pps\":0.1"), std::string::npos) << stats;
+    EXPECT_NE(stats.find("\"internal\":{\"tx_pps\":0.0"), std::string::npos) << stats;
+    EXPECT_NE(stats.find("\"rx_total\":1"), std::string::npos) << stats;
+    EXPECT_NE(hub.stats().find("\"airtime\":{"), std::string::npos);
+}
+
+TEST(AirtimeHubTest, EveryBridgeCopyCounts) {
+    TestHub hub;
+    hub.setup_light(DEV, 1, "A");
+    hub.bring_up_bridge(1, 2);
+
+    // Both bridges relay the same report; dedupe keeps one, the air carried two
+    const uint8_t report[] = {0x00, 0x0A, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x00};
+    hub.bridge_rx(0, DEV, report, sizeof(report));
+    hub.bridge_rx(1, DEV, report, sizeof(report));
+
+    std::string stats = hub.airtime().stats_json(1000);
+    EXPECT_NE(stats.find("\"rx_total\":2"), std::string::npos) << stats;
+    EXPECT_NE(stats.find("\"rx_pps\":0.2"), std::string::npos) << stats;
+    EXPECT_NE(hub.stats().find("\"rx_dedupe\":{\"received\":2,\"duplicates\":1"), std::string::npos);
+}
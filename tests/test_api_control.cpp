@@ -2,6 +2,7 @@
 // Exercises the path that the web handler pushes into pending_actions_.
 
 #include "mock_hub.h"
+#include "esphome/core/component.h"
 #include <gtest/gtest.h>
 
 using namespace avionmesh;
@@ -50,6 +51,26 @@ TEST_F(ApiControlTest, ControlBrightness_EchoesStateToMqtt) {
     EXPECT_TRUE(found);
 }
 
+// Control: rapid brightness changes share the MQTT coalescing window
+TEST_F(ApiControlTest, ControlBrightness_RapidChangesCoalesced) {
+    esphome::set_test_millis(1000);
+    for (int b : {50, 90, 140}) {
+        DeferredAction act;
+        act.type       = DeferredAction::Control;
+        act.id1        = DEV;
+        act.brightness = b;
+        act.color_temp = -1;
+        hub.push_action(act);
+    }
+    ASSERT_EQ(hub.mesh_sends.size(), 1u);
+    EXPECT_EQ(hub.mesh_sends[0].payload[5], 50);
+
+    esphome::set_test_millis(2000);
+    hub.loop();
+    ASSERT_EQ(hub.mesh_sends.size(), 2u);
+    EXPECT_EQ(hub.mesh_sends[1].payload[5], 140);
+}
+
 // Control: color_temp only
 TEST_F(ApiControlTest, ControlColorTemp_SendsCorrectKelvin) {
     DeferredAction act;
@@ -78,7 +99,7 @@ TEST_F(ApiControlTest, ControlBrightnessAndColorTemp_TwoMeshSends) {
     EXPECT_EQ(hub.mesh_sends.size(), 2u);
 }
 
-// SetMqttExposed: device becomes exposed → MQTT discovery published + topics subscribed
+// SetMqttExposed: device becomes exposed → MQTT discovery published + commands handled
 TEST_F(ApiControlTest, SetMqttExposed_True_PublishesDiscoveryAndSubscribes) {
     // Add a second unexposed device
     static constexpr uint16_t DEV2 = 32901;
@@ -86,6 +107,10 @@ TEST_F(ApiControlTest, SetMqttExposed_True_PublishesDiscoveryAndSubscribes) {
     hub.test_setup();
     hub.clear_captures();
 
+    std::string cmd_topic = "avionmesh/light/" + std::to_string(DEV2) + "/brightness/set";
+    hub.inject_mqtt(cmd_topic, "128");
+    EXPECT_TRUE(hub.mesh_sends.empty()) << "commands for unexposed lights are ignored";
+
     DeferredAction act;
     act.type = DeferredAction::SetMqttExposed;
     act.id1  = DEV2;
@@ -99,10 +124,11 @@ TEST_F(ApiControlTest, SetMqttExposed_True_PublishesDiscoveryAndSubscribes) {
             discovery_pub = true;
     EXPECT_TRUE(discovery_pub) << "HA discovery must be published on expose";
 
-    // Command topics must now be subscribed
-    std::string cmd_topic = "avionmesh/light/" + std::to_string(DEV2) + "/set";
-    EXPECT_NE(hub.mqtt_subs.find(cmd_topic), hub.mqtt_subs.end())
-        << "command topic must be subscribed after SetMqttExposed";
+    // Commands must now reach the light through the wildcard subscription
+    hub.clear_captures();
+    hub.inject_mqtt(cmd_topic, "128");
+    EXPECT_EQ(hub.mesh_sends.size(), 1u)
+        << "command topic must be handled after SetMqttExposed";
 }
 
 // Multiple actions pushed separately are all processed
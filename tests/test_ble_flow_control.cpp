@@ -0,0 +1,207 @@
+// Tests: GATT write flow control — credit window, congestion back-pressure,
+// and a large provisioning burst delivered with zero drops.
+
+#include "mock_hub.h"
+#include "esphome/core/component.h"
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+using namespace avionmesh;
+
+static constexpr uint16_t CONN_ID = 3;
+static constexpr uint16_t HANDLE_LOW = 0x0012;
+static constexpr uint16_t HANDLE_HIGH = 0x0015;
+
+// Routes each mesh command through the bridge write pump as two MTL-sized fragments,
+// the way csrmesh::send() does for a full encrypted packet.
+class FlowHub : public TestHub {
+public:
+    void connect(uint16_t interval = 24) {
+        auto &br = bring_up_bridge(0, CONN_ID, HANDLE_LOW, HANDLE_HIGH);
+
+        esp_ble_gattc_cb_param_t p{};
+        p.connect.conn_id = CONN_ID;
+        std::memcpy(p.connect.remote_bda, br.bda(), sizeof(p.connect.remote_bda));
+        p.connect.conn_params.interval = interval;
+        gattc_event_handler(ESP_GATTC_CONNECT_EVT, 0, &p);
+    }
+
+    void complete_write(esp_gatt_status_t status = ESP_GATT_OK) {
+        esp_ble_gattc_cb_param_t p{};
+        p.write.conn_id = CONN_ID;
+        p.write.status = status;
+        gattc_event_handler(ESP_GATTC_WRITE_CHAR_EVT, 0, &p);
+    }
+
+    void congest(bool on) {
+        esp_ble_gattc_cb_param_t p{};
+        p.congest.conn_id = CONN_ID;
+        p.congest.congested = on;
+        gattc_event_handler(ESP_GATTC_CONGEST_EVT, 0, &p);
+    }
+
+    uint8_t in_flight() const { return bridges_[0].in_flight(); }
+    size_t queued() const { return bridges_[0].queued(); }
+    uint32_t ble_drops() const { return bridges_[0].drops(); }
+    const MeshTxScheduler &tx() const { return tx_; }
+
+protected:
+    void do_mesh_send(const Command &cmd) override {
+        TestHub::do_mesh_send(cmd);
+        uint8_t frag[csrmesh::MTL_FRAG_SIZE] = {};
+        frag[0] = static_cast<uint8_t>(cmd.dest_id >> 8);
+        frag[1] = static_cast<uint8_t>(cmd.dest_id & 0xFF);
+        frag[2] = cmd.payload[0];
+        auto *br = pick_bridge();
+        if (!br)
+            return;
+        br->write(csrmesh::Characteristic::Low, frag, sizeof(frag), false, esphome::millis());
+        frag[3] = 1;
+        br->write(csrmesh::Characteristic::High, frag, sizeof(frag), false, esphome::millis());
+    }
+};
+
+class BleFlowControlTest : public ::testing::Test {
+protected:
+    FlowHub hub;
+
+    void SetUp() override {
+        esphome::set_test_millis(1000);
+        test_gattc_writes().clear();
+        hub.connect();
+    }
+};
+
+TEST_F(BleFlowControlTest, CreditWindowLimitsInFlightWrites) {
+    Command cmd;
+    cmd_brightness(32900, 100, cmd);
+    hub.queue(cmd, TxClass::Interactive);
+    hub.queue(cmd, TxClass::Interactive);
+    hub.queue(cmd, TxClass::Interactive);
+
+    // Spacing and the credit window hold everything past the first write
+    EXPECT_EQ(test_gattc_writes().size(), 1u);
+    for (uint32_t t = 1001; t < 1100; t++) {
+        esphome::set_test_millis(t);
+        hub.loop();
+    }
+    EXPECT_EQ(hub.in_flight(), 4u);
+    EXPECT_EQ(test_gattc_writes().size(), 4u);
+
+    hub.complete_write();
+    hub.complete_write();
+    EXPECT_EQ(hub.in_flight(), 3u);  // one freed credit reused immediately
+    EXPECT_EQ(test_gattc_writes().size(), 5u);
+}
+
+TEST_F(BleFlowControlTest, CongestionPausesWrites) {
+    hub.congest(true);
+    Command cmd;
+    cmd_brightness(32900, 100, cmd);
+    hub.queue(cmd, TxClass::Interactive);
+    EXPECT_TRUE(test_gattc_writes().empty());
+    EXPECT_EQ(hub.queued(), 2u);
+
+    hub.congest(false);
+    EXPECT_EQ(test_gattc_writes().size(), 1u);
+}
+
+TEST_F(BleFlowControlTest, StalledCompletionsReclaimCredits) {
+    Command cmd;
+    cmd_brightness(32900, 100, cmd);
+    for (int i = 0; i < 3; i++)
+        hub.queue(cmd, TxClass::Interactive);
+    for (uint32_t t = 1001; t < 1100; t++) {
+        esphome::set_test_millis(t);
+        hub.loop();
+    }
+    ASSERT_EQ(hub.in_flight(), 4u);
+
+    esphome::set_test_millis(1100 + 1500);
+    hub.loop();
+    EXPECT_GT(test_gattc_writes().size(), 4u);
+}
+
+TEST_F(BleFlowControlTest, DisconnectCountsQueuedWritesAsDrops) {
+    hub.congest(true);
+    Command cmd;
+    cmd_brightness(32900, 100, cmd);
+    hub.queue(cmd, TxClass::Interactive);
+    ASSERT_EQ(hub.queued(), 2u);
+
+    esp_ble_gattc_cb_param_t p{};
+    p.disconnect.conn_id = CONN_ID;
+    hub.gattc_event_handler(ESP_GATTC_DISCONNECT_EVT, 0, &p);
+    EXPECT_EQ(hub.queued(), 0u);
+    EXPECT_EQ(hub.ble_drops(), 2u);
+    EXPECT_EQ(hub.in_flight(), 0u);
+}
+
+TEST_F(BleFlowControlTest, ProvisioningBurstOf500HasZeroDrops) {
+    static constexpr int N = 500;
+    for (int i = 0; i < N; i++) {
+        Command cmd;
+        cmd_insert_group(static_cast<uint16_t>(32900 + i), 256, cmd);
+        hub.queue(cmd, TxClass::Provisioning);
+    }
+
+    // Simulated controller: completes the oldest write a few ms after it was
+    // issued and raises congestion for a while every 100 writes.
+    size_t completed = 0;
+    uint8_t max_in_flight = 0;
+    bool writes_while_congested = false;
+    bool congested = false;
+    uint32_t congest_until = 0;
+
+    for (uint32_t t = 1000; t < 1000 + 200000 && completed < 2u * N; t++) {
+        esphome::set_test_millis(t);
+
+        if (congested && t >= congest_until) {
+            congested = false;
+            hub.congest(false);
+        }
+
+        size_t before = test_gattc_writes().size();
+        hub.loop();
+        if (congested && test_gattc_writes().size() != before)
+            writes_while_congested = true;
+        if (hub.in_flight() > max_in_flight)
+            max_in_flight = hub.in_flight();
+
+        if (t % 3 == 0 && completed < test_gattc_writes().size()) {
+            before = test_gattc_writes().size();
+            hub.complete_write();
+            completed++;
+            if (congested && test_gattc_writes().size() != before)
+                writes_while_congested = true;
+            if (!congested && completed % 100 == 0) {
+                congested = true;
+                congest_until = t + 50;
+                hub.congest(true);
+            }
+        }
+        if (hub.in_flight() > max_in_flight)
+            max_in_flight = hub.in_flight();
+    }
+
+    auto &writes = test_gattc_writes();
+    ASSERT_EQ(writes.size(), 2u * N);
+    EXPECT_EQ(completed, 2u * N);
+    EXPECT_LE(max_in_flight, 4u);
+    EXPECT_FALSE(writes_while_congested);
+    EXPECT_EQ(hub.ble_drops(), 0u);
+    EXPECT_EQ(hub.tx().stats(TxClass::Provisioning).dropped, 0u);
+    EXPECT_EQ(hub.tx().stats(TxClass::Provisioning).sent, static_cast<uint32_t>(N));
+
+    // Fragments arrive in order: low then high for each command, ascending dest
+    for (int i = 0; i < N; i++) {
+        uint16_t dest = static_cast<uint16_t>(32900 + i);
+        auto &lo = writes[2 * i];
+        auto &hi = writes[2 * i + 1];
+        ASSERT_EQ(lo.handle, HANDLE_LOW) << "command " << i;
+        ASSERT_EQ(hi.handle, HANDLE_HIGH) << "command " << i;
+        ASSERT_EQ((lo.data[0] << 8) | lo.data[1], dest) << "command " << i;
+        ASSERT_EQ((hi.data[0] << 8) | hi.data[1], dest) << "command " << i;
+    }
+}
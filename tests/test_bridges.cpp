@@ -0,0 +1,213 @@
+// Tests: multiple concurrent bridge links — load balancing, surviving the
+// loss of one link, cross-link RX dedupe, bringing up the strongest bridges
+// from a scan, and failing over through the ranked candidate table.
+
+#include "mock_hub.h"
+#include "esphome/core/component.h"
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+using namespace avionmesh;
+
+static constexpr uint16_t DEV = 32900;
+
+// Sends each mesh command as one MTL fragment on the least loaded link.
+class BridgeHub : public TestHub {
+public:
+    void send(const Command &cmd) { do_mesh_send(cmd); }
+
+    void rx_brightness(uint8_t bridge, uint16_t device_id, uint8_t brightness) {
+        uint8_t payload[] = {0x00, 0x0A, 0x00, 0x00, 0x00, brightness, 0x00, 0x00, 0x00, 0x00};
+        bridge_rx(bridge, device_id, payload, sizeof(payload));
+    }
+
+    uint32_t rx_count() const { return rx_count_; }
+    uint32_t rx_duplicates() const { return rx_dedupe_.duplicates(); }
+
+protected:
+    void do_mesh_send(const Command &cmd) override {
+        TestHub::do_mesh_send(cmd);
+        uint8_t frag[csrmesh::MTL_FRAG_SIZE] = {};
+        frag[0] = static_cast<uint8_t>(cmd.dest_id >> 8);
+        frag[1] = static_cast<uint8_t>(cmd.dest_id & 0xFF);
+        if (auto *br = pick_bridge())
+            br->write(csrmesh::Characteristic::Low, frag, sizeof(frag), false, esphome::millis());
+    }
+};
+
+class BridgeTest : public ::testing::Test {
+protected:
+    BridgeHub hub;
+
+    void SetUp() override {
+        esphome::set_test_millis(1000);
+        test_gattc_writes().clear();
+        test_gattc_opens().clear();
+        hub.test_setup();
+    }
+};
+
+TEST_F(BridgeTest, SendsAreSpreadAcrossReadyBridges) {
+    hub.bring_up_bridge(0, 1);
+    hub.bring_up_bridge(1, 2);
+
+    Command cmd;
+    cmd_brightness(DEV, 100, cmd);
+    for (int i = 0; i < 6; i++)
+        hub.send(cmd);
+
+    // No completions arrive, so each link's load grows and the next send
+    // goes to the other one
+    EXPECT_EQ(hub.bridge(0).load(), 3u);
+    EXPECT_EQ(hub.bridge(1).load(), 3u);
+}
+
+TEST_F(BridgeTest, LosingOneBridgeKeepsMeshReady) {
+    hub.bring_up_bridge(0, 1);
+    hub.bring_up_bridge(1, 2);
+    ASSERT_EQ(hub.ble_state(), BleState::Ready);
+
+    hub.clear_captures();
+    hub.disconnect(1);
+    EXPECT_EQ(hub.ble_state(), BleState::Ready);
+    EXPECT_FALSE(hub.bridge(0).ready());
+    EXPECT_TRUE(hub.bridge(1).ready());
+
+    Command cmd;
+    cmd_brightness(DEV, 100, cmd);
+    hub.send(cmd);
+    EXPECT_EQ(hub.bridge(1).writes(), 1u);
+
+    hub.disconnect(2);
+    EXPECT_EQ(hub.ble_state(), BleState::Disconnected);
+}
+
+TEST_F(BridgeTest, StatsListEveryBridge) {
+    hub.bring_up_bridge(0, 1);
+    hub.bring_up_bridge(1, 2);
+    std::string stats = hub.stats();
+    EXPECT_NE(stats.find("\"bridges\":[{\"index\":0"), std::string::npos);
+    EXPECT_NE(stats.find("{\"index\":1,\"address\":\"02:00:00:00:00:01\""), std::string::npos);
+    EXPECT_NE(stats.find("\"rx_duplicates\":0"), std::string::npos);
+}
+
+TEST_F(BridgeTest, SamePacketFromTwoBridgesIsProcessedOnce) {
+    hub.bring_up_bridge(0, 1);
+    hub.bring_up_bridge(1, 2);
+
+    hub.rx_brightness(0, DEV, 80);
+    esphome::set_test_millis(1050);
+    hub.rx_brightness(1, DEV, 80);
+    EXPECT_EQ(hub.rx_count(), 1u);
+    EXPECT_EQ(hub.rx_duplicates(), 1u);
+
+    // Outside the window the relay is a new report
+    esphome::set_test_millis(1700);
+    hub.rx_brightness(1, DEV, 80);
+    EXPECT_EQ(hub.rx_count(), 2u);
+}
+
+TEST_F(BridgeTest, RelayedCopyOnSameBridgeIsDropped) {
+    hub.bring_up_bridge(0, 1);
+    hub.bring_up_bridge(1, 2);
+
+    hub.rx_brightness(0, DEV, 80);
+    esphome::set_test_millis(1100);
+    hub.rx_brightness(0, DEV, 80);
+    EXPECT_EQ(hub.rx_count(), 1u);
+    EXPECT_EQ(hub.rx_duplicates(), 1u);
+
+    // A device resending its report later is still processed
+    esphome::set_test_millis(1300);
+    hub.rx_brightness(0, DEV, 80);
+    EXPECT_EQ(hub.rx_count(), 2u);
+    EXPECT_EQ(hub.rx_duplicates(), 1u);
+}
+
+TEST_F(BridgeTest, ScanConnectsStrongestBridges) {
+    hub.register_gattc();
+    ASSERT_EQ(hub.ble_state(), BleState::Scanning);
+
+    // Three bridges advertising the CSRMesh service, weakest first
+    hub.scan({-80, -55, -65});
+
+    // Strongest first; the second open waits for the first link
+    ASSERT_EQ(test_gattc_opens().size(), 1u);
+    EXPECT_EQ(test_gattc_opens()[0].bda[5], 0xA1);
+
+    hub.open_last(1);
+    hub.open_last(2);
+
+    // max_bridges defaults to 2: the weakest bridge is left alone
+    ASSERT_EQ(test_gattc_opens().size(), 2u);
+    EXPECT_EQ(test_gattc_opens()[1].bda[5], 0xA2);
+    EXPECT_TRUE(hub.bridge(0).ready());
+    EXPECT_TRUE(hub.bridge(1).ready());
+    EXPECT_EQ(hub.bridge(0).char_low_handle(), 0x0013);
+    EXPECT_EQ(hub.bridge(0).char_high_handle(), 0x0014);
+    EXPECT_EQ(hub.ble_state(), BleState::Ready);
+}
+
+TEST_F(BridgeTest, DisconnectFailsOverToNextCandidateWithoutRescan) {
+    hub.set_max_bridges(1);
+    hub.register_gattc();
+    hub.scan({-80, -55, -65});
+    hub.open_last(1);
+    ASSERT_EQ(test_gattc_opens().size(), 1u);
+
+    esphome::set_test_millis(5000);
+    hub.disconnect(1);
+    EXPECT_EQ(hub.ble_state(), BleState::Connecting) << "no rescan";
+    ASSERT_EQ(test_gattc_opens().size(), 2u);
+    EXPECT_EQ(test_gattc_opens()[1].bda[5], 0xA2);
+
+    esphome::set_test_millis(5400);
+    hub.open_last(2);
+    EXPECT_EQ(hub.ble_state(), BleState::Ready);
+    std::string stats = hub.stats();
+    EXPECT_NE(stats.find("\"failover\":{\"count\":1,\"rescans\":0,\"last_ms\":400"),
+              std::string::npos) << stats;
+}
+
+TEST_F(BridgeTest, FailedOpenMovesDownTheTable) {
+    hub.set_max_bridges(1);
+    hub.register_gattc();
+    hub.scan({-80, -55, -65});
+    hub.fail_last_open();
+    ASSERT_EQ(test_gattc_opens().size(), 2u);
+    EXPECT_EQ(test_gattc_opens()[1].bda[5], 0xA2);
+    hub.fail_last_open();
+    ASSERT_EQ(test_gattc_opens().size(), 3u);
+    EXPECT_EQ(test_gattc_opens()[2].bda[5], 0xA0);
+
+    // Table exhausted: only now does the hub scan again
+    hub.fail_last_open();
+    EXPECT_EQ(hub.ble_state(), BleState::Scanning);
+
+    // Bridges seen again are eligible again
+    hub.scan({-80, -55});
+    ASSERT_EQ(test_gattc_opens().size(), 4u);
+    EXPECT_EQ(test_gattc_opens()[3].bda[5], 0xA1);
+}
+
+TEST_F(BridgeTest, StaleTableForcesRescan) {
+    hub.set_max_bridges(1);
+    hub.register_gattc();
+    hub.scan({-80, -55});
+    hub.open_last(1);
+
+    // Ten minutes later the remaining candidate is too old to trust
+    esphome::set_test_millis(1000 + 600000);
+    hub.disconnect(1);
+    EXPECT_EQ(hub.ble_state(), BleState::Scanning);
+    EXPECT_EQ(test_gattc_opens().size(), 1u);
+
+    esphome::set_test_millis(1000 + 605000);
+    hub.scan({-80, -55});
+    ASSERT_EQ(test_gattc_opens().size(), 2u);
+    hub.open_last(2);
+    std::string stats = hub.stats();
+    EXPECT_NE(stats.find("\"failover\":{\"count\":1,\"rescans\":1,\"last_ms\":5000"),
+              std::string::npos) << stats;
+}
@@ -0,0 +1,103 @@
+// Tests: discovery config hashes — unchanged configs are not republished,
+// changed or forced ones are, and the hash table is saved in one batch.
+
+#include "mock_hub.h"
+#include "config_hashes.h"
+#include "esphome/core/component.h"
+#include <gtest/gtest.h>
+
+using namespace avionmesh;
+
+static constexpr uint16_t DEV = 32900;
+static constexpr uint16_t GRP = 100;
+
+TEST(ConfigHashesTest, HashCoversTopicAndConfig) {
+    uint32_t h = ConfigHashes::hash("homeassistant/light/a_1/config", "{}");
+    EXPECT_EQ(h, ConfigHashes::hash("homeassistant/light/a_1/config", "{}"));
+    EXPECT_NE(h, ConfigHashes::hash("homeassistant/light/a_2/config", "{}"));
+    EXPECT_NE(h, ConfigHashes::hash("homeassistant/light/a_1/config", "{ }"));
+}
+
+TEST(ConfigHashesTest, SavedOnceChangesSettle) {
+    ConfigHashes hashes;
+    hashes.set(DEV, 1);
+    hashes.poll(1000);
+    hashes.set(GRP, 2);
+    hashes.poll(1000 + ConfigHashes::SAVE_DELAY_MS);
+    EXPECT_EQ(hashes.saves(), 0u) << "a later change restarts the settle timer";
+    hashes.poll(1000 + 2 * ConfigHashes::SAVE_DELAY_MS);
+    EXPECT_EQ(hashes.saves(), 1u);
+    EXPECT_FALSE(hashes.dirty());
+
+    // Storing the same hash again is not a change
+    hashes.set(DEV, 1);
+    EXPECT_FALSE(hashes.dirty());
+    EXPECT_TRUE(hashes.matches(DEV, 1));
+    hashes.erase(DEV);
+    EXPECT_FALSE(hashes.matches(DEV, 1));
+    EXPECT_TRUE(hashes.dirty());
+}
+
+// --- Hub wiring ---
+
+class ConfigHashHubTest : public ::testing::Test {
+protected:
+    TestHub hub;
+
+    void SetUp() override {
+        hub.setup_light(DEV, 93, "Kitchen", false);
+        hub.db().add_group(GRP, "Downstairs");
+        hub.db().find_group(GRP)->mqtt_exposed = true;
+        hub.test_setup();
+        ha_online();
+        hub.clear_captures();
+    }
+
+    void ha_online(bool force = false) {
+        hub.announce(force);
+        while (hub.discovery_pending())
+            hub.pump(esphome::millis());
+    }
+
+    size_t configs() const {
+        size_t n = 0;
+        for (auto &[topic, payload, retain] : hub.mqtt_publishes)
+            if (topic.rfind("homeassistant/light/", 0) == 0)
+                n++;
+        return n;
+    }
+};
+
+TEST_F(ConfigHashHubTest, UnchangedConfigsSkipped) {
+    ha_online();
+    EXPECT_EQ(configs(), 0u);
+    std::string stats = hub.stats();
+    EXPECT_NE(stats.find("\"published\":2,\"skipped\":2,"), std::string::npos) << stats;
+}
+
+TEST_F(ConfigHashHubTest, ChangedConfigRepublished) {
+    hub.db().find_device(DEV)->name = "Kitchen Island";
+    ha_online();
+    ASSERT_EQ(configs(), 1u);
+    EXPECT_NE(std::get<1>(hub.mqtt_publishes[0]).find("Kitchen Island"), std::string::npos);
+}
+
+TEST_F(ConfigHashHubTest, ForcedResyncRepublishesAll) {
+    ha_online(true);
+    EXPECT_EQ(configs(), 2u);
+}
+
+TEST_F(ConfigHashHubTest, RemovedEntityPublishedAgainWhenReexposed) {
+    DeferredAction act;
+    act.type = DeferredAction::SetMqttExposed;
+    act.id1 = DEV;
+    act.id2 = 0;
+    hub.push_action(act);
+    act.id2 = 1;
+    hub.push_action(act);
+    size_t configs = 0;
+    for (auto &[topic, payload, retain] : hub.mqtt_publishes)
+        if (topic == "homeassistant/light/test_32900/config" && !payload.empty())
+            configs++;
+    EXPECT_EQ(configs, 1u);
+}
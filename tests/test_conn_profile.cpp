@@ -0,0 +1,138 @@
+// Tests: connection parameter profiles — shortest interval for light control,
+// bulk during discovery / backlog, relaxed back to idle, reported in meta and
+// MQTT status.
+
+#include "mock_hub.h"
+#include "esphome/core/component.h"
+#include <gtest/gtest.h>
+
+using namespace avionmesh;
+
+class ConnProfileTest : public ::testing::Test {
+protected:
+    TestHub hub;
+
+    void SetUp() override {
+        esphome::set_test_millis(1000);
+        test_conn_updates().clear();
+        hub.test_setup();
+        hub.bring_up_bridge(0, 1);
+    }
+
+    ConnProfile profile() { return hub.bridge(0).profile(); }
+
+    void queue_provisioning(int n) {
+        for (int i = 0; i < n; i++) {
+            Command cmd;
+            cmd_insert_group(static_cast<uint16_t>(32900 + i), 256, cmd);
+            hub.queue(cmd, TxClass::Provisioning);
+        }
+    }
+
+    void set_level(uint16_t id, uint8_t level) {
+        Command cmd;
+        cmd_brightness(id, level, cmd);
+        hub.queue(cmd, TxClass::Interactive);
+    }
+
+    void tick_until(uint32_t end) {
+        for (uint32_t t = esphome::millis(); t <= end; t += 50) {
+            esphome::set_test_millis(t);
+            hub.loop();
+        }
+    }
+};
+
+TEST_F(ConnProfileTest, IdleRequestedOnConnect) {
+    ASSERT_EQ(test_conn_updates().size(), 1u);
+    EXPECT_EQ(profile(), ConnProfile::Idle);
+    EXPECT_EQ(test_conn_updates()[0].min_int, 12);
+    EXPECT_EQ(test_conn_updates()[0].latency, 0);
+}
+
+TEST_F(ConnProfileTest, LightControlGetsShortestIntervalThenRelaxes) {
+    esphome::set_test_millis(3000);
+    set_level(100, 200);
+    EXPECT_EQ(profile(), ConnProfile::Interactive);
+    ASSERT_EQ(test_conn_updates().size(), 2u);
+    EXPECT_EQ(test_conn_updates()[1].min_int, 6);
+    EXPECT_EQ(test_conn_updates()[1].max_int, 6);
+    EXPECT_LE(test_conn_updates()[1].max_int, test_conn_updates()[0].min_int / 2);
+
+    // Each command extends the hold
+    esphome::set_test_millis(6000);
+    set_level(100, 100);
+    tick_until(10900);
+    EXPECT_EQ(profile(), ConnProfile::Interactive);
+
+    tick_until(11100);
+    EXPECT_EQ(profile(), ConnProfile::Idle);
+    ASSERT_EQ(test_conn_updates().size(), 3u);
+    EXPECT_EQ(test_conn_updates()[2].min_int, 12);
+}
+
+TEST_F(ConnProfileTest, LightControlPreemptsBulk) {
+    esphome::set_test_millis(3000);
+    hub.command("{\"action\":\"discover_mesh\"}");
+    EXPECT_EQ(profile(), ConnProfile::Bulk);
+
+    esphome::set_test_millis(4100);
+    set_level(100, 200);
+    EXPECT_EQ(profile(), ConnProfile::Interactive);
+    EXPECT_EQ(test_conn_updates().back().max_int, 6);
+}
+
+TEST_F(ConnProfileTest, DiscoverySwitchesToBulkThenRelaxes) {
+    esphome::set_test_millis(3000);
+    hub.command("{\"action\":\"discover_mesh\"}");
+    EXPECT_EQ(profile(), ConnProfile::Bulk);
+    ASSERT_EQ(test_conn_updates().size(), 2u);
+    EXPECT_EQ(test_conn_updates()[1].min_int, 6);
+
+    tick_until(7900);
+    EXPECT_EQ(profile(), ConnProfile::Bulk) << "sweep still running";
+
+    tick_until(8100);
+    EXPECT_EQ(profile(), ConnProfile::Idle);
+    ASSERT_EQ(test_conn_updates().size(), 3u);
+    EXPECT_EQ(test_conn_updates()[2].min_int, 12);
+}
+
+TEST_F(ConnProfileTest, BacklogHoldsBulkUntilDrained) {
+    esphome::set_test_millis(3000);
+    queue_provisioning(40);
+    hub.loop();
+    EXPECT_EQ(profile(), ConnProfile::Bulk);
+
+    // 40 commands at 120 ms drain in ~4.8 s; bulk is held while backlog lasts
+    tick_until(6000);
+    EXPECT_EQ(profile(), ConnProfile::Bulk);
+    tick_until(12000);
+    EXPECT_EQ(profile(), ConnProfile::Idle);
+}
+
+TEST_F(ConnProfileTest, UpdatesAreRateLimited) {
+    // Bulk requested within 1 s of the connect-time update waits for the gap
+    queue_provisioning(40);
+    hub.loop();
+    EXPECT_EQ(profile(), ConnProfile::Idle);
+    tick_until(2000);
+    EXPECT_EQ(profile(), ConnProfile::Bulk);
+}
+
+TEST_F(ConnProfileTest, MetaAndStatusReportProfileAndInterval) {
+    hub.clear_captures();
+    hub.conn_params_updated(0, 6);
+
+    ASSERT_FALSE(hub.sse_events.empty());
+    auto &meta = hub.sse_events.back();
+    EXPECT_EQ(meta.first, "meta");
+    EXPECT_NE(meta.second.find("\"conn_profile\":\"idle\""), std::string::npos);
+    EXPECT_NE(meta.second.find("\"conn_interval_ms\":7.50"), std::string::npos);
+
+    hub.command("{\"action\":\"status\"}");
+    ASSERT_FALSE(hub.mqtt_publishes.empty());
+    auto &resp = std::get<1>(hub.mqtt_publishes.back());
+    EXPECT_NE(resp.find("\"conn_profile\":\"idle\""), std::string::npos);
+    EXPECT_NE(resp.find("\"conn_interval_ms\":7.50"), std::string::npos);
+}
@@ -0,0 +1,119 @@
+// Tests: DeviceDB ID index and membership matrix — lookups stay correct across
+// adds, removals and growth, devices() / groups() keep their insertion order,
+// and the groups / member_ids views follow the matrix.
+
+#include "device_db.h"
+#include <gtest/gtest.h>
+
+using namespace avionmesh;
+
+TEST(IdIndexTest, FindInsertGrow) {
+    IdIndex index;
+    EXPECT_EQ(index.find(1), IdIndex::NOT_FOUND);
+    for (uint16_t i = 0; i < 1000; i++)
+        index.insert(static_cast<uint16_t>(32896 + i * 7), i);
+    EXPECT_GE(index.capacity(), 2000u) << "at most half full";
+    for (uint16_t i = 0; i < 1000; i++)
+        ASSERT_EQ(index.find(static_cast<uint16_t>(32896 + i * 7)), i);
+    EXPECT_EQ(index.find(32897), IdIndex::NOT_FOUND);
+
+    index.insert(32896, 999);
+    EXPECT_EQ(index.find(32896), 999u) << "re-insert moves the entry";
+    index.clear();
+    EXPECT_EQ(index.find(32896), IdIndex::NOT_FOUND);
+}
+
+TEST(DeviceDbIndexTest, RemovalKeepsOrderAndLookups) {
+    DeviceDB db;
+    for (uint16_t i = 0; i < 50; i++)
+        db.add_device(static_cast<uint16_t>(32900 + i), 93, "L" + std::to_string(i));
+    for (uint16_t g = 1; g <= 5; g++)
+        db.add_group(g, "G" + std::to_string(g));
+    db.add_device_to_group(32910, 3);
+
+    EXPECT_FALSE(db.add_device(32910, 93, "dup"));
+    EXPECT_TRUE(db.remove_device(32905));
+    EXPECT_TRUE(db.remove_group(2));
+    EXPECT_EQ(db.find_device(32905), nullptr);
+    EXPECT_EQ(db.find_group(2), nullptr);
+
+    ASSERT_EQ(db.devices().size(), 49u);
+    EXPECT_EQ(db.devices()[5].avion_id, 32906);
+    for (auto &d : db.devices())
+        ASSERT_EQ(db.find_device(d.avion_id), &d);
+    EXPECT_EQ(db.find_group(3)->member_ids, std::vector<uint16_t>{32910});
+    EXPECT_EQ(db.groups()[1].group_id, 3);
+
+    db.clear();
+    EXPECT_EQ(db.find_device(32900), nullptr);
+    EXPECT_TRUE(db.add_device(32900, 93, "again"));
+    EXPECT_EQ(db.find_device(32900)->name, "again");
+}
+
+TEST(SlotBitsetTest, SetOpsAcrossWords) {
+    SlotBitset a, b;
+    for (size_t i : {1, 31, 32, 70})
+        a.set(i);
+    for (size_t i : {1, 31, 32, 33, 70, 100})
+        b.set(i);
+    EXPECT_TRUE(a.test(70));
+    EXPECT_FALSE(a.test(500));
+    EXPECT_EQ(a.count(), 4u);
+    EXPECT_TRUE(a.is_subset_of(b));
+    EXPECT_FALSE(b.is_subset_of(a));
+    EXPECT_EQ(a.intersect_count(b), 4u);
+
+    SlotBitset c;
+    c.set(33);
+    EXPECT_FALSE(a.intersects(c));
+    EXPECT_TRUE(b.intersects(c));
+
+    std::vector<size_t> seen;
+    b.for_each([&](size_t i) { seen.push_back(i); });
+    EXPECT_EQ(seen, (std::vector<size_t>{1, 31, 32, 33, 70, 100}));
+
+    a.reset(70);
+    a.reset(900);
+    EXPECT_EQ(a.count(), 3u);
+    EXPECT_TRUE(SlotBitset().is_subset_of(c));
+}
+
+TEST(DeviceDbMatrixTest, ViewsFollowMembership) {
+    DeviceDB db;
+    for (uint16_t i = 0; i < 40; i++)
+        db.add_device(static_cast<uint16_t>(32900 + i), 93, "L");
+    db.add_group(1, "Kitchen");
+    db.add_group(2, "Downstairs");
+    for (uint16_t i = 0; i < 40; i++)
+        db.add_device_to_group(static_cast<uint16_t>(32900 + i), 2);
+    db.add_device_to_group(32935, 1);
+    db.add_device_to_group(32901, 1);
+    db.add_device_to_group(32901, 1);
+
+    EXPECT_TRUE(db.is_member(32935, 1));
+    EXPECT_FALSE(db.is_member(32902, 1));
+    EXPECT_FALSE(db.is_member(32935, 9));
+    EXPECT_EQ(db.members(*db.find_group(2)).count(), 40u);
+    EXPECT_TRUE(db.members(*db.find_group(1)).is_subset_of(db.members(*db.find_group(2))));
+    EXPECT_EQ(db.find_group(1)->member_ids, (std::vector<uint16_t>{32901, 32935}));
+    EXPECT_EQ(db.find_device(32901)->groups, (std::vector<uint16_t>{1, 2}));
+
+    db.remove_device_from_group(32901, 2);
+    EXPECT_EQ(db.find_device(32901)->groups, std::vector<uint16_t>{1});
+    EXPECT_FALSE(db.members(*db.find_group(1)).is_subset_of(db.members(*db.find_group(2))));
+
+    // Removals clear the entity's bits; a new entity reuses the freed slot clean
+    db.remove_device(32935);
+    EXPECT_EQ(db.find_group(1)->member_ids, std::vector<uint16_t>{32901});
+    EXPECT_EQ(db.members(*db.find_group(2)).count(), 38u);
+    db.add_device(33000, 93, "New");
+    EXPECT_EQ(db.find_device(33000)->slot, 35u);
+    EXPECT_TRUE(db.find_device(33000)->groups.empty());
+    EXPECT_FALSE(db.is_member(33000, 2));
+
+    db.remove_group(1);
+    EXPECT_EQ(db.find_device(32901)->groups, std::vector<uint16_t>{});
+    db.add_group(3, "Porch");
+    EXPECT_EQ(db.group_at(db.find_group(3)->slot), 3u);
+    EXPECT_TRUE(db.find_group(3)->member_ids.empty());
+}
@@ -0,0 +1,154 @@
+// Tests: HA device-based discovery — lights published as components of one
+// gateway device in a few chunked configs, updated incrementally.
+
+#include "mock_hub.h"
+#include "esphome/core/component.h"
+#include <gtest/gtest.h>
+
+using namespace avionmesh;
+
+static constexpr uint16_t DEV = 32900;
+static constexpr size_t LIGHTS = 40;
+static constexpr size_t CHUNK_BYTES = 4096;
+
+static void settle(TestHub &hub) {
+    for (int i = 0; i < 100; i++)
+        hub.pump(esphome::millis());
+}
+
+static void run(TestHub &hub, bool force = false) {
+    hub.announce(force);
+    settle(hub);
+}
+
+static std::vector<std::pair<std::string, std::string>> discovery_configs(const TestHub &hub) {
+    std::vector<std::pair<std::string, std::string>> out;
+    for (auto &[topic, payload, retain] : hub.mqtt_publishes)
+        if (topic.rfind("homeassistant/", 0) == 0)
+            out.emplace_back(topic, payload);
+    return out;
+}
+
+class DeviceDiscoveryTest : public ::testing::Test {
+protected:
+    TestHub hub;
+
+    void SetUp() override {
+        esphome::set_test_millis(1000);
+        for (uint16_t i = 0; i < LIGHTS; i++) {
+            hub.db().add_device(DEV + i, 93, "Light " + std::to_string(i));
+            hub.db().find_device(DEV + i)->mqtt_exposed = true;
+        }
+        hub.discovery().set_device_discovery(true);
+        hub.discovery().set_chunk_bytes(CHUNK_BYTES);
+        hub.test_setup();
+    }
+
+    void set_exposed(uint16_t id, bool exposed) {
+        DeferredAction act;
+        act.type = DeferredAction::SetMqttExposed;
+        act.id1 = id;
+        act.id2 = exposed ? 1 : 0;
+        hub.push_action(act);
+        settle(hub);
+    }
+};
+
+TEST_F(DeviceDiscoveryTest, FewChunkedConfigsCarryEveryLight) {
+    run(hub);
+    auto configs = discovery_configs(hub);
+    ASSERT_EQ(configs.size(), hub.discovery().device_chunks());
+    EXPECT_GT(hub.discovery().device_chunks(), 1u);
+    EXPECT_LT(hub.discovery().device_chunks(), LIGHTS / 4);
+
+    size_t components = 0;
+    for (size_t i = 0; i < configs.size(); i++) {
+        auto &payload = configs[i].second;
+        EXPECT_EQ(configs[i].first, "homeassistant/device/test_lights_" + std::to_string(i) + "/config");
+        EXPECT_LE(payload.size(), CHUNK_BYTES);
+        EXPECT_EQ(payload.rfind("{\"dev\":{\"ids\":[\"test\"],", 0), 0u) << payload;
+        EXPECT_EQ(payload.substr(payload.size() - 2), "}}");
+        for (size_t pos = payload.find("{\"p\":\"light\","); pos != std::string::npos;
+             pos = payload.find("{\"p\":\"light\",", pos + 1))
+            components++;
+    }
+    EXPECT_EQ(components, LIGHTS);
+
+    EXPECT_NE(configs[0].second.find("\"test_32900\":{\"p\":\"light\",\"name\":\"Light 0\","
+                                     "\"uniq_id\":\"test_32900\",\"~\":\"avionmesh/light/32900\","
+                                     "\"cmd_t\":\"~/set\",\"stat_t\":\"~/state\","
+                                     "\"bri_cmd_t\":\"~/brightness/set\",\"bri_stat_t\":\"~/brightness/state\","),
+              std::string::npos)
+        << configs[0].second;
+    EXPECT_NE(configs[0].second.find("\"clr_temp_cmd_t\":\"~/color_temp/set\""), std::string::npos);
+}
+
+TEST_F(DeviceDiscoveryTest, UnchangedRunPublishesNothingForcedRunEverything) {
+    run(hub);
+    size_t chunks = hub.discovery().device_chunks();
+    hub.clear_captures();
+    run(hub);
+    EXPECT_TRUE(discovery_configs(hub).empty());
+    run(hub, true);
+    EXPECT_EQ(discovery_configs(hub).size(), chunks);
+}
+
+TEST_F(DeviceDiscoveryTest, ExposureChangesTouchOneChunk) {
+    run(hub);
+    hub.clear_captures();
+
+    set_exposed(DEV + 3, false);
+    auto configs = discovery_configs(hub);
+    ASSERT_EQ(configs.size(), 1u) << "only the chunk holding the light";
+    EXPECT_NE(configs[0].second.find("\"test_32903\":{\"p\":\"light\"}"), std::string::npos)
+        << configs[0].second;
+
+    hub.clear_captures();
+    set_exposed(DEV + 3, true);
+    configs = discovery_configs(hub);
+    ASSERT_EQ(configs.size(), 1u);
+    EXPECT_NE(configs[0].second.find("\"test_32903\":{\"p\":\"light\",\"name\":\"Light 3\""), std::string::npos);
+    EXPECT_EQ(configs[0].second.find("\"test_32903\":{\"p\":\"light\"}"), std::string::npos)
+        << "the removal was sent already";
+}
+
+TEST_F(DeviceDiscoveryTest, ReexposedBeforeFlushKeepsOneEntry) {
+    run(hub);
+    hub.clear_captures();
+    DeferredAction act;
+    act.type = DeferredAction::SetMqttExposed;
+    act.id1 = DEV;
+    act.id2 = 0;
+    hub.push_action(act);
+    act.id2 = 1;
+    hub.push_action(act);
+    settle(hub);
+    for (auto &[topic, payload] : discovery_configs(hub))
+        EXPECT_EQ(payload.find("\"test_32900\":{\"p\":\"light\"}"), std::string::npos) << payload;
+}
+
+TEST_F(DeviceDiscoveryTest, PerLightConfigsClearedAfterSwitch) {
+    // Left over from per-light discovery before the switch
+    hub.discovery().config_hashes().set(DEV, 1234);
+    run(hub);
+    bool cleared = false;
+    for (auto &[topic, payload] : discovery_configs(hub))
+        if (topic == "homeassistant/light/test_32900/config" && payload.empty())
+            cleared = true;
+    EXPECT_TRUE(cleared);
+    EXPECT_FALSE(hub.discovery().config_hashes().contains(DEV));
+}
+
+TEST(DeviceDiscoverySwitchTest, ChunksClearedWhenBackToPerLight) {
+    TestHub hub;
+    hub.setup_light(DEV, 93, "A", false);
+    hub.discovery().config_hashes().set(ConfigHashes::DEVICE_CHUNK_KEY + 0, 1234);
+    run(hub);
+    auto configs = discovery_configs(hub);
+    bool cleared = false;
+    for (auto &[topic, payload] : configs)
+        if (topic == "homeassistant/device/test_lights_0/config" && payload.empty())
+            cleared = true;
+    EXPECT_TRUE(cleared);
+    EXPECT_EQ(hub.discovery().config_hashes().size(), 1u) << "only the per-light hash is left";
+}
@@ -0,0 +1,208 @@
+// Tests: GATT handle cache — filled by full discovery, used to reconnect to a
+// known bridge without scanning or service discovery, and dropped again when
+// a cached handle fails.
+
+#include "mock_hub.h"
+#include "esphome/core/component.h"
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+using namespace avionmesh;
+
+static const uint8_t BRIDGE_BDA[6] = {0x00, 0x00, 0x00, 0x00, 0x00, 0xA0};
+
+class CacheHub : public TestHub {
+public:
+    void scan_one(int rssi) {
+        esphome::esp32_ble::BLEScanResult res;
+        res.search_evt = ESP_GAP_SEARCH_INQ_RES_EVT;
+        std::memcpy(res.bda, BRIDGE_BDA, 6);
+        res.rssi = rssi;
+        const uint8_t adv[] = {0x03, 0x03, 0xF1, 0xFE};
+        std::memcpy(res.ble_adv, adv, sizeof(adv));
+        res.adv_data_len = sizeof(adv);
+        gap_scan_event_handler(res);
+        esphome::esp32_ble::BLEScanResult done;
+        done.search_evt = ESP_GAP_SEARCH_INQ_CMPL_EVT;
+        gap_scan_event_handler(done);
+    }
+
+    void open(uint16_t conn_id) {
+        esp_ble_gattc_cb_param_t p{};
+        p.open.status = ESP_GATT_OK;
+        p.open.conn_id = conn_id;
+        std::memcpy(p.open.remote_bda, BRIDGE_BDA, 6);
+        gattc_event_handler(ESP_GATTC_OPEN_EVT, 4, &p);
+    }
+
+    void search_complete(uint16_t conn_id) {
+        esp_ble_gattc_cb_param_t p{};
+        p.search_cmpl.conn_id = conn_id;
+        gattc_event_handler(ESP_GATTC_SEARCH_CMPL_EVT, 4, &p);
+    }
+
+    void notify_registered(uint16_t handle) {
+        esp_ble_gattc_cb_param_t p{};
+        p.reg_for_notify.handle = handle;
+        p.reg_for_notify.status = ESP_GATT_OK;
+        gattc_event_handler(ESP_GATTC_REG_FOR_NOTIFY_EVT, 4, &p);
+    }
+
+    void descr_written(uint16_t conn_id, int status = ESP_GATT_OK) {
+        esp_ble_gattc_cb_param_t p{};
+        p.write.conn_id = conn_id;
+        p.write.status = static_cast<esp_gatt_status_t>(status);
+        gattc_event_handler(ESP_GATTC_WRITE_DESCR_EVT, 4, &p);
+    }
+
+    void char_written(uint16_t conn_id, int status) {
+        esp_ble_gattc_cb_param_t p{};
+        p.write.conn_id = conn_id;
+        p.write.status = static_cast<esp_gatt_status_t>(status);
+        gattc_event_handler(ESP_GATTC_WRITE_CHAR_EVT, 4, &p);
+    }
+
+    void seed_cache(uint16_t low, uint16_t high) {
+        GattCacheEntry e;
+        std::memcpy(e.bda, BRIDGE_BDA, 6);
+        e.rssi = -60;
+        e.char_low = low;
+        e.char_high = high;
+        e.cccd_low = low + 1;
+        e.cccd_high = high + 1;
+        gatt_cache_.store(e);
+    }
+
+    GattCache &cache() { return gatt_cache_; }
+};
+
+class GattCacheTest : public ::testing::Test {
+protected:
+    CacheHub hub;
+
+    void SetUp() override {
+        esphome::set_test_millis(1000);
+        test_gattc_opens().clear();
+        test_gattc_searches().clear();
+        test_gattc_descr_writes().clear();
+        hub.test_setup();
+        hub.set_max_bridges(1);
+    }
+};
+
+TEST_F(GattCacheTest, FullDiscoveryFillsCache) {
+    hub.register_gattc();
+    ASSERT_EQ(hub.ble_state(), BleState::Scanning);
+    hub.scan_one(-60);
+    hub.open(1);
+    ASSERT_EQ(test_gattc_searches().size(), 1u);
+    hub.search_complete(1);
+    EXPECT_EQ(hub.ble_state(), BleState::Ready);
+
+    hub.notify_registered(0x0013);
+    hub.notify_registered(0x0014);
+    ASSERT_EQ(test_gattc_descr_writes().size(), 2u);
+    EXPECT_EQ(test_gattc_descr_writes()[0].second, 0x0014);
+    EXPECT_EQ(test_gattc_descr_writes()[1].second, 0x0015);
+
+    const GattCacheEntry *e = hub.cache().find(BRIDGE_BDA);
+    ASSERT_NE(e, nullptr);
+    EXPECT_EQ(e->char_low, 0x0013);
+    EXPECT_EQ(e->char_high, 0x0014);
+    EXPECT_EQ(e->cccd_low, 0x0014);
+    EXPECT_EQ(e->cccd_high, 0x0015);
+    EXPECT_EQ(e->rssi, -60);
+}
+
+TEST_F(GattCacheTest, KnownBridgeSkipsScanAndDiscovery) {
+    hub.seed_cache(0x0020, 0x0023);
+    hub.register_gattc();
+    EXPECT_EQ(hub.ble_state(), BleState::Connecting) << "no scan";
+    ASSERT_EQ(test_gattc_opens().size(), 1u);
+    EXPECT_EQ(test_gattc_opens()[0].bda[5], 0xA0);
+
+    esphome::set_test_millis(1150);
+    hub.open(1);
+    EXPECT_TRUE(test_gattc_searches().empty());
+    hub.notify_registered(0x0020);
+    hub.notify_registered(0x0023);
+    ASSERT_EQ(test_gattc_descr_writes().size(), 2u);
+    EXPECT_EQ(test_gattc_descr_writes()[0].second, 0x0021);
+    EXPECT_EQ(test_gattc_descr_writes()[1].second, 0x0024);
+
+    // Ready only once notifications are confirmed on the remote side
+    hub.descr_written(1);
+    EXPECT_NE(hub.ble_state(), BleState::Ready);
+    esphome::set_test_millis(1200);
+    hub.descr_written(1);
+    EXPECT_EQ(hub.ble_state(), BleState::Ready);
+
+    std::string stats = hub.stats();
+    EXPECT_NE(stats.find("\"boot_to_ready_ms\":1200"), std::string::npos) << stats;
+    EXPECT_NE(stats.find("\"last_connect_ms\":200,\"last_connect_cached\":true"), std::string::npos);
+    EXPECT_NE(stats.find("\"cache_hits\":1,\"cache_misses\":0"), std::string::npos);
+}
+
+TEST_F(GattCacheTest, FailedCachedHandleFallsBackToDiscovery) {
+    hub.seed_cache(0x0020, 0x0023);
+    hub.register_gattc();
+    hub.open(1);
+    hub.notify_registered(0x0020);
+    hub.descr_written(1, 1);
+
+    EXPECT_EQ(hub.cache().find(BRIDGE_BDA), nullptr);
+    ASSERT_EQ(test_gattc_searches().size(), 1u);
+    EXPECT_NE(hub.ble_state(), BleState::Ready);
+
+    hub.search_complete(1);
+    EXPECT_EQ(hub.ble_state(), BleState::Ready);
+    EXPECT_NE(hub.stats().find("\"cache_fallbacks\":1"), std::string::npos);
+}
+
+TEST_F(GattCacheTest, RejectedCachedWriteRediscoversOnSameLink) {
+    hub.seed_cache(0x0020, 0x0023);
+    hub.register_gattc();
+    hub.open(1);
+    hub.descr_written(1);
+    hub.descr_written(1);
+    ASSERT_EQ(hub.ble_state(), BleState::Ready);
+    ASSERT_TRUE(test_gattc_searches().empty());
+
+    // The bridge firmware moved its characteristics since the cache was saved
+    hub.char_written(1, ESP_GATT_INVALID_HANDLE);
+    EXPECT_EQ(hub.cache().find(BRIDGE_BDA), nullptr);
+    ASSERT_EQ(test_gattc_searches().size(), 1u);
+    EXPECT_EQ(test_gattc_searches().back(), 1);
+    EXPECT_NE(hub.ble_state(), BleState::Ready);
+    EXPECT_FALSE(hub.bridge(0).ready());
+
+    hub.search_complete(1);
+    EXPECT_EQ(hub.ble_state(), BleState::Ready);
+    EXPECT_TRUE(hub.bridge(0).ready());
+    EXPECT_EQ(hub.bridge(0).conn_id(), 1);
+    EXPECT_EQ(test_gattc_opens().size(), 1u);
+    EXPECT_NE(hub.stats().find("\"cache_fallbacks\":1"), std::string::npos);
+}
+
+TEST_F(GattCacheTest, ReconnectToReadyIsMeasured) {
+    hub.seed_cache(0x0020, 0x0023);
+    hub.register_gattc();
+    hub.open(1);
+    hub.descr_written(1);
+    hub.descr_written(1);
+    ASSERT_EQ(hub.ble_state(), BleState::Ready);
+
+    // The only bridge drops: the table is exhausted so it is found by a rescan
+    esphome::set_test_millis(10000);
+    hub.disconnect(1);
+    EXPECT_EQ(hub.ble_state(), BleState::Scanning);
+    esphome::set_test_millis(15000);
+    hub.scan_one(-62);
+    hub.open(2);
+    hub.descr_written(2);
+    esphome::set_test_millis(15100);
+    hub.descr_written(2);
+    ASSERT_EQ(hub.ble_state(), BleState::Ready);
+    EXPECT_NE(hub.stats().find("\"reconnect_to_ready_ms\":5100"), std::string::npos) << hub.stats();
+}
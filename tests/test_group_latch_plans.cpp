@@ -0,0 +1,89 @@
+// Tests: GroupLatch precomputation — devices with the same groups share a
+// plan, level counters follow reports, and plans are rebuilt only when
+// membership changes.
+
+#include "group_latch.h"
+#include <gtest/gtest.h>
+#include <map>
+
+using namespace avionmesh;
+
+static constexpr uint16_t A = 32900;
+static constexpr uint16_t B = 32901;
+static constexpr uint16_t C = 32902;
+static constexpr uint16_t D = 32903;
+static constexpr uint16_t G1 = 1000;
+static constexpr uint16_t G2 = 1001;
+static constexpr uint16_t G3 = 1002;
+
+class GroupLatchPlanTest : public ::testing::Test {
+protected:
+    DeviceDB db;
+    GroupLatch latch;
+    std::map<uint16_t, int> levels;
+
+    void SetUp() override {
+        for (uint16_t id : {A, B, C, D})
+            db.add_device(id, 90, "L");
+        for (uint16_t g : {G1, G2, G3})
+            db.add_group(g, "G");
+        // G1 = {A, B}, G2 = {A, C}, G3 = {A, B, C, D}
+        db.add_device_to_group(A, G1);
+        db.add_device_to_group(B, G1);
+        db.add_device_to_group(A, G2);
+        db.add_device_to_group(C, G2);
+        for (uint16_t id : {A, B, C, D})
+            db.add_device_to_group(id, G3);
+        latch.set_level_fn([this](uint16_t id) {
+            auto it = levels.find(id);
+            return it != levels.end() ? it->second : -1;
+        });
+    }
+
+    void report(uint16_t id, int level) {
+        levels[id] = level;
+        latch.on_level(db, id);
+    }
+
+    std::vector<uint16_t> decide(uint16_t id) {
+        SlotBitset out;
+        latch.decide(db, id, static_cast<uint8_t>(levels[id]), out);
+        std::vector<uint16_t> groups;
+        out.for_each([&](size_t g) { groups.push_back(db.group_at(g)); });
+        return groups;
+    }
+};
+
+TEST_F(GroupLatchPlanTest, WitnessCountersFollowLevels) {
+    // A is in every group: no exclusive member of G1 or G2 has reported
+    report(A, 100);
+    EXPECT_TRUE(decide(A).empty());
+    // D is exclusive to G3 within A's groups, so G3 and everything inside it latch
+    report(D, 100);
+    EXPECT_EQ(decide(A), (std::vector<uint16_t>{G1, G2, G3}));
+
+    // D moves away: its old level no longer counts
+    report(D, 30);
+    EXPECT_TRUE(decide(A).empty());
+    // B's own plan is {G1, G3}; D is exclusive to G3 there too
+    report(B, 30);
+    EXPECT_EQ(decide(B), (std::vector<uint16_t>{G1, G2, G3}));
+}
+
+TEST_F(GroupLatchPlanTest, PlansSharedAndRebuiltOnMembershipChange) {
+    report(A, 50);
+    decide(A);
+    // Plans: {G1,G2,G3} for A, {G1,G3} for B, {G2,G3} for C, {G3} for D
+    EXPECT_EQ(latch.plans(), 4u);
+    EXPECT_NE(latch.stats_json().find("\"plans\":4,\"rebuilds\":1,"), std::string::npos) << latch.stats_json();
+
+    report(C, 50);
+    decide(A);
+    EXPECT_NE(latch.stats_json().find("\"rebuilds\":1,"), std::string::npos) << "levels alone never rebuild";
+
+    // C joins G1 as well: C now shares A's plan, and G2 has no exclusive member
+    db.add_device_to_group(C, G1);
+    EXPECT_TRUE(decide(A).empty());
+    EXPECT_EQ(latch.plans(), 3u);
+    EXPECT_NE(latch.stats_json().find("\"rebuilds\":2,"), std::string::npos);
+}
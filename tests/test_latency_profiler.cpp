@@ -0,0 +1,152 @@
+// Tests: per-device ping latency profiler — one ping in flight at a time,
+// histogram + loss per device, results over SSE / MQTT, and measured round
+// trips stretching the ack retry timeout.
+
+#include "mock_hub.h"
+#include "esphome/core/component.h"
+#include <gtest/gtest.h>
+
+using namespace avionmesh;
+
+static constexpr uint16_t DEV = 32900;
+static constexpr uint16_t DEV2 = 32901;
+
+class LatencyProfilerTest : public ::testing::Test {
+protected:
+    LatencyProfiler prof;
+    std::vector<Command> sent;
+    int done = 0;
+
+    void SetUp() override {
+        prof.set_send_fn([this](const Command &cmd) { sent.push_back(cmd); });
+        prof.set_done_fn([this]() { done++; });
+    }
+};
+
+TEST_F(LatencyProfilerTest, HistogramBuckets) {
+    DeviceLatency d;
+    for (uint32_t rtt : {50u, 150u, 399u, 400u, 1000u, 5000u})
+        d.add(rtt);
+    EXPECT_EQ(d.hist, (std::array<uint32_t, 6>{1, 1, 1, 1, 1, 1}));
+    EXPECT_EQ(d.min_ms, 50u);
+    EXPECT_EQ(d.max_ms, 5000u);
+    EXPECT_EQ(d.avg_ms(), 1166u);
+}
+
+TEST_F(LatencyProfilerTest, PingsOneDeviceAtATime) {
+    ASSERT_TRUE(prof.start({DEV, DEV2}, 2, 0));
+    EXPECT_FALSE(prof.start({DEV}, 1, 0)) << "busy";
+
+    prof.poll(0);
+    prof.poll(10);
+    ASSERT_EQ(sent.size(), 1u);
+    EXPECT_EQ(sent[0].dest_id, DEV);
+    EXPECT_EQ(sent[0].payload[0], static_cast<uint8_t>(Verb::Ping));
+
+    // Clock starts when the scheduler puts the ping on air
+    prof.on_dispatch(sent[0], 100);
+    prof.on_reply(DEV2, 150);
+    prof.on_reply(DEV, 280);
+    prof.poll(300);
+    EXPECT_EQ(sent.size(), 1u) << "gap between pings";
+
+    prof.poll(280 + LatencyProfiler::PING_GAP_MS);
+    ASSERT_EQ(sent.size(), 2u);
+    EXPECT_EQ(sent[1].dest_id, DEV2) << "rounds are interleaved";
+
+    ASSERT_NE(prof.find(DEV), nullptr);
+    EXPECT_EQ(prof.find(DEV)->last_ms, 180u);
+    EXPECT_EQ(prof.find(DEV2), nullptr);
+}
+
+TEST_F(LatencyProfilerTest, SilentDeviceCountsAsLost) {
+    prof.start({DEV}, 2, 0);
+    uint32_t t = 0;
+    for (; t < 10000 && prof.running(); t += 50)
+        prof.poll(t);
+    EXPECT_FALSE(prof.running());
+    EXPECT_EQ(done, 1);
+    EXPECT_EQ(sent.size(), 2u);
+    EXPECT_EQ(prof.find(DEV)->lost, 2u);
+    EXPECT_EQ(prof.find(DEV)->samples, 0u);
+    EXPECT_EQ(prof.ack_timeout_ms(DEV), 0u);
+}
+
+TEST_F(LatencyProfilerTest, AckTimeoutFromSlowestRoundTrip) {
+    prof.start({DEV}, 1, 0);
+    prof.poll(0);
+    prof.on_reply(DEV, 900);
+    EXPECT_EQ(done, 1);
+    EXPECT_EQ(prof.ack_timeout_ms(DEV), 1800u);
+    EXPECT_EQ(prof.ack_timeout_ms(DEV2), 0u);
+    EXPECT_EQ(prof.device_json(DEV),
+              "{\"avion_id\":32900,\"samples\":1,\"lost\":0,\"min_ms\":900,\"avg_ms\":900,"
+              "\"max_ms\":900,\"last_ms\":900,\"hist\":[0,0,0,0,1,0]}");
+}
+
+// --- Hub wiring ---
+
+class ProfileHubTest : public ::testing::Test {
+protected:
+    TestHub hub;
+
+    void SetUp() override {
+        hub.setup_light(DEV, 93, "Light 1");
+        hub.db().add_device(DEV2, 93, "Light 2");
+        hub.clear_captures();
+    }
+
+    void ping_reply(uint16_t device_id) {
+        const uint8_t payload[] = {0x0A, 0x00, 0x00, 0x01, 0x02, 0x03, 0x00, 0x00, 0x01, 0x5D};
+        hub.rx(device_id, payload, sizeof(payload));
+    }
+
+    void tick_until(uint32_t end) {
+        for (uint32_t t = esphome::millis(); t <= end; t += 10) {
+            esphome::set_test_millis(t);
+            hub.loop();
+        }
+    }
+
+    bool responded(const std::string &needle) {
+        for (auto &p : hub.mqtt_publishes)
+            if (std::get<1>(p).find(needle) != std::string::npos)
+                return true;
+        return false;
+    }
+};
+
+TEST_F(ProfileHubTest, ProfilesEveryDeviceAndPublishesResults) {
+    hub.command("{\"action\":\"profile_latency\",\"rounds\":1}");
+    EXPECT_TRUE(responded("\"status\":\"started\",\"devices\":2,\"rounds\":1"));
+
+    tick_until(1200);
+    ASSERT_EQ(hub.mesh_sends.size(), 1u);
+    EXPECT_EQ(hub.mesh_sends[0].dest_id, DEV);
+    ping_reply(DEV);
+
+    tick_until(1600);
+    ASSERT_EQ(hub.mesh_sends.size(), 2u);
+    EXPECT_EQ(hub.mesh_sends[1].dest_id, DEV2);
+    ping_reply(DEV2);
+
+    ASSERT_FALSE(hub.sse_events.empty());
+    EXPECT_EQ(hub.sse_events.back().first, "latency");
+    EXPECT_NE(hub.sse_events.back().second.find("\"avion_id\":32901,\"samples\":1"), std::string::npos);
+    EXPECT_TRUE(responded("\"action\":\"profile_latency\",\"status\":\"done\""));
+}
+
+TEST_F(ProfileHubTest, SlowDeviceGetsLongerAckTimeout) {
+    hub.command("{\"action\":\"profile_latency\",\"avion_id\":32900,\"rounds\":1}");
+    tick_until(1200);
+    esphome::set_test_millis(2500);
+    ping_reply(DEV);
+    hub.clear_captures();
+
+    // Measured round trip is ~1.4 s, so no retry at the default 800 ms
+    hub.inject_mqtt("avionmesh/light/" + std::to_string(DEV) + "/set", "OFF");
+    ASSERT_EQ(hub.mesh_sends.size(), 1u);
+    tick_until(2500 + AckTracker::ACK_TIMEOUT_MS * 2);
+    EXPECT_EQ(hub.mesh_sends.size(), 1u);
+    EXPECT_EQ(hub.acks().stats().retries, 0u);
+}
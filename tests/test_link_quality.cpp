@@ -0,0 +1,150 @@
+// Tests: bridge link-quality scoring (RSSI, write failures, notify liveness,
+// ack latency) and roaming to a clearly better bridge while the mesh is idle.
+
+#include "mock_hub.h"
+#include "esphome/core/component.h"
+#include <gtest/gtest.h>
+
+using namespace avionmesh;
+
+static const uint8_t BDA[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+class LinkQualityTest : public ::testing::Test {
+protected:
+    BridgeConnection br;
+
+    void SetUp() override {
+        br.begin_connect(BDA, -60, 0);
+        br.on_open(4, 1);
+        br.set_handles(0x13, 0x14);
+        br.set_ready(0);
+    }
+};
+
+TEST_F(LinkQualityTest, ScoreFollowsRssi) {
+    EXPECT_EQ(br.score(), 75u);
+    EXPECT_EQ(BridgeConnection::rssi_score(-95.0f), 0u);
+    EXPECT_EQ(BridgeConnection::rssi_score(-40.0f), 100u);
+
+    for (int i = 0; i < 20; i++)
+        br.on_rssi(-80);
+    EXPECT_EQ(br.score(), 25u);
+}
+
+TEST_F(LinkQualityTest, WriteFailuresLowerScore) {
+    uint8_t frag[4] = {};
+    for (int i = 0; i < 10; i++) {
+        br.write(csrmesh::Characteristic::Low, frag, sizeof(frag), true, 0);
+        br.on_write_complete(static_cast<esp_gatt_status_t>(1), 0);
+    }
+    EXPECT_LT(br.score(), 40u);
+}
+
+TEST_F(LinkQualityTest, SilentBusyWindowsLowerLiveness) {
+    uint8_t frag[4] = {};
+    uint32_t now = 0;
+    for (int w = 0; w < 3; w++) {
+        br.write(csrmesh::Characteristic::Low, frag, sizeof(frag), false, now);
+        now += 10000;
+        br.update_quality(now);
+    }
+    EXPECT_LT(br.score(), 30u);
+
+    // An idle window says nothing; a window with notifies restores liveness
+    now += 10000;
+    br.update_quality(now);
+    uint8_t idle_score = br.score();
+    br.write(csrmesh::Characteristic::Low, frag, sizeof(frag), false, now);
+    br.on_notify();
+    now += 10000;
+    br.update_quality(now);
+    EXPECT_GT(br.score(), idle_score);
+}
+
+TEST_F(LinkQualityTest, SlowAcksLowerScore) {
+    br.on_ack_latency(200);
+    EXPECT_EQ(br.score(), 75u);
+    br.on_ack_latency(1300);
+    br.on_ack_latency(1300);
+    EXPECT_LT(br.score(), 75u);
+    EXPECT_GE(br.score(), 37u) << "penalty is capped at half";
+}
+
+class RoamTest : public ::testing::Test {
+protected:
+    TestHub hub;
+
+    void SetUp() override {
+        esphome::set_test_millis(1000);
+        test_gattc_opens().clear();
+        test_rssi_reads().clear();
+        hub.test_setup();
+        hub.set_max_bridges(1);
+    }
+
+    // One weak bridge up and settled past the dwell time
+    void connect_weak(int rssi) {
+        hub.register_gattc();
+        hub.scan({rssi});
+        hub.open_last(1);
+        ASSERT_EQ(hub.ble_state(), BleState::Ready);
+    }
+
+    void tick(uint32_t t) {
+        esphome::set_test_millis(t);
+        hub.loop();
+    }
+};
+
+TEST_F(RoamTest, RssiIsPolledAndApplied) {
+    hub.bring_up_bridge(0, 1);
+    tick(7000);
+    ASSERT_EQ(test_rssi_reads().size(), 1u);
+    tick(9000);
+    EXPECT_EQ(test_rssi_reads().size(), 1u) << "poll interval not yet elapsed";
+
+    hub.rssi_report(0, -80);
+    EXPECT_EQ(hub.bridge(0).rssi(), -80);
+    EXPECT_LT(hub.bridge(0).score(), 75u);
+}
+
+TEST_F(RoamTest, RoamsToClearlyBetterBridgeWhenIdle) {
+    connect_weak(-85);
+    tick(200000);
+    ASSERT_NE(hub.stats().find("\"roam\":{\"scans\":1,"), std::string::npos) << "background scan";
+    EXPECT_EQ(hub.ble_state(), BleState::Ready) << "existing link keeps serving";
+
+    // The connected bridge plus a much stronger one
+    hub.scan({-85, -50});
+    ASSERT_EQ(test_gattc_opens().size(), 2u);
+    EXPECT_EQ(test_gattc_opens()[1].bda[5], 0xA1);
+
+    // Make before break: the old link is released once the new one is up
+    hub.open_last(2);
+    hub.disconnect(1);
+    EXPECT_EQ(hub.ble_state(), BleState::Ready);
+    std::string stats = hub.stats();
+    EXPECT_NE(stats.find("\"roam\":{\"scans\":1,\"roams\":1}"), std::string::npos) << stats;
+    EXPECT_NE(stats.find("\"failover\":{\"count\":0"), std::string::npos) << "not a failover";
+}
+
+TEST_F(RoamTest, SmallImprovementDoesNotRoam) {
+    connect_weak(-70);
+    tick(200000);
+    hub.scan({-70, -65});
+    EXPECT_EQ(test_gattc_opens().size(), 1u);
+    EXPECT_NE(hub.stats().find("\"roams\":0"), std::string::npos);
+}
+
+TEST_F(RoamTest, InteractiveTrafficDefersBackgroundScan) {
+    connect_weak(-85);
+    esphome::set_test_millis(195000);
+    Command cmd;
+    cmd_brightness(32900, 100, cmd);
+    hub.queue(cmd, TxClass::Interactive);
+    tick(200000);
+    EXPECT_NE(hub.stats().find("\"roam\":{\"scans\":0,"), std::string::npos);
+
+    tick(210000);
+    EXPECT_NE(hub.stats().find("\"roam\":{\"scans\":1,"), std::string::npos);
+}
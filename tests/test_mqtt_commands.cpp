@@ -135,3 +135,301 @@ TEST_F(MqttCommandTest, RapidDim_SecondCallOutsideWindow_SendsToBle) {
 
     EXPECT_EQ(hub.mesh_sends.size(), 2u) << "non-rapid dim should send both commands";
 }
+
+TEST_F(MqttCommandTest, RapidDim_FinalValueSentWhenWindowExpires) {
+    const std::string topic = PREFIX + "/light/" + std::to_string(DEV) + "/brightness/set";
+    esphome::set_test_millis(1000);
+    hub.inject_mqtt(topic, "100");
+    esphome::set_test_millis(1100);
+    hub.inject_mqtt(topic, "80");
+    esphome::set_test_millis(1200);
+    hub.inject_mqtt(topic, "60");
+    ASSERT_EQ(hub.mesh_sends.size(), 1u);
+
+    // Window still open — nothing flushed yet
+    esphome::set_test_millis(1700);
+    hub.loop();
+    ASSERT_EQ(hub.mesh_sends.size(), 1u);
+
+    esphome::set_test_millis(1750);
+    hub.loop();
+    ASSERT_EQ(hub.mesh_sends.size(), 2u) << "trailing edge must deliver the final slider value";
+    EXPECT_EQ(hub.mesh_sends[1].payload[5], 60);
+
+    // Nothing pending — later ticks must not resend
+    esphome::set_test_millis(3000);
+    hub.loop();
+    EXPECT_EQ(hub.mesh_sends.size(), 2u);
+}
+
+TEST_F(MqttCommandTest, RapidDim_AtMostOneWritePerWindow) {
+    const std::string topic = PREFIX + "/light/" + std::to_string(DEV) + "/brightness/set";
+    // 3 s drag with a new value every 50 ms, loop ticking in between
+    for (uint32_t t = 1000; t <= 4000; t += 50) {
+        esphome::set_test_millis(t);
+        hub.inject_mqtt(topic, std::to_string((t / 50) % 256));
+        hub.loop();
+    }
+    EXPECT_LE(hub.mesh_sends.size(), 3000u / 750u + 1);
+
+    esphome::set_test_millis(5000);
+    hub.loop();
+    EXPECT_EQ(hub.mesh_sends.back().payload[5], (4000u / 50u) % 256);
+}
+
+TEST_F(MqttCommandTest, RapidDim_OffCancelsPendingValue) {
+    const std::string base = PREFIX + "/light/" + std::to_string(DEV);
+    esphome::set_test_millis(1000);
+    hub.inject_mqtt(base + "/brightness/set", "100");
+    esphome::set_test_millis(1100);
+    hub.inject_mqtt(base + "/brightness/set", "80");
+    esphome::set_test_millis(1200);
+    hub.inject_mqtt(base + "/set", "OFF");
+    ASSERT_EQ(hub.mesh_sends.size(), 2u);
+    EXPECT_EQ(hub.mesh_sends[1].payload[5], 0);
+
+    esphome::set_test_millis(2000);
+    hub.loop();
+    EXPECT_EQ(hub.mesh_sends.size(), 2u) << "stale slider value must not turn the light back on";
+}
+
+TEST_F(MqttCommandTest, RapidDim_GroupAndBroadcastCoalesced) {
+    static constexpr uint16_t GRP = 1024;
+    hub.db().add_group(GRP, "Group");
+    hub.db().find_group(GRP)->mqtt_exposed = true;
+    hub.test_setup();
+
+    esphome::set_test_millis(1000);
+    hub.inject_mqtt(PREFIX + "/light/" + std::to_string(GRP) + "/brightness/set", "10");
+    hub.inject_mqtt(PREFIX + "/light/" + std::to_string(GRP) + "/brightness/set", "20");
+    ASSERT_EQ(hub.mesh_sends.size(), 1u);
+
+    esphome::set_test_millis(2000);
+    hub.loop();
+    ASSERT_EQ(hub.mesh_sends.size(), 2u);
+    EXPECT_EQ(hub.mesh_sends[1].dest_id, GRP);
+    EXPECT_EQ(hub.mesh_sends[1].payload[5], 20);
+}
+
+// --- Unchanged state suppression ---
+
+static size_t count_topic(TestHub &hub, const std::string &topic) {
+    size_t n = 0;
+    for (auto &[t, payload, retain] : hub.mqtt_publishes)
+        if (t == topic)
+            n++;
+    return n;
+}
+
+TEST_F(MqttCommandTest, RepeatedReport_PublishesOnce) {
+    const std::string base = PREFIX + "/light/" + std::to_string(DEV);
+    hub.inject_brightness(DEV, 120);
+    hub.inject_color_temp(DEV, 4000);
+    hub.clear_captures();
+
+    hub.inject_brightness(DEV, 120);
+    hub.inject_color_temp(DEV, 4000);
+    EXPECT_TRUE(hub.mqtt_publishes.empty());
+    EXPECT_NE(hub.stats().find("\"mqtt_state\":{\"published\":3,\"suppressed\":8,"), std::string::npos)
+        << hub.stats();
+
+    hub.inject_brightness(DEV, 90);
+    EXPECT_EQ(count_topic(hub, base + "/brightness/state"), 1u);
+    EXPECT_EQ(count_topic(hub, base + "/state"), 0u) << "still ON";
+}
+
+TEST_F(MqttCommandTest, RefusedStatePublish_SentAgain) {
+    const std::string base = PREFIX + "/light/" + std::to_string(DEV);
+    hub.mqtt_accepting = false;
+    hub.inject_brightness(DEV, 120);
+    EXPECT_TRUE(hub.mqtt_publishes.empty());
+    EXPECT_NE(hub.stats().find("\"suppressed\":0,\"failed\":2,"), std::string::npos) << hub.stats();
+
+    // The same value again is not "unchanged": it never reached the broker
+    hub.mqtt_accepting = true;
+    hub.inject_brightness(DEV, 120);
+    EXPECT_EQ(count_topic(hub, base + "/brightness/state"), 1u);
+    EXPECT_EQ(count_topic(hub, base + "/state"), 1u);
+}
+
+// Reconnect after an outage republishes what was refused meanwhile
+TEST_F(MqttCommandTest, MqttReconnect_RepublishesRefusedState) {
+    const std::string base = PREFIX + "/light/" + std::to_string(DEV);
+    hub.inject_brightness(DEV, 120);
+    hub.mqtt_accepting = false;
+    hub.inject_brightness(DEV, 60);
+    hub.mqtt_accepting = true;
+    hub.clear_captures();
+
+    hub.mqtt_connected();
+    ASSERT_EQ(count_topic(hub, base + "/brightness/state"), 1u);
+    for (auto &[t, payload, retain] : hub.mqtt_publishes)
+        if (t == base + "/brightness/state") {
+            EXPECT_EQ(payload, "60");
+        }
+}
+
+// setup() republishes every known state when HA announces itself online
+TEST_F(MqttCommandTest, HaRestart_ForcesRepublish) {
+    const std::string base = PREFIX + "/light/" + std::to_string(DEV);
+    hub.inject_brightness(DEV, 120);
+    hub.clear_captures();
+
+    hub.republish_states();
+    EXPECT_EQ(count_topic(hub, base + "/state"), 1u);
+    EXPECT_EQ(count_topic(hub, base + "/brightness/state"), 1u);
+}
+
+// --- Topic table ---
+
+TEST(MqttTopicTableTest, BuiltOncePerEntityAndRebuiltOnPrefixChange) {
+    MqttDiscovery discovery;
+    discovery.set_node_name("test");
+    discovery.set_topic_prefix("avionmesh");
+
+    const char *state = discovery.state_topic(DEV);
+    EXPECT_STREQ(state, "avionmesh/light/32900/state");
+    EXPECT_STREQ(discovery.brightness_state_topic(DEV), "avionmesh/light/32900/brightness/state");
+    EXPECT_STREQ(discovery.color_temp_state_topic(DEV), "avionmesh/light/32900/color_temp/state");
+    EXPECT_EQ(discovery.color_temp_command_topic(DEV), "avionmesh/light/32900/color_temp/set");
+    EXPECT_EQ(discovery.discovery_topic(DEV), "homeassistant/light/test_32900/config");
+    discovery.state_topic(DEV + 1);
+    discovery.state_topic(7);
+    EXPECT_STREQ(discovery.color_temp_state_topic(7), "avionmesh/light/7/color_temp/state");
+    EXPECT_EQ(discovery.state_topic(DEV), state) << "publishing reuses the stored topic";
+    EXPECT_EQ(discovery.topic_table_size(), 3u);
+
+    discovery.set_topic_prefix("bridge2");
+    EXPECT_EQ(discovery.topic_table_size(), 0u);
+    EXPECT_STREQ(discovery.state_topic(DEV), "bridge2/light/32900/state");
+    EXPECT_EQ(discovery.management_response_topic(), "bridge2/avionmesh/response");
+
+    discovery.remove_light(DEV);
+    EXPECT_EQ(discovery.topic_table_size(), 0u);
+}
+
+// --- Wildcard command dispatch ---
+
+TEST(MqttTopicTableTest, ParseCommandTopic) {
+    MqttDiscovery discovery;
+    discovery.set_topic_prefix("avionmesh");
+    uint16_t id = 0;
+    LightCommand cmd;
+
+    ASSERT_TRUE(discovery.parse_command_topic("avionmesh/light/32900/set", id, cmd));
+    EXPECT_EQ(id, DEV);
+    EXPECT_EQ(cmd, LightCommand::Switch);
+    ASSERT_TRUE(discovery.parse_command_topic("avionmesh/light/0/brightness/set", id, cmd));
+    EXPECT_EQ(id, 0u);
+    EXPECT_EQ(cmd, LightCommand::Brightness);
+    ASSERT_TRUE(discovery.parse_command_topic("avionmesh/light/65535/color_temp/set", id, cmd));
+    EXPECT_EQ(cmd, LightCommand::ColorTemp);
+
+    EXPECT_FALSE(discovery.parse_command_topic("avionmesh/light/32900/state", id, cmd));
+    EXPECT_FALSE(discovery.parse_command_topic("avionmesh/light/32900/brightness/state", id, cmd));
+    EXPECT_FALSE(discovery.parse_command_topic("avionmesh/light/65536/set", id, cmd));
+    EXPECT_FALSE(discovery.parse_command_topic("avionmesh/light//set", id, cmd));
+    EXPECT_FALSE(discovery.parse_command_topic("avionmesh/light/12x/set", id, cmd));
+    EXPECT_FALSE(discovery.parse_command_topic("other/light/32900/set", id, cmd));
+}
+
+TEST_F(MqttCommandTest, WildcardSubscriptionsOnly) {
+    EXPECT_EQ(hub.mqtt_subs.size(), 2u);
+    EXPECT_EQ(hub.mqtt_subs.count(PREFIX + "/light/+/set"), 1u);
+    EXPECT_EQ(hub.mqtt_subs.count(PREFIX + "/light/+/+/set"), 1u);
+}
+
+TEST_F(MqttCommandTest, UnexposedIdsIgnored) {
+    static constexpr uint16_t DEV2 = 32901;
+    hub.db().add_device(DEV2, 93, "Hidden Light");
+    hub.inject_mqtt(PREFIX + "/light/" + std::to_string(DEV2) + "/brightness/set", "128");
+    hub.inject_mqtt(PREFIX + "/light/0/set", "ON");
+    hub.inject_mqtt(PREFIX + "/light/4242/set", "ON");
+    EXPECT_TRUE(hub.mesh_sends.empty());
+    EXPECT_NE(hub.stats().find("\"commands_ignored\":3"), std::string::npos) << hub.stats();
+
+    // Un-exposing stops command handling without unsubscribing
+    hub.db().find_device(DEV)->mqtt_exposed = false;
+    hub.inject_mqtt(PREFIX + "/light/" + std::to_string(DEV) + "/set", "ON");
+    EXPECT_TRUE(hub.mesh_sends.empty());
+}
+
+// --- Paced discovery ---
+
+static std::vector<std::string> light_configs(const TestHub &hub) {
+    std::vector<std::string> out;
+    for (auto &[topic, payload, retain] : hub.mqtt_publishes)
+        if (topic.rfind("homeassistant/light/", 0) == 0)
+            out.push_back(topic);
+    return out;
+}
+
+TEST(PacedDiscoveryTest, BoundedPerTickWithProgress) {
+    esphome::set_test_millis(1000);
+    TestHub hub;
+    for (uint16_t i = 0; i < 10; i++) {
+        hub.db().add_device(DEV + i, 93, "Light");
+        hub.db().find_device(DEV + i)->mqtt_exposed = true;
+    }
+    hub.test_setup();
+
+    hub.announce();
+    EXPECT_TRUE(light_configs(hub).empty()) << "nothing is sent until the next tick";
+    hub.pump(1000);
+    EXPECT_EQ(light_configs(hub).size(), TestHub::DISCOVERY_PER_TICK);
+    hub.pump(1010);
+    hub.pump(1020);
+    hub.pump(1030);
+    ASSERT_EQ(light_configs(hub).size(), 10u);
+    EXPECT_EQ(light_configs(hub).back(), "homeassistant/light/test_32909/config");
+
+    ASSERT_FALSE(hub.sse_events.empty());
+    EXPECT_EQ(hub.sse_events.front().second, "{\"done\":0,\"total\":10,\"backpressure\":0}");
+    EXPECT_EQ(hub.sse_events.back().first, "discovery_progress");
+    EXPECT_EQ(hub.sse_events.back().second, "{\"done\":10,\"total\":10,\"backpressure\":0}");
+}
+
+TEST(PacedDiscoveryTest, BacksOffAndResumesWhenClientRefuses) {
+    esphome::set_test_millis(1000);
+    TestHub hub;
+    for (uint16_t i = 0; i < 6; i++) {
+        hub.db().add_device(DEV + i, 93, "Light");
+        hub.db().find_device(DEV + i)->mqtt_exposed = true;
+    }
+    hub.test_setup();
+    hub.announce();
+    hub.pump(1000);
+    ASSERT_EQ(light_configs(hub).size(), 4u);
+
+    hub.mqtt_accepting = false;
+    hub.pump(1010);
+    hub.mqtt_accepting = true;
+    hub.pump(1010 + TestHub::DISCOVERY_BACKOFF_MS - 1);
+    EXPECT_EQ(light_configs(hub).size(), 4u) << "waits for the outbox to drain";
+
+    hub.pump(1010 + TestHub::DISCOVERY_BACKOFF_MS);
+    auto configs = light_configs(hub);
+    ASSERT_EQ(configs.size(), 6u);
+    EXPECT_EQ(configs[4], "homeassistant/light/test_32904/config") << "resumes with the refused entity";
+
+    std::string stats = hub.stats();
+    EXPECT_NE(stats.find("\"discovery\":{\"runs\":1,\"done\":6,\"total\":6,\"pending\":0,\"backpressure\":1,"),
+              std::string::npos)
+        << stats;
+}
+
+TEST(PacedDiscoveryTest, UnexposedWhileQueuedIsSkipped) {
+    esphome::set_test_millis(1000);
+    TestHub hub;
+    hub.db().add_device(DEV, 93, "A");
+    hub.db().add_device(DEV + 1, 93, "B");
+    hub.db().find_device(DEV)->mqtt_exposed = true;
+    hub.db().find_device(DEV + 1)->mqtt_exposed = true;
+    hub.test_setup();
+    hub.announce();
+    hub.db().find_device(DEV)->mqtt_exposed = false;
+    hub.pump(1000);
+    auto configs = light_configs(hub);
+    ASSERT_EQ(configs.size(), 1u);
+    EXPECT_EQ(configs[0], "homeassistant/light/test_32901/config");
+}
@@ -0,0 +1,114 @@
+// Tests: HA JSON schema mode — one state / command topic per light, combined
+// commands parsed as one unit, and a single JSON state publish.
+
+#include "mock_hub.h"
+#include "esphome/core/component.h"
+#include <gtest/gtest.h>
+
+using namespace avionmesh;
+
+static constexpr uint16_t DEV = 32900;
+static const std::string PREFIX = "avionmesh";
+static const std::string BASE = PREFIX + "/light/" + std::to_string(DEV);
+
+class MqttJsonTest : public ::testing::Test {
+protected:
+    TestHub hub;
+
+    void SetUp() override {
+        hub.discovery().set_json_schema(true);
+        hub.setup_light(DEV, 93 /* dimming + color temp */, "Test Light", false);
+    }
+
+    std::vector<std::string> published(const std::string &topic) {
+        std::vector<std::string> out;
+        for (auto &[t, payload, retain] : hub.mqtt_publishes)
+            if (t == topic)
+                out.push_back(payload);
+        return out;
+    }
+};
+
+TEST_F(MqttJsonTest, OnlyOneCommandTopicSubscribed) {
+    EXPECT_EQ(hub.mqtt_subs.count("avionmesh/light/+/set"), 1u);
+    EXPECT_EQ(hub.mqtt_subs.size(), 1u);
+    hub.inject_mqtt(BASE + "/brightness/set", "100");
+    hub.inject_mqtt(BASE + "/color_temp/set", "250");
+    EXPECT_TRUE(hub.mesh_sends.empty());
+}
+
+TEST_F(MqttJsonTest, DiscoveryUsesJsonSchema) {
+    hub.announce();
+    hub.pump(esphome::millis());
+    auto configs = published("homeassistant/light/test_32900/config");
+    ASSERT_EQ(configs.size(), 1u);
+    EXPECT_NE(configs[0].find("\"schema\":\"json\""), std::string::npos);
+    EXPECT_NE(configs[0].find("\"brightness\":true"), std::string::npos);
+    EXPECT_NE(configs[0].find("\"supported_color_modes\":[\"color_temp\"]"), std::string::npos);
+    EXPECT_EQ(configs[0].find("brightness_command_topic"), std::string::npos);
+    EXPECT_EQ(configs[0].find("color_temp_state_topic"), std::string::npos);
+}
+
+TEST_F(MqttJsonTest, OnWithBrightnessIsOneWrite) {
+    hub.inject_mqtt(BASE + "/set", "{\"state\":\"ON\",\"brightness\":100}");
+    ASSERT_EQ(hub.mesh_sends.size(), 1u);
+    EXPECT_EQ(hub.mesh_sends[0].payload[5], 100);
+
+    auto states = published(BASE + "/state");
+    ASSERT_EQ(states.size(), 1u);
+    EXPECT_EQ(states[0], "{\"state\":\"ON\",\"brightness\":100}");
+    EXPECT_TRUE(published(BASE + "/brightness/state").empty());
+}
+
+TEST_F(MqttJsonTest, ColorTempChangeOnLitLightIsOneWrite) {
+    hub.inject_brightness(DEV, 120);
+    hub.clear_captures();
+    // HA sends "ON" along with every color temp change
+    hub.inject_mqtt(BASE + "/set", "{\"state\":\"ON\",\"color_temp\":250}");
+    ASSERT_EQ(hub.mesh_sends.size(), 1u);
+    Command expect;
+    cmd_color_temp(DEV, 4000, expect);
+    EXPECT_EQ(std::memcmp(hub.mesh_sends[0].payload, expect.payload, sizeof(expect.payload)), 0);
+    EXPECT_EQ(hub.states().at(DEV).brightness, 120);
+}
+
+TEST_F(MqttJsonTest, OnWithColorTempRestoresLevelWhenOff) {
+    hub.inject_brightness(DEV, 0);
+    hub.clear_captures();
+    hub.inject_mqtt(BASE + "/set", "{\"state\":\"ON\",\"color_temp\":250}");
+    EXPECT_EQ(hub.mesh_sends.size(), 2u) << "brightness restore, then color temp";
+    EXPECT_EQ(hub.states().at(DEV).brightness, 255);
+}
+
+TEST_F(MqttJsonTest, CombinedBrightnessAndColorTemp) {
+    hub.inject_mqtt(BASE + "/set", "{\"state\":\"ON\",\"brightness\":50,\"color_temp\":250,\"transition\":2}");
+    ASSERT_EQ(hub.mesh_sends.size(), 2u);
+    EXPECT_EQ(hub.mesh_sends[0].payload[1], 0x0A);
+    EXPECT_EQ(hub.mesh_sends[1].payload[1], 0x1D);
+
+    auto states = published(BASE + "/state");
+    ASSERT_EQ(states.size(), 1u);
+    EXPECT_EQ(states[0], "{\"state\":\"ON\",\"brightness\":50,\"color_mode\":\"color_temp\",\"color_temp\":250}");
+}
+
+TEST_F(MqttJsonTest, OffAndOnRestoreLevel) {
+    hub.inject_brightness(DEV, 80);
+    hub.clear_captures();
+
+    hub.inject_mqtt(BASE + "/set", "{\"state\":\"OFF\"}");
+    ASSERT_EQ(hub.mesh_sends.size(), 1u);
+    EXPECT_EQ(hub.mesh_sends[0].payload[5], 0);
+    EXPECT_EQ(published(BASE + "/state").back(), "{\"state\":\"OFF\",\"brightness\":0}");
+
+    // The level is gone once off, so ON without brightness goes to full
+    hub.inject_mqtt(BASE + "/set", "{\"state\":\"ON\"}");
+    ASSERT_EQ(hub.mesh_sends.size(), 2u);
+    EXPECT_EQ(hub.mesh_sends[1].payload[5], 255);
+}
+
+TEST_F(MqttJsonTest, UnchangedReportNotRepublished) {
+    hub.inject_brightness(DEV, 120);
+    hub.clear_captures();
+    hub.inject_brightness(DEV, 120);
+    EXPECT_TRUE(hub.mqtt_publishes.empty());
+}
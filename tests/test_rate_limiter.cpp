@@ -0,0 +1,146 @@
+// Tests: per-target / per-ingress token buckets — bursts pass, excess writes
+// collapse into the latest pending value, and overload is attributed.
+
+#include "mock_hub.h"
+#include "rate_limiter.h"
+#include "esphome/core/component.h"
+#include <gtest/gtest.h>
+
+using namespace avionmesh;
+
+static constexpr uint16_t DEV = 32900;
+static constexpr uint16_t DEV2 = 32901;
+static constexpr uint16_t DEV3 = 32902;
+
+class RateLimiterTest : public ::testing::Test {
+protected:
+    RateLimiter limiter;
+    struct Sent {
+        uint16_t target;
+        AckAttr attr;
+        uint16_t value;
+        TxSource source;
+    };
+    std::vector<Sent> sent;
+
+    void SetUp() override {
+        limiter.set_send_fn([this](uint16_t target, AckAttr attr, uint16_t value, TxSource source) {
+            sent.push_back({target, attr, value, source});
+        });
+        limiter.set_target_rate(2.0f, 3.0f);
+        limiter.set_ingress_rate(0.0f, 0.0f);
+    }
+};
+
+TEST_F(RateLimiterTest, BurstPassesThenLatestValueWins) {
+    for (uint16_t v = 1; v <= 3; v++)
+        EXPECT_TRUE(limiter.admit(DEV, AckAttr::Brightness, v, TxSource::Mqtt, 1000));
+    EXPECT_FALSE(limiter.admit(DEV, AckAttr::Brightness, 4, TxSource::Mqtt, 1000));
+    EXPECT_FALSE(limiter.admit(DEV, AckAttr::Brightness, 5, TxSource::Mqtt, 1000));
+    EXPECT_EQ(limiter.pending(), 1u);
+    EXPECT_EQ(limiter.absorbed(DEV), 2u);
+
+    limiter.poll(1400);
+    EXPECT_TRUE(sent.empty()) << "0.8 tokens after 400 ms at 2/s";
+    limiter.poll(1500);
+    ASSERT_EQ(sent.size(), 1u);
+    EXPECT_EQ(sent[0].value, 5u);
+    EXPECT_EQ(sent[0].source, TxSource::Mqtt);
+    EXPECT_EQ(limiter.pending(), 0u);
+}
+
+TEST_F(RateLimiterTest, PendingWriteKeepsItsPlace) {
+    for (uint16_t v = 1; v <= 4; v++)
+        limiter.admit(DEV, AckAttr::ColorTemp, 3000 + v, TxSource::Web, 1000);
+    // A token is back, but the waiting write goes first and takes the new value
+    EXPECT_FALSE(limiter.admit(DEV, AckAttr::ColorTemp, 4000, TxSource::Web, 1600));
+    limiter.poll(1600);
+    ASSERT_EQ(sent.size(), 1u);
+    EXPECT_EQ(sent[0].attr, AckAttr::ColorTemp);
+    EXPECT_EQ(sent[0].value, 4000u);
+}
+
+TEST_F(RateLimiterTest, IngressBucketSharedAcrossTargets) {
+    limiter.set_ingress_rate(1.0f, 2.0f);
+    EXPECT_TRUE(limiter.admit(DEV, AckAttr::Brightness, 10, TxSource::Management, 1000));
+    EXPECT_TRUE(limiter.admit(DEV2, AckAttr::Brightness, 10, TxSource::Management, 1000));
+    EXPECT_FALSE(limiter.admit(DEV3, AckAttr::Brightness, 10, TxSource::Management, 1000));
+    // Other ingresses and hub-initiated writes have their own budget
+    EXPECT_TRUE(limiter.admit(DEV3, AckAttr::ColorTemp, 3000, TxSource::Mqtt, 1000));
+    EXPECT_TRUE(limiter.admit(DEV2, AckAttr::ColorTemp, 3000, TxSource::Internal, 1000));
+
+    std::string stats = limiter.stats_json();
+    EXPECT_NE(stats.find("\"management\":{\"sent\":2,\"absorbed\":1}"), std::string::npos) << stats;
+}
+
+TEST_F(RateLimiterTest, StatsNameWorstOffenders) {
+    for (int i = 0; i < 6; i++)
+        limiter.admit(DEV, AckAttr::Brightness, i, TxSource::Mqtt, 1000);
+    for (int i = 0; i < 4; i++)
+        limiter.admit(DEV2, AckAttr::Brightness, i, TxSource::Mqtt, 1000);
+    std::string stats = limiter.stats_json();
+    EXPECT_NE(stats.find("\"absorbed\":4,\"sources\""), std::string::npos) << stats;
+    EXPECT_NE(stats.find("\"overloaded\":[{\"target\":32900,\"absorbed\":3,\"last_ms\":1000},"
+                         "{\"target\":32901,\"absorbed\":1,"),
+              std::string::npos)
+        << stats;
+}
+
+TEST_F(RateLimiterTest, ZeroRateDisables) {
+    limiter.set_target_rate(0.0f, 0.0f);
+    for (int i = 0; i < 50; i++)
+        EXPECT_TRUE(limiter.admit(DEV, AckAttr::Brightness, i, TxSource::Mqtt, 1000));
+}
+
+// --- Hub wiring ---
+
+TEST(RateLimiterHubTest, ColorTempStormCollapses) {
+    TestHub hub;
+    hub.setup_light(DEV, 93, "Downlight");
+
+    const std::string topic = "avionmesh/light/" + std::to_string(DEV) + "/color_temp/set";
+    for (int mireds = 200; mireds < 230; mireds++)
+        hub.inject_mqtt(topic, std::to_string(mireds));
+    EXPECT_EQ(hub.mesh_sends.size(), static_cast<size_t>(RateLimiter::DEFAULT_TARGET_BURST));
+
+    esphome::set_test_millis(1200);
+    hub.loop();
+    ASSERT_EQ(hub.mesh_sends.size(), static_cast<size_t>(RateLimiter::DEFAULT_TARGET_BURST) + 1);
+    Command expect;
+    cmd_color_temp(DEV, 1000000u / 229, expect);
+    EXPECT_EQ(std::memcmp(hub.mesh_sends.back().payload, expect.payload, sizeof(expect.payload)), 0)
+        << "only the latest value is sent";
+
+    std::string stats = hub.stats();
+    EXPECT_NE(stats.find("\"overloaded\":[{\"target\":32900,\"absorbed\":20"), std::string::npos) << stats;
+}
+
+TEST(RateLimiterHubTest, SwitchDropsThrottledSliderValue) {
+    TestHub hub;
+    hub.set_target_rate_limit(1.0f, 1.0f);
+    hub.setup_light(DEV, 93, "Downlight");
+
+    const std::string light = "avionmesh/light/" + std::to_string(DEV);
+    hub.inject_mqtt(light + "/brightness/set", "100");
+    esphome::set_test_millis(1800);
+    hub.inject_mqtt(light + "/brightness/set", "150");  // no token: held back
+    ASSERT_EQ(hub.mesh_sends.size(), 1u);
+
+    // OFF replaces the held slider value instead of queueing behind it
+    esphome::set_test_millis(2100);
+    hub.inject_mqtt(light + "/set", "OFF");
+    ASSERT_EQ(hub.mesh_sends.size(), 2u);
+    Command off;
+    cmd_brightness(DEV, 0, off);
+    EXPECT_EQ(std::memcmp(hub.mesh_sends.back().payload, off.payload, sizeof(off.payload)), 0);
+
+    for (uint32_t t = 2100; t <= 5000; t += 100) {
+        esphome::set_test_millis(t);
+        hub.loop();
+    }
+    Command slider;
+    cmd_brightness(DEV, 150, slider);
+    for (auto &sent : hub.mesh_sends)
+        EXPECT_NE(std::memcmp(sent.payload, slider.payload, sizeof(slider.payload)), 0)
+            << "the slider value is never sent";
+}
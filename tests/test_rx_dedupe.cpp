@@ -0,0 +1,69 @@
+// Tests: RX dedupe cache — relayed copies on one link or across links are
+// dropped before any state / MQTT / SSE work, distinct packets are not, and
+// duplicate rates are reported.
+
+#include "mock_hub.h"
+#include "rx_dedupe.h"
+#include "esphome/core/component.h"
+#include <gtest/gtest.h>
+
+using namespace avionmesh;
+
+static constexpr uint16_t DEV = 32900;
+static constexpr uint16_t DEV2 = 32901;
+
+static const uint8_t REPORT_80[] = {0x00, 0x0A, 0x00, 0x00, 0x00, 80, 0x00, 0x00, 0x00, 0x00};
+static const uint8_t REPORT_40[] = {0x00, 0x0A, 0x00, 0x00, 0x00, 40, 0x00, 0x00, 0x00, 0x00};
+
+TEST(RxDedupeTest, CopiesDroppedDistinctPacketsKept) {
+    RxDedupe dedupe;
+    EXPECT_TRUE(dedupe.accept(0, DEV, DEV, 0x73, REPORT_80, sizeof(REPORT_80), 1000));
+    EXPECT_FALSE(dedupe.accept(0, DEV, DEV, 0x73, REPORT_80, sizeof(REPORT_80), 1020));
+    EXPECT_FALSE(dedupe.accept(1, DEV, DEV, 0x73, REPORT_80, sizeof(REPORT_80), 1300));
+
+    EXPECT_TRUE(dedupe.accept(0, DEV, DEV, 0x73, REPORT_40, sizeof(REPORT_40), 1030));
+    EXPECT_TRUE(dedupe.accept(0, DEV2, DEV2, 0x73, REPORT_80, sizeof(REPORT_80), 1040));
+    EXPECT_TRUE(dedupe.accept(0, DEV, DEV, 0x74, REPORT_80, sizeof(REPORT_80), 1050));
+
+    EXPECT_EQ(dedupe.duplicates(), 2u);
+    EXPECT_EQ(dedupe.stats_json(),
+              "{\"received\":6,\"duplicates\":2,\"same_link\":1,\"cross_link\":1,\"dup_pct\":33.3}");
+}
+
+TEST(RxDedupeTest, ExpiryMeasuredFromFirstCopy) {
+    RxDedupe dedupe;
+    EXPECT_TRUE(dedupe.accept(0, DEV, DEV, 0x73, REPORT_80, sizeof(REPORT_80), 1000));
+    EXPECT_FALSE(dedupe.accept(0, DEV, DEV, 0x73, REPORT_80, sizeof(REPORT_80), 1150));
+    // A steady stream of copies does not keep suppressing the report
+    EXPECT_TRUE(dedupe.accept(0, DEV, DEV, 0x73, REPORT_80, sizeof(REPORT_80), 1200));
+}
+
+TEST(RxDedupeTest, OldestSlotReusedWhenFull) {
+    RxDedupe dedupe;
+    EXPECT_TRUE(dedupe.accept(0, DEV, DEV, 0x73, REPORT_80, sizeof(REPORT_80), 1000));
+    for (uint16_t i = 0; i < RxDedupe::SLOTS; i++)
+        dedupe.accept(0, 100 + i, 100 + i, 0x73, REPORT_80, sizeof(REPORT_80), 1000);
+    EXPECT_TRUE(dedupe.accept(0, DEV, DEV, 0x73, REPORT_80, sizeof(REPORT_80), 1010));
+}
+
+// --- Hub wiring ---
+
+TEST(RxDedupeHubTest, DuplicateCausesNoPublish) {
+    TestHub hub;
+    hub.setup_light(DEV, 1, "A", false);
+
+    hub.bridge_rx(0, DEV, REPORT_80, sizeof(REPORT_80));
+    hub.flush();
+    size_t publishes = hub.mqtt_publishes.size();
+    size_t events = hub.sse_events.size();
+    EXPECT_GT(publishes, 0u);
+
+    hub.bridge_rx(0, DEV, REPORT_80, sizeof(REPORT_80));
+    hub.bridge_rx(1, DEV, REPORT_80, sizeof(REPORT_80));
+    hub.flush();
+    EXPECT_EQ(hub.mqtt_publishes.size(), publishes);
+    EXPECT_EQ(hub.sse_events.size(), events);
+
+    std::string stats = hub.stats();
+    EXPECT_NE(stats.find("\"rx_duplicates\":2,\"rx_dedupe\":{\"received\":3"), std::string::npos) << stats;
+}
@@ -86,3 +86,43 @@ TEST_F(SseEventTest, StateJsonFormat_WithColorTemp) {
     auto &json = hub.sse_events.back().second;
     EXPECT_NE(json.find("\"color_temp\":3000"), std::string::npos);
 }
+
+// --- Per-tick coalescing ---
+// hub.rx() delivers reports without the per-tick flush the inject helpers do.
+
+TEST(SseCoalesceTest, BrightnessAndColorTempInOneTick_OneEvent) {
+    TestHub hub;
+    hub.db().add_device(DEV_A, 90, "Light A");
+    hub.test_setup();
+
+    const uint8_t dim[] = {0x00, 0x0A, 0x00, 0x00, 0x00, 128, 0x00, 0x00, 0x00, 0x00};
+    const uint8_t ct[] = {0x00, 0x1D, 0x00, 0x00, 0x00, 0x00, 0x0F, 0xA0, 0x00, 0x00, 0x00};
+    hub.rx(DEV_A, dim, sizeof(dim));
+    hub.rx(DEV_A, ct, sizeof(ct));
+    EXPECT_TRUE(hub.sse_events.empty()) << "nothing goes out before the tick ends";
+
+    hub.flush();
+    ASSERT_EQ(hub.sse_events.size(), 1u);
+    EXPECT_NE(hub.sse_events[0].second.find("\"brightness\":128,\"color_temp\":4000"), std::string::npos)
+        << hub.sse_events[0].second;
+}
+
+TEST(SseCoalesceTest, FlushBoundedPerTick) {
+    TestHub hub;
+    const size_t count = TestHub::STATE_FLUSH_MAX + 4;
+    for (uint16_t i = 0; i < count; i++)
+        hub.db().add_device(DEV_A + i, 90, "Light");
+    hub.test_setup();
+
+    const uint8_t dim[] = {0x00, 0x0A, 0x00, 0x00, 0x00, 50, 0x00, 0x00, 0x00, 0x00};
+    for (uint16_t i = 0; i < count; i++)
+        hub.rx(DEV_A + i, dim, sizeof(dim));
+
+    hub.flush();
+    EXPECT_EQ(hub.sse_events.size(), TestHub::STATE_FLUSH_MAX);
+    EXPECT_EQ(hub.dirty(), 4u);
+    hub.flush();
+    EXPECT_EQ(hub.sse_events.size(), count);
+    EXPECT_NE(hub.stats().find("\"pending\":0,\"max_backlog\":20,\"deferred_ticks\":1"), std::string::npos)
+        << hub.stats();
+}
@@ -0,0 +1,153 @@
+// Tests: background state refresh — unknown devices first, then the longest
+// unconfirmed, paced by the read budget / interval, group reads when a whole
+// small group is due, and per-sweep expected vs. received accounting.
+
+#include "mock_hub.h"
+#include "esphome/core/component.h"
+#include <gtest/gtest.h>
+
+using namespace avionmesh;
+
+static constexpr uint8_t DIMMER = 1;      // dimming only
+static constexpr uint8_t DOWNLIGHT = 93;  // dimming + color temp
+
+class StateRefreshTest : public ::testing::Test {
+protected:
+    StateRefresher refresh;
+    DeviceDB db;
+    std::vector<Command> sent;
+
+    void SetUp() override {
+        refresh.set_send_fn([this](const Command &cmd) { sent.push_back(cmd); });
+        refresh.set_interval(60000);
+        refresh.set_budget(2.0f);
+        db.add_device(32900, DIMMER, "A");
+        db.add_device(32901, DIMMER, "B");
+        db.add_device(32902, DIMMER, "C");
+    }
+
+    void run(uint32_t from, uint32_t to, uint32_t step = 50) {
+        for (uint32_t t = from; t <= to; t += step)
+            refresh.poll(db, t);
+    }
+};
+
+TEST_F(StateRefreshTest, UnknownDevicesReadAtBudget) {
+    refresh.start(0);
+    run(0, 1400);
+    // 2 reads/s: t=0, 500, 1000
+    ASSERT_EQ(sent.size(), 3u);
+    EXPECT_EQ(sent[0].dest_id, 32900);
+    EXPECT_EQ(sent[1].dest_id, 32901);
+    EXPECT_EQ(sent[2].dest_id, 32902);
+    EXPECT_EQ(sent[0].payload[0], static_cast<uint8_t>(Verb::Read));
+    EXPECT_EQ(sent[0].payload[1], 0x0A);
+}
+
+TEST_F(StateRefreshTest, ColorCapableDeviceGetsBothReads) {
+    db.add_device(32903, DOWNLIGHT, "D");
+    refresh.on_report(32900, 0);
+    refresh.on_report(32901, 0);
+    refresh.on_report(32902, 0);
+    refresh.start(0);
+    run(0, 100);
+    ASSERT_EQ(sent.size(), 2u);
+    EXPECT_EQ(sent[0].dest_id, 32903);
+    EXPECT_EQ(sent[1].payload[1], 0x1D);
+}
+
+TEST_F(StateRefreshTest, OldestConfirmationReadFirst) {
+    refresh.on_report(32900, 3000);
+    refresh.on_report(32901, 1000);
+    refresh.on_report(32902, 2000);
+    refresh.start(3000);
+    run(3000, 60950);
+    EXPECT_TRUE(sent.empty()) << "nothing is due before the interval";
+
+    // Every read is answered right away
+    for (uint32_t t = 61000; t <= 110000; t += 50) {
+        size_t before = sent.size();
+        refresh.poll(db, t);
+        if (sent.size() > before)
+            refresh.on_report(sent.back().dest_id, t);
+    }
+    ASSERT_EQ(sent.size(), 3u);
+    EXPECT_EQ(sent[0].dest_id, 32901);
+    EXPECT_EQ(sent[1].dest_id, 32902);
+    EXPECT_EQ(sent[2].dest_id, 32900);
+}
+
+TEST_F(StateRefreshTest, SteadyStateReadsSpreadOverInterval) {
+    for (uint16_t id = 32900; id <= 32902; id++)
+        refresh.on_report(id, 0);
+    refresh.start(0);
+    run(60000, 60000 + 19999);
+    EXPECT_EQ(sent.size(), 1u) << "60 s / 3 devices = one read per 20 s";
+    run(60000 + 20000, 60000 + 20000);
+    EXPECT_EQ(sent.size(), 2u);
+}
+
+TEST_F(StateRefreshTest, SmallGroupReadInOnePacket) {
+    db.add_group(256, "Room");
+    db.add_device_to_group(32900, 256);
+    db.add_device_to_group(32901, 256);
+    // Entries exist once devices have been seen by a poll
+    refresh.start(0);
+    refresh.poll(db, 0);
+    ASSERT_EQ(sent.size(), 1u);
+    EXPECT_EQ(sent[0].dest_id, 256);
+    EXPECT_NE(refresh.stats_json().find("\"group_reads\":1"), std::string::npos);
+
+    run(500, 1000);
+    ASSERT_EQ(sent.size(), 2u);
+    EXPECT_EQ(sent[1].dest_id, 32902) << "members already read this sweep";
+}
+
+TEST_F(StateRefreshTest, SweepCountsExpectedAndReceived) {
+    refresh.start(0);
+    run(0, 1000);
+    ASSERT_EQ(sent.size(), 3u);
+    refresh.on_report(32900, 1100);
+    refresh.on_report(32902, 1200);
+
+    // 32901 stays silent; it is not read again until the next sweep
+    run(1050, 59950);
+    EXPECT_EQ(sent.size(), 3u);
+
+    refresh.poll(db, 60000);
+    std::string stats = refresh.stats_json();
+    EXPECT_NE(stats.find("\"sweeps\":1,\"last_expected\":3,\"last_received\":2"), std::string::npos)
+        << stats;
+    ASSERT_EQ(sent.size(), 4u);
+    EXPECT_EQ(sent[3].dest_id, 32901);
+}
+
+TEST_F(StateRefreshTest, ExpireAllRereadsAtBudget) {
+    for (uint16_t id = 32900; id <= 32902; id++)
+        refresh.on_report(id, 0);
+    refresh.start(0);
+    refresh.expire_all();
+    run(100, 1200);
+    EXPECT_EQ(sent.size(), 3u);
+}
+
+// --- Hub wiring ---
+
+TEST(StateRefreshHubTest, ReportsConfirmAndDisconnectForgets) {
+    TestHub hub;
+    hub.setup_light(32900, DIMMER, "A");
+    hub.refresh().start(1000);
+
+    hub.loop();
+    ASSERT_EQ(hub.mesh_sends.size(), 1u);
+    EXPECT_EQ(hub.mesh_sends[0].dest_id, 32900);
+
+    hub.inject_brightness(32900, 40);
+    esphome::set_test_millis(5000);
+    hub.loop();
+    EXPECT_EQ(hub.mesh_sends.size(), 1u);
+    EXPECT_NE(hub.stats().find("\"refresh\":{"), std::string::npos);
+
+    hub.disconnect(1);
+    EXPECT_FALSE(hub.refresh().running());
+}
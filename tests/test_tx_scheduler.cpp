@@ -0,0 +1,217 @@
+// Tests: MeshTxScheduler priority classes, background pacing and counters.
+
+#include "mock_hub.h"
+#include "mesh_tx.h"
+#include "esphome/core/component.h"
+#include <gtest/gtest.h>
+
+using namespace avionmesh;
+
+static constexpr uint16_t DEV = 32900;
+
+class TxSchedulerTest : public ::testing::Test {
+protected:
+    MeshTxScheduler tx;
+    std::vector<Command> sent;
+
+    void SetUp() override {
+        tx.set_send_fn([this](const Command &cmd) { sent.push_back(cmd); });
+    }
+};
+
+TEST_F(TxSchedulerTest, InteractiveSendsImmediately) {
+    Command cmd;
+    cmd_brightness(DEV, 10, cmd);
+    tx.enqueue(cmd, TxClass::Interactive, 1000);
+    ASSERT_EQ(sent.size(), 1u);
+    EXPECT_EQ(tx.stats(TxClass::Interactive).max_wait_ms, 0u);
+}
+
+TEST_F(TxSchedulerTest, BackgroundWaitsForPoll) {
+    Command cmd;
+    cmd_read_all_dimming(cmd);
+    tx.enqueue(cmd, TxClass::StateRead, 1000);
+    EXPECT_TRUE(sent.empty());
+    EXPECT_EQ(tx.depth(TxClass::StateRead), 1u);
+
+    tx.poll(1000);
+    EXPECT_EQ(sent.size(), 1u);
+    EXPECT_EQ(tx.depth(TxClass::StateRead), 0u);
+}
+
+TEST_F(TxSchedulerTest, InteractiveOvertakesQueuedBackground) {
+    Command grp;
+    for (uint16_t i = 0; i < 5; i++) {
+        cmd_insert_group(DEV + i, 1024, grp);
+        tx.enqueue(grp, TxClass::Provisioning, 1000);
+    }
+    tx.poll(1000);
+    ASSERT_EQ(sent.size(), 1u);
+
+    // User presses a switch while four group edits are still waiting
+    Command on;
+    cmd_brightness(DEV, 255, on);
+    tx.enqueue(on, TxClass::Interactive, 1010);
+    ASSERT_EQ(sent.size(), 2u);
+    EXPECT_EQ(sent[1].payload[5], 255);
+    EXPECT_EQ(tx.depth(TxClass::Provisioning), 4u);
+}
+
+TEST_F(TxSchedulerTest, ProvisioningNeverDropped) {
+    // An import of 300 lights in 3 groups each: 900 inserts, all already in the DB
+    Command grp;
+    for (uint16_t i = 0; i < 900; i++) {
+        cmd_insert_group(DEV + i / 3, 1024 + i % 3, grp);
+        tx.enqueue(grp, TxClass::Provisioning, 1000);
+    }
+    EXPECT_EQ(tx.depth(TxClass::Provisioning), 900u);
+    for (uint32_t t = 0; t < 900; t++)
+        tx.poll(1000 + t * MeshTxScheduler::BACKGROUND_SPACING_MS);
+
+    ASSERT_EQ(sent.size(), 900u);
+    EXPECT_EQ(tx.stats(TxClass::Provisioning).dropped, 0u);
+    cmd_insert_group(DEV, 1024, grp);
+    EXPECT_EQ(std::memcmp(sent.front().payload, grp.payload, sizeof(grp.payload)), 0) << "first insert sent";
+    cmd_insert_group(DEV + 299, 1026, grp);
+    EXPECT_EQ(std::memcmp(sent.back().payload, grp.payload, sizeof(grp.payload)), 0);
+}
+
+TEST_F(TxSchedulerTest, BackgroundPacedAndHigherClassFirst) {
+    Command sync;
+    cmd_set_time(12, 0, 0, sync);
+    tx.enqueue(sync, TxClass::Housekeeping, 1000);
+    Command grp;
+    cmd_insert_group(DEV, 1024, grp);
+    tx.enqueue(grp, TxClass::Provisioning, 1000);
+    Command read;
+    cmd_read_all_dimming(read);
+    tx.enqueue(read, TxClass::StateRead, 1000);
+
+    tx.poll(1000);
+    tx.poll(1000 + MeshTxScheduler::BACKGROUND_SPACING_MS - 1);
+    ASSERT_EQ(sent.size(), 1u) << "background must respect the spacing gate";
+    EXPECT_EQ(sent[0].payload[1], read.payload[1]);
+
+    tx.poll(1000 + MeshTxScheduler::BACKGROUND_SPACING_MS);
+    ASSERT_EQ(sent.size(), 2u);
+    EXPECT_EQ(sent[1].dest_id, DEV);
+
+    tx.poll(1000 + 2 * MeshTxScheduler::BACKGROUND_SPACING_MS);
+    ASSERT_EQ(sent.size(), 3u);
+    EXPECT_EQ(tx.stats(TxClass::Housekeeping).max_wait_ms,
+              2 * MeshTxScheduler::BACKGROUND_SPACING_MS);
+}
+
+TEST_F(TxSchedulerTest, DuplicateReadsCollapse) {
+    Command read;
+    cmd_read_all_dimming(read);
+    tx.enqueue(read, TxClass::StateRead, 1000);
+    tx.enqueue(read, TxClass::StateRead, 1001);
+    EXPECT_EQ(tx.depth(TxClass::StateRead), 1u);
+}
+
+TEST_F(TxSchedulerTest, HeldWritesCoalescePerTargetAndAttribute) {
+    bool ready = false;
+    tx.set_ready_fn([&ready]() { return ready; });
+    Command cmd;
+    cmd_brightness(DEV, 0, cmd);  // OFF for one light
+    tx.enqueue(cmd, TxClass::Interactive, 1000);
+    for (uint8_t v = 1; v <= 20; v++) {
+        cmd_brightness(DEV + 1, v, cmd);  // slider on another
+        tx.enqueue(cmd, TxClass::Interactive, 1000);
+    }
+    cmd_color_temp(DEV + 1, 3000, cmd);
+    tx.enqueue(cmd, TxClass::Interactive, 1000);
+    EXPECT_EQ(tx.depth(TxClass::Interactive), 3u);
+    EXPECT_EQ(tx.stats(TxClass::Interactive).coalesced, 19u);
+
+    ready = true;
+    tx.poll(1100);
+    ASSERT_EQ(sent.size(), 3u);
+    EXPECT_EQ(sent[0].dest_id, DEV);
+    EXPECT_EQ(sent[0].payload[5], 0);
+    EXPECT_EQ(sent[1].payload[5], 20) << "latest slider value, in the first one's place";
+}
+
+TEST_F(TxSchedulerTest, FullInteractiveQueueRefusesNewTargets) {
+    tx.set_ready_fn([]() { return false; });
+    Command cmd;
+    for (uint16_t i = 0; i < 70; i++) {
+        cmd_brightness(DEV + i, 0, cmd);
+        tx.enqueue(cmd, TxClass::Interactive, 1000);
+    }
+    EXPECT_EQ(tx.depth(TxClass::Interactive), 64u);
+    EXPECT_EQ(tx.stats(TxClass::Interactive).dropped, 6u);
+
+    tx.set_ready_fn(nullptr);
+    tx.poll(1100);
+    ASSERT_EQ(sent.size(), 64u);
+    EXPECT_EQ(sent.front().dest_id, DEV) << "the oldest queued OFF is kept";
+}
+
+TEST_F(TxSchedulerTest, StatsJsonReportsEveryClass) {
+    std::string json = tx.stats_json();
+    for (auto *name : {"interactive", "state_read", "provisioning", "housekeeping"})
+        EXPECT_NE(json.find(name), std::string::npos) << name;
+}
+
+// Hub level: a group edit queued behind a light switch press
+TEST(TxSchedulerHub, SwitchPressNotBlockedByGroupEdits) {
+    TestHub hub;
+    hub.db().add_device(DEV, 90, "Light");
+    hub.db().find_device(DEV)->mqtt_exposed = true;
+    hub.db().add_group(1024, "G");
+    hub.test_setup();
+    esphome::set_test_millis(1000);
+
+    DeferredAction act;
+    act.type = DeferredAction::AddToGroup;
+    act.id1 = DEV;
+    act.id2 = 1024;
+    hub.push_action(act);
+    EXPECT_TRUE(hub.mesh_sends.empty()) << "group edit must wait for the scheduler";
+
+    hub.inject_mqtt("avionmesh/light/" + std::to_string(DEV) + "/set", "ON");
+    ASSERT_EQ(hub.mesh_sends.size(), 1u);
+    EXPECT_EQ(hub.mesh_sends[0].payload[1], 0x0A);
+
+    hub.loop();
+    EXPECT_EQ(hub.mesh_sends.size(), 1u);
+    esphome::set_test_millis(1000 + MeshTxScheduler::BACKGROUND_SPACING_MS);
+    hub.loop();
+    EXPECT_EQ(hub.mesh_sends.size(), 2u);
+}
+
+// Hub level: group edits queued across a link drop go out once a bridge is back
+TEST(TxSchedulerHub, ProvisioningHeldWhileNoBridgeReady) {
+    TestHub hub;
+    hub.send_without_link = false;
+    hub.setup_light(DEV, 90, "Light");
+    hub.disconnect(1);
+    for (uint16_t g = 1024; g < 1034; g++) {
+        Command cmd;
+        cmd_insert_group(DEV, g, cmd);
+        hub.queue(cmd, TxClass::Provisioning);
+    }
+    for (uint32_t t = 1000; t <= 4000; t += 50) {
+        esphome::set_test_millis(t);
+        hub.loop();
+    }
+    EXPECT_TRUE(hub.mesh_sends.empty());
+    EXPECT_NE(hub.stats().find("\"provisioning\":{\"depth\":10,"), std::string::npos) << hub.stats();
+
+    hub.bring_up_bridge(0, 2);
+    for (uint32_t t = 4000; t <= 8000; t += 50) {
+        esphome::set_test_millis(t);
+        hub.loop();
+    }
+    size_t edits = 0;
+    for (uint16_t g = 1024; g < 1034; g++) {
+        Command expect;
+        cmd_insert_group(DEV, g, expect);
+        for (auto &sent : hub.mesh_sends)
+            if (std::memcmp(sent.payload, expect.payload, sizeof(expect.payload)) == 0)
+                edits++;
+    }
+    EXPECT_EQ(edits, 10u);
+}